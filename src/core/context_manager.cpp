@@ -2,11 +2,14 @@
 #include "context_manager.h"
 #include "../utils/config.h"
 #include "../scanner/scanner.h"
+#include "../scanner/index_file.h"
 #include "../utils/logger.h"
 #include <algorithm>
 #include <fstream>
 #include <sstream>
 #include <filesystem>
+#include <mutex>
+#include <unordered_set>
 
 namespace fs = std::filesystem;
 
@@ -15,6 +18,11 @@ namespace core {
 
 ContextManager::ContextManager(std::shared_ptr<utils::Config> config)
     : config_(config),
+      generation_(0),
+      partial_(false),
+      filesProcessed_(0),
+      filesEstimated_(0),
+      listed_(false),
       maxContextSize_(8192),
       maxHistoryEntries_(10) {
     // Load configuration values
@@ -30,17 +38,26 @@ ContextManager::~ContextManager() {
 }
 
 bool ContextManager::initialize(const scanner::IndexedCode& indexedCode) {
+    std::unique_lock<std::shared_mutex> lock(indexMutex_);
     try {
-        // Store indexed files
+        // Store indexed files; only the blob pointers are copied, and bodies
+        // are loaded from the store when a query needs them
         files_ = indexedCode.files;
+        contents_ = indexedCode.contents;
         
         // Store symbol information
-        symbols_ = indexedCode.symbols;
+        symbols_ = std::make_shared<const scanner::SymbolIndex>(indexedCode.symbols);
+        symbolRuns_.clear();
+        indexFile_.reset();
+        generation_++;
+        partial_ = false;
+        parseFile_ = nullptr;
+        prioritize_ = nullptr;
         
         utils::Logger::log(utils::LogLevel::INFO, 
             "ContextManager: Initialized with " + 
             std::to_string(files_.size()) + " files and " + 
-            std::to_string(symbols_.size()) + " symbols");
+            std::to_string(symbols_->getNameCount()) + " symbols");
         
         return true;
     } catch (const std::exception& e) {
@@ -51,6 +68,122 @@ bool ContextManager::initialize(const scanner::IndexedCode& indexedCode) {
     }
 }
 
+bool ContextManager::initialize(std::shared_ptr<const scanner::IndexFile> indexFile) {
+    if (!indexFile) {
+        return false;
+    }
+    
+    std::unique_lock<std::shared_mutex> lock(indexMutex_);
+    files_.clear();
+    contents_.reset();
+    symbols_.reset();
+    symbolRuns_.clear();
+    indexFile_ = std::move(indexFile);
+    generation_++;
+    partial_ = false;
+    parseFile_ = nullptr;
+    prioritize_ = nullptr;
+    
+    utils::Logger::log(utils::LogLevel::INFO, 
+        "ContextManager: Initialized from saved index with " + 
+        std::to_string(indexFile_->getFileCount()) + " files and " + 
+        std::to_string(indexFile_->getNameCount()) + " symbols");
+    return true;
+}
+
+void ContextManager::beginPartial(ParseCallback parseFile, PrioritizeCallback prioritize) {
+    std::unique_lock<std::shared_mutex> lock(indexMutex_);
+    files_.clear();
+    contents_.reset();
+    symbols_ = std::make_shared<const scanner::SymbolIndex>();
+    symbolRuns_.clear();
+    indexFile_.reset();
+    generation_++;
+    partial_ = true;
+    filesProcessed_ = 0;
+    filesEstimated_ = 0;
+    listed_ = false;
+    parseFile_ = std::move(parseFile);
+    prioritize_ = std::move(prioritize);
+}
+
+void ContextManager::addFiles(const std::vector<scanner::ScanBatch>& batches) {
+    std::vector<SymbolRun> runs;
+    {
+        std::shared_lock<std::shared_mutex> lock(indexMutex_);
+        if (!partial_) {
+            return;
+        }
+        runs = symbolRuns_;
+    }
+    
+    // The batches become a run of their own, built while queries keep using
+    // the current runs; only this thread replaces them. A run is merged into
+    // the one before it once it is half that size, so over a scan each pair
+    // is sorted O(log n) times, and lookups consult O(log n) runs.
+    auto symbols = std::make_shared<scanner::SymbolIndex>();
+    for (const auto& batch : batches) {
+        symbols->append(batch.symbols);
+    }
+    symbols->build();
+    runs.push_back({symbols, symbols->getByteSize()});
+    while (runs.size() > 1 && runs.back().byteSize * 2 >= runs[runs.size() - 2].byteSize) {
+        auto merged = std::make_shared<scanner::SymbolIndex>(*runs[runs.size() - 2].symbols);
+        merged->append(*runs.back().symbols);
+        merged->build();
+        runs.pop_back();
+        runs.back() = {merged, merged->getByteSize()};
+    }
+    
+    std::unique_lock<std::shared_mutex> lock(indexMutex_);
+    if (!partial_) {
+        return;
+    }
+    for (const auto& batch : batches) {
+        for (const auto& file : batch.files) {
+            // A listed file's blob arrives in a later batch, or from parseFile_
+            auto& blob = files_[file.first];
+            if (file.second) {
+                blob = file.second;
+            } else if (!blob) {
+                listed_ = true;
+            }
+        }
+        contents_ = batch.contents;
+        filesProcessed_ = std::max(filesProcessed_, batch.filesProcessed);
+        filesEstimated_ = std::max(filesEstimated_, batch.filesEstimated);
+    }
+    filesEstimated_ = std::max(filesEstimated_, filesProcessed_);
+    symbolRuns_ = std::move(runs);
+    
+    utils::Logger::log(utils::LogLevel::DEBUG, 
+        "ContextManager: Scan in progress; now " + 
+        std::to_string(files_.size()) + " files, symbols in " + 
+        std::to_string(symbolRuns_.size()) + " runs");
+}
+
+void ContextManager::updateFiles(const scanner::IndexedCode& indexedCode, const std::vector<std::string>& filePaths) {
+    std::unique_lock<std::shared_mutex> lock(indexMutex_);
+    
+    for (const auto& filePath : filePaths) {
+        auto file = indexedCode.files.find(filePath);
+        if (file != indexedCode.files.end()) {
+            files_[filePath] = file->second;
+        } else {
+            files_.erase(filePath);
+        }
+    }
+    contents_ = indexedCode.contents;
+    
+    // Symbol names can move between files, so take the whole index
+    symbols_ = std::make_shared<const scanner::SymbolIndex>(indexedCode.symbols);
+    
+    utils::Logger::log(utils::LogLevel::DEBUG, 
+        "ContextManager: Updated " + std::to_string(filePaths.size()) + " files; now " + 
+        std::to_string(files_.size()) + " files and " + 
+        std::to_string(symbols_->getNameCount()) + " symbols");
+}
+
 std::string ContextManager::buildContext(const std::string& query) {
     std::stringstream context;
     
@@ -65,20 +198,51 @@ std::string ContextManager::buildContext(const std::string& query) {
     context << "### Current Query ###\n";
     context << query << "\n\n";
     
+    std::shared_lock<std::shared_mutex> lock(indexMutex_);
+    
     // Find relevant symbols for the query
     std::vector<std::string> relevantSymbols = findRelevantSymbols(query);
     
     // Get relevant files based on symbols
-    std::vector<std::string> relevantFiles = getRelevantFiles(query);
+    std::vector<std::string> relevantFiles = collectRelevantFiles(query, 5);
+    
+    // Whatever sits next to them is likely wanted by the next query
+    if (partial_ && prioritize_ && !relevantFiles.empty()) {
+        std::vector<std::string> directories;
+        for (const auto& filePath : relevantFiles) {
+            std::string directory = fs::path(filePath).parent_path().string();
+            if (std::find(directories.begin(), directories.end(), directory) == directories.end()) {
+                directories.push_back(directory);
+            }
+        }
+        prioritize_(directories);
+    }
+    lock.unlock();
+    
+    // Files listed but not parsed yet are parsed before their content is read
+    parseListedFiles(relevantFiles);
+    lock.lock();
     
     // Add relevant code files to context
     context << "### Relevant Code ###\n";
+    if (partial_ && listed_) {
+        context << "(The codebase is still being indexed: " << filesProcessed_ << " of " << filesEstimated_ << 
+                   " files are parsed; symbols of the others are not searched yet.)\n\n";
+    } else if (partial_ && filesProcessed_ == 0) {
+        context << "(The codebase is still being indexed; no files are covered yet.)\n\n";
+    } else if (partial_) {
+        context << "(The codebase is still being indexed: these results cover " << filesProcessed_ << 
+                   " of about " << filesEstimated_ << " files.)\n\n";
+    }
     for (const auto& filePath : relevantFiles) {
-        if (files_.find(filePath) != files_.end()) {
+        std::string_view content;
+        std::shared_ptr<const scanner::FileBody> body;
+        if (findFileContent(filePath, content, body)) {
             context << "File: " << filePath << "\n";
-            context << "```\n" << files_[filePath] << "\n```\n\n";
+            context << "```\n" << content << "\n```\n\n";
         }
     }
+    lock.unlock();
     
     // Ensure context fits within token limits (rough approximation)
     std::string result = context.str();
@@ -94,15 +258,33 @@ std::string ContextManager::buildContext(const std::string& query) {
     return result;
 }
 
-std::string ContextManager::getFile(const std::string& filePath) const {
-    auto it = files_.find(filePath);
-    if (it != files_.end()) {
-        return it->second;
+std::string ContextManager::getFile(const std::string& filePath) {
+    parseListedFiles({filePath});
+    
+    std::shared_lock<std::shared_mutex> lock(indexMutex_);
+    std::string_view content;
+    std::shared_ptr<const scanner::FileBody> body;
+    if (findFileContent(filePath, content, body)) {
+        return std::string(content);
     }
     return "";
 }
 
+bool ContextManager::hasFile(const std::string& filePath) const {
+    std::shared_lock<std::shared_mutex> lock(indexMutex_);
+    if (indexFile_) {
+        uint32_t file = 0;
+        return indexFile_->findFile(filePath, file);
+    }
+    return files_.find(filePath) != files_.end();
+}
+
 std::vector<std::string> ContextManager::getRelevantFiles(const std::string& query, int maxFiles) const {
+    std::shared_lock<std::shared_mutex> lock(indexMutex_);
+    return collectRelevantFiles(query, maxFiles);
+}
+
+std::vector<std::string> ContextManager::collectRelevantFiles(const std::string& query, int maxFiles) const {
     // This is a simple implementation that will be improved later with better relevance scoring
     std::vector<std::string> relevantFiles;
     
@@ -134,25 +316,37 @@ std::vector<std::string> ContextManager::getRelevantFiles(const std::string& que
         }
         
         // Check files for relevance
-        for (const auto& filePair : files_) {
+        auto checkFile = [&](const std::string& filePath) {
             // Skip files already included
-            if (std::find(relevantFiles.begin(), relevantFiles.end(), filePair.first) != relevantFiles.end()) {
-                continue;
+            if (std::find(relevantFiles.begin(), relevantFiles.end(), filePath) != relevantFiles.end()) {
+                return true;
             }
             
             // Check if filename contains any query terms
-            std::string filename = fs::path(filePair.first).filename().string();
+            std::string filename = fs::path(filePath).filename().string();
             std::transform(filename.begin(), filename.end(), filename.begin(), ::tolower);
             
             for (const auto& term : queryTerms) {
                 if (filename.find(term) != std::string::npos) {
-                    relevantFiles.push_back(filePair.first);
+                    relevantFiles.push_back(filePath);
                     break;
                 }
             }
             
-            if (relevantFiles.size() >= static_cast<size_t>(maxFiles)) {
-                break;
+            return relevantFiles.size() < static_cast<size_t>(maxFiles);
+        };
+        
+        if (indexFile_) {
+            for (uint32_t i = 0; i < indexFile_->getFileCount(); i++) {
+                if (!checkFile(std::string(indexFile_->getFilePath(i)))) {
+                    break;
+                }
+            }
+        } else {
+            for (const auto& filePair : files_) {
+                if (!checkFile(filePair.first)) {
+                    break;
+                }
             }
         }
     }
@@ -200,55 +394,189 @@ std::vector<std::string> ContextManager::findRelevantSymbols(const std::string&
     }
     
     // Find symbols that match query terms
-    for (const auto& symbolPair : symbols_) {
-        std::string symbolLower = symbolPair.first;
+    auto checkSymbol = [&](std::string_view symbol) {
+        std::string symbolLower(symbol);
         std::transform(symbolLower.begin(), symbolLower.end(), symbolLower.begin(), ::tolower);
         
         for (const auto& term : queryTerms) {
             if (symbolLower.find(term) != std::string::npos) {
-                relevantSymbols.push_back(symbolPair.first);
+                relevantSymbols.emplace_back(symbol);
                 break;
             }
         }
+    };
+    
+    if (indexFile_) {
+        for (uint32_t i = 0; i < indexFile_->getNameCount(); i++) {
+            checkSymbol(indexFile_->getName(i));
+        }
+    } else if (symbols_) {
+        for (uint32_t i = 0; i < symbols_->getNameCount(); i++) {
+            checkSymbol(symbols_->getName(i));
+        }
+    }
+    
+    // A name can be in several runs of a scan in progress; report it once
+    std::unordered_set<std::string_view> seen;
+    for (const auto& run : symbolRuns_) {
+        for (uint32_t i = 0; i < run.symbols->getNameCount(); i++) {
+            std::string_view name = run.symbols->getName(i);
+            if (seen.insert(name).second) {
+                checkSymbol(name);
+            }
+        }
     }
     
     return relevantSymbols;
 }
 
 std::string ContextManager::findFileContainingSymbol(const std::string& symbol) const {
-    auto it = symbols_.find(symbol);
-    if (it != symbols_.end() && !it->second.empty()) {
-        return it->second[0];  // Return the first file containing this symbol
+    if (indexFile_) {
+        uint32_t nameId = 0;
+        size_t fileCount = 0;
+        if (indexFile_->findName(symbol, nameId)) {
+            const uint32_t* files = indexFile_->getNameFiles(nameId, fileCount);
+            if (fileCount > 0) {
+                return std::string(indexFile_->getFilePath(files[0]));
+            }
+        }
+        return "";
+    }
+    
+    // Return the first file containing this symbol; lists never hold zero
+    // files, and older runs hold files the scan indexed earlier
+    uint32_t nameId = 0;
+    if (symbols_ && symbols_->findName(symbol, nameId)) {
+        return std::string(symbols_->getFilePath(symbols_->getFirstFile(nameId)));
+    }
+    for (const auto& run : symbolRuns_) {
+        if (run.symbols->findName(symbol, nameId)) {
+            return std::string(run.symbols->getFilePath(run.symbols->getFirstFile(nameId)));
+        }
     }
     return "";
 }
 
-std::string ContextManager::formatCodeSnippet(const std::string& filePath, int startLine, int endLine) const {
-    std::string fileContent = getFile(filePath);
-    if (fileContent.empty()) {
-        return "";
+void ContextManager::parseListedFiles(const std::vector<std::string>& filePaths) {
+    ParseCallback parseFile;
+    size_t generation = 0;
+    std::vector<std::string> pending;
+    {
+        std::shared_lock<std::shared_mutex> lock(indexMutex_);
+        if (!partial_ || !listed_ || !parseFile_) {
+            return;
+        }
+        for (const auto& filePath : filePaths) {
+            auto it = files_.find(filePath);
+            if (it != files_.end() && !it->second) {
+                pending.push_back(filePath);
+            }
+        }
+        parseFile = parseFile_;
+        generation = generation_;
     }
     
-    // Split into lines
-    std::istringstream iss(fileContent);
-    std::vector<std::string> lines;
-    std::string line;
-    while (std::getline(iss, line)) {
-        lines.push_back(line);
+    // The parse waits on the scan, whose batches need the lock exclusively
+    std::vector<std::pair<std::string, std::shared_ptr<const scanner::FileBlob>>> parsed;
+    for (const auto& filePath : pending) {
+        auto blob = parseFile(filePath);
+        if (blob) {
+            parsed.emplace_back(filePath, std::move(blob));
+        }
+    }
+    if (parsed.empty()) {
+        return;
     }
     
+    // Keep them for later queries, unless the scan's data was replaced meanwhile
+    std::unique_lock<std::shared_mutex> lock(indexMutex_);
+    if (generation_ != generation) {
+        return;
+    }
+    for (auto& file : parsed) {
+        auto it = files_.find(file.first);
+        if (it != files_.end() && !it->second) {
+            it->second = std::move(file.second);
+        }
+    }
+}
+
+std::shared_ptr<const scanner::FileBlob> ContextManager::findBlob(const std::string& filePath) const {
+    auto it = files_.find(filePath);
+    if (it == files_.end()) {
+        return nullptr;
+    }
+    return it->second;
+}
+
+bool ContextManager::findFileContent(const std::string& filePath, 
+                                     std::string_view& content, 
+                                     std::shared_ptr<const scanner::FileBody>& body) const {
+    if (indexFile_) {
+        uint32_t file = 0;
+        if (!indexFile_->findFile(filePath, file)) {
+            return false;
+        }
+        body = indexFile_->loadFileContent(file);
+        if (!body) {
+            return false;
+        }
+        content = body->content;
+        return true;
+    }
+    
+    auto blob = findBlob(filePath);
+    if (!blob || !contents_) {
+        return false;
+    }
+    body = contents_->get(filePath, blob);
+    if (!body) {
+        return false;
+    }
+    content = body->content;
+    return true;
+}
+
+std::string ContextManager::formatCodeSnippet(const std::string& filePath, int startLine, int endLine) const {
     // Validate line numbers
     if (startLine < 0) startLine = 0;
-    if (endLine >= static_cast<int>(lines.size())) endLine = lines.size() - 1;
+    if (startLine > endLine) return "";
+    
+    // The content store copies just the lines, decompressing only their blocks
+    if (!indexFile_) {
+        auto blob = findBlob(filePath);
+        std::string snippet;
+        if (!blob || !contents_ ||
+            !contents_->getLines(filePath, blob, startLine, endLine, snippet)) {
+            return "";
+        }
+        return snippet;
+    }
+    
+    std::string_view fileContent;
+    std::shared_ptr<const scanner::FileBody> body;
+    if (!findFileContent(filePath, fileContent, body) || fileContent.empty()) {
+        return "";
+    }
+    const scanner::LineIndex& lines = body->lines;
+    
+    // A trailing newline does not start another line
+    int lineCount = static_cast<int>(lines.lineCount());
+    if (lines.lineStart(lineCount - 1) == fileContent.size()) {
+        lineCount--;
+    }
+    if (endLine >= lineCount) endLine = lineCount - 1;
     if (startLine > endLine) return "";
     
     // Extract the snippet
-    std::stringstream snippet;
+    std::string snippet;
     for (int i = startLine; i <= endLine; i++) {
-        snippet << lines[i] << "\n";
+        size_t begin = lines.lineStart(i);
+        snippet.append(fileContent, begin, lines.lineEnd(i) - begin);
+        snippet += '\n';
     }
     
-    return snippet.str();
+    return snippet;
 }
 
 }} // namespace codelve::core
\ No newline at end of file
@@ -2,9 +2,12 @@
 #pragma once
 
 #include <string>
+#include <string_view>
 #include <vector>
 #include <memory>
 #include <unordered_map>
+#include <shared_mutex>
+#include <functional>
 
 namespace codelve {
 
@@ -15,6 +18,12 @@ namespace utils {
 
 namespace scanner {
     struct IndexedCode;
+    struct ScanBatch;
+    struct FileBlob;
+    struct FileBody;
+    class ContentStore;
+    class SymbolIndex;
+    class IndexFile;
 }
 
 namespace core {
@@ -25,6 +34,19 @@ namespace core {
  */
 class ContextManager {
 public:
+    /**
+     * Parses a file of the scan in progress that is known only by name.
+     * @param filePath Path of the file
+     * @return The file's blob, or null if it cannot be had
+     */
+    using ParseCallback = std::function<std::shared_ptr<const scanner::FileBlob>(const std::string& filePath)>;
+    
+    /**
+     * Asks the scan in progress to parse some files or directories first.
+     * @param paths Files or directories, the most wanted first
+     */
+    using PrioritizeCallback = std::function<void(const std::vector<std::string>& paths)>;
+    
     /**
      * Constructor.
      * @param config Shared pointer to configuration
@@ -43,6 +65,41 @@ public:
      */
     bool initialize(const scanner::IndexedCode& indexedCode);
     
+    /**
+     * Initialize with an index saved by an earlier session. Queries read it
+     * in place until initialize() is called with a fresh scan.
+     * @param indexFile The opened index file
+     * @return true if initialization was successful, false otherwise
+     */
+    bool initialize(std::shared_ptr<const scanner::IndexFile> indexFile);
+    
+    /**
+     * Start answering queries from the batches of a scan in progress,
+     * dropping the index held so far. Until initialize() is called with the
+     * finished scan, built contexts note that they cover part of the tree.
+     * Files a batch lists without a blob are parsed through parseFile when
+     * a query needs their contents, and the directories of the files a
+     * query picks are passed to prioritize.
+     * @param parseFile Parses a listed file on demand (may be null)
+     * @param prioritize Reorders the scan's remaining work (may be null)
+     */
+    void beginPartial(ParseCallback parseFile = nullptr, PrioritizeCallback prioritize = nullptr);
+    
+    /**
+     * Add files published by the scan in progress. Called from one thread
+     * at a time; batches arriving after initialize() are ignored.
+     * @param batches Batches from the scanner, in any order
+     */
+    void addFiles(const std::vector<scanner::ScanBatch>& batches);
+    
+    /**
+     * Replace the indexed data of some files after a live update. Queries
+     * see either the old or the new state of all of them, never a mix.
+     * @param indexedCode The updated indexed code
+     * @param filePaths Files that changed; those no longer in indexedCode are dropped
+     */
+    void updateFiles(const scanner::IndexedCode& indexedCode, const std::vector<std::string>& filePaths);
+    
     /**
      * Build context for a specific query.
      * @param query The natural language query
@@ -51,11 +108,20 @@ public:
     std::string buildContext(const std::string& query);
     
     /**
-     * Get a specific file from the codebase.
+     * Get a specific file from the codebase. A file the scan in progress
+     * has listed but not parsed yet is parsed first.
      * @param filePath Path to the file
      * @return File content or empty string if not found
      */
-    std::string getFile(const std::string& filePath) const;
+    std::string getFile(const std::string& filePath);
+    
+    /**
+     * Check whether a file is in the codebase, including files the scan in
+     * progress has listed but not parsed yet.
+     * @param filePath Path to the file
+     * @return True if the file is known
+     */
+    bool hasFile(const std::string& filePath) const;
     
     /**
      * Get relevant files for a query.
@@ -87,9 +153,40 @@ private:
     // Configuration
     std::shared_ptr<utils::Config> config_;
     
-    // Indexed code data
-    std::unordered_map<std::string, std::string> files_;
-    std::unordered_map<std::string, std::vector<std::string>> symbols_;
+    // Indexed code data; file blobs are shared with the scanner's index,
+    // and their bodies come from its content store
+    std::unordered_map<std::string, std::shared_ptr<const scanner::FileBlob>> files_;
+    std::shared_ptr<scanner::ContentStore> contents_;
+    std::shared_ptr<const scanner::SymbolIndex> symbols_;
+    
+    // Symbols of a scan in progress, in runs of decreasing size that
+    // lookups consult in addition to symbols_ (see addFiles)
+    struct SymbolRun {
+        std::shared_ptr<const scanner::SymbolIndex> symbols;
+        size_t byteSize;
+    };
+    std::vector<SymbolRun> symbolRuns_;
+    
+    // Saved index answering queries in place of the maps above, if set
+    std::shared_ptr<const scanner::IndexFile> indexFile_;
+    
+    // Counts replacements of the data above, so that work done without
+    // the lock can tell whether its results still apply
+    size_t generation_;
+    
+    // Set while a scan is still adding files, with how far it has got
+    bool partial_;
+    size_t filesProcessed_;
+    size_t filesEstimated_;
+    
+    // Set if the scan in progress listed its files before parsing them;
+    // those not parsed yet have null blobs
+    bool listed_;
+    ParseCallback parseFile_;
+    PrioritizeCallback prioritize_;
+    
+    // Guards the indexed code data; queries share it, updates take it exclusively
+    mutable std::shared_mutex indexMutex_;
     
     // Conversation history
     std::vector<std::pair<std::string, std::string>> history_;
@@ -100,7 +197,17 @@ private:
     // Maximum history entries
     int maxHistoryEntries_;
     
-    // Methods to find relevant information
+    // Parse files the scan in progress listed but has not parsed, and keep
+    // their blobs; callers do not hold indexMutex_
+    void parseListedFiles(const std::vector<std::string>& filePaths);
+    
+    // Methods to find relevant information; callers hold indexMutex_
+    std::shared_ptr<const scanner::FileBlob> findBlob(const std::string& filePath) const;
+    // The content view stays valid while body is held
+    bool findFileContent(const std::string& filePath, 
+                         std::string_view& content, 
+                         std::shared_ptr<const scanner::FileBody>& body) const;
+    std::vector<std::string> collectRelevantFiles(const std::string& query, int maxFiles) const;
     std::vector<std::string> findRelevantSymbols(const std::string& query) const;
     std::string findFileContainingSymbol(const std::string& symbol) const;
     std::string formatCodeSnippet(const std::string& filePath, int startLine, int endLine) const;
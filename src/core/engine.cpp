@@ -4,7 +4,10 @@
 #include "query_processor.h"
 #include "../utils/config.h"
 #include "../utils/logger.h"
+#include "../utils/channel.h"
 #include "../scanner/scanner.h"
+#include "../scanner/file_watcher.h"
+#include "../scanner/index_file.h"
 #include "../llm/llm_interface.h"
 #include "../ui/main_window.h"
 #include <filesystem>
@@ -30,6 +33,7 @@ Engine::Engine(const std::string& configPath)
 }
 
 Engine::~Engine() {
+    stopWatching();
     utils::Logger::log(utils::LogLevel::INFO, "Engine: Destroyed");
 }
 
@@ -127,16 +131,93 @@ bool Engine::loadCodebase(const std::string& directoryPath, ProgressCallback cal
             setStatus(stage + ": " + message);
         };
     
-    scanner_->setProgressCallback(scanCallback);
+    // The index is about to be replaced; stop live updates to the old one
+    stopWatching();
     
-    // Scan the directory in a new thread
-    std::thread scanThread([this, directoryPath, progressDialog]() {
+    // Scan the directory in a new thread; loads run one at a time, each
+    // starting from the index the one before it left
+    std::thread scanThread([this, directoryPath, progressDialog, scanCallback]() {
+        std::lock_guard<std::mutex> loadLock(loadMutex_);
         try {
-            // Scan the directory
-            auto scannedCode = scanner_->scanDirectory(directoryPath);
+            // A load that finished while this one waited may have started watching
+            stopWatching();
+            scanner_->setProgressCallback(scanCallback);
+            
+            // Answer queries from the index the last session saved while the
+            // tree is checked for changes
+            std::shared_ptr<scanner::IndexedCode> previousCode;
+            {
+                std::lock_guard<std::mutex> lock(indexMutex_);
+                previousCode = indexedCode_;
+            }
+            bool newTree = !previousCode || previousCode->rootPath != directoryPath;
+            bool savedIndexLoaded = false;
+            if (newTree && contextManager_) {
+                auto indexFile = scanner_->openIndexFile(directoryPath);
+                if (indexFile && contextManager_->initialize(indexFile)) {
+                    savedIndexLoaded = true;
+                    setStatus("Loaded saved index: " + std::to_string(indexFile->getFileCount()) + 
+                              " files, checking for changes...");
+                }
+            }
+            
+            // With nothing to answer from yet, queries use the files indexed
+            // so far; the scanner publishes them in batches, and a consumer
+            // thread merges whatever batches have queued up at once. Files
+            // listed but not yet parsed are parsed when a query needs them.
+            // The callbacks hold this scan's session, so they never reach
+            // another scan of the same scanner.
+            std::shared_ptr<utils::Channel<scanner::ScanBatch>> batches;
+            std::shared_ptr<scanner::ScanSession> session;
+            std::thread batchConsumer;
+            if (newTree && !savedIndexLoaded && contextManager_) {
+                batches = std::make_shared<utils::Channel<scanner::ScanBatch>>();
+                session = std::make_shared<scanner::ScanSession>();
+                contextManager_->beginPartial(
+                    [session](const std::string& filePath) {
+                        return session->parseNow(filePath);
+                    },
+                    [session](const std::vector<std::string>& paths) {
+                        session->prioritize(paths);
+                    });
+                scanner_->setBatchCallback([batches](scanner::ScanBatch&& batch) {
+                    batches->push(std::move(batch));
+                });
+                batchConsumer = std::thread([this, batches]() {
+                    scanner::ScanBatch batch;
+                    while (batches->pop(batch)) {
+                        std::vector<scanner::ScanBatch> ready;
+                        ready.push_back(std::move(batch));
+                        while (batches->tryPop(batch)) {
+                            ready.push_back(std::move(batch));
+                        }
+                        contextManager_->addFiles(ready);
+                    }
+                });
+            }
+            
+            {
+                std::lock_guard<std::mutex> lock(indexMutex_);
+                scanSession_ = session;
+            }
+            
+            // Scan the directory; a rescan of the same tree reuses what is unchanged
+            auto scannedCode = scanner_->scanDirectory(directoryPath, previousCode.get(), session.get());
+            
+            if (batches) {
+                scanner_->setBatchCallback(nullptr);
+                batches->close();
+                batchConsumer.join();
+            }
             
             // Store the indexed code
-            indexedCode_ = std::make_shared<scanner::IndexedCode>(scannedCode);
+            {
+                std::lock_guard<std::mutex> lock(indexMutex_);
+                indexedCode_ = std::make_shared<scanner::IndexedCode>(scannedCode);
+                if (scanSession_ == session) {
+                    scanSession_.reset();
+                }
+            }
             
             // Initialize context manager with the indexed code
             if (contextManager_) {
@@ -154,6 +235,9 @@ bool Engine::loadCodebase(const std::string& directoryPath, ProgressCallback cal
             utils::Logger::log(utils::LogLevel::INFO, "Engine: Codebase loaded successfully");
             setStatus("Codebase loaded: " + std::to_string(scannedCode.fileCount) + " files");
             
+            // Follow edits from here on
+            startWatching(directoryPath);
+            
         } catch (const std::exception& e) {
             utils::Logger::log(utils::LogLevel::ERROR, "Engine: Error loading codebase: " + std::string(e.what()));
             setStatus("Error loading codebase: " + std::string(e.what()), true);
@@ -262,12 +346,20 @@ std::string Engine::getStatus() const {
 }
 
 bool Engine::showFile(const std::string& filePath) {
-    if (!indexedCode_ || !mainWindow_) {
+    if (!mainWindow_) {
         return false;
     }
     
-    auto it = indexedCode_->files.find(filePath);
-    if (it == indexedCode_->files.end()) {
+    std::unique_lock<std::mutex> lock(indexMutex_);
+    bool found = indexedCode_ && indexedCode_->files.find(filePath) != indexedCode_->files.end();
+    lock.unlock();
+    
+    // Until the first scan finishes, the context manager knows the files of
+    // the saved index or those the scan has listed so far
+    if (!found && contextManager_) {
+        found = contextManager_->hasFile(filePath);
+    }
+    if (!found) {
         utils::Logger::log(utils::LogLevel::ERROR, "Engine: File not found in indexed code: " + filePath);
         setStatus("File not found: " + filePath, true);
         return false;
@@ -317,6 +409,105 @@ void Engine::setupComponents() {
     utils::Logger::log(utils::LogLevel::INFO, "Engine: Components set up");
 }
 
+void Engine::startWatching(const std::string& directoryPath) {
+    if (!config_->getBool("scanner.watch", true)) {
+        return;
+    }
+    
+    std::vector<std::string> directories;
+    {
+        std::lock_guard<std::mutex> lock(indexMutex_);
+        if (!indexedCode_ || indexedCode_->rootPath != directoryPath) {
+            return;
+        }
+        directories = indexedCode_->directories;
+    }
+    
+    std::lock_guard<std::mutex> lock(watcherMutex_);
+    fileWatcher_ = std::make_unique<scanner::FileWatcher>(scanner_->getExcludedDirectories(),
+                                                          config_->getInt("scanner.watch_quiet_ms", 100),
+                                                          config_->getInt("scanner.watch_max_delay_ms", 500));
+    bool started = fileWatcher_->start(directoryPath, directories,
+        [this](const std::vector<std::string>& paths, bool overflowed) {
+            applyFileChanges(paths, overflowed);
+        });
+    if (!started) {
+        fileWatcher_.reset();
+    }
+}
+
+void Engine::stopWatching() {
+    std::lock_guard<std::mutex> lock(watcherMutex_);
+    if (fileWatcher_) {
+        fileWatcher_->stop();
+        fileWatcher_.reset();
+    }
+}
+
+void Engine::applyFileChanges(const std::vector<std::string>& paths, bool overflowed) {
+    try {
+        // Rescan or update without the lock, so showFile is never held up
+        // behind a parse; the result is swapped in only if no load replaced
+        // the index meanwhile
+        std::shared_ptr<scanner::IndexedCode> current;
+        {
+            std::lock_guard<std::mutex> lock(indexMutex_);
+            current = indexedCode_;
+        }
+        if (!current) {
+            return;
+        }
+        
+        if (overflowed || scanner_->changesIgnoreRules(paths)) {
+            // Events were lost, so the paths are incomplete, or ignore rules
+            // changed what belongs in the index; an incremental rescan only
+            // parses what actually changed
+            if (overflowed) {
+                utils::Logger::log(utils::LogLevel::WARNING, "Engine: File change events overflowed, rescanning");
+            } else {
+                utils::Logger::log(utils::LogLevel::INFO, "Engine: Ignore files changed, rescanning");
+            }
+            scanner_->setProgressCallback(nullptr);
+            auto scannedCode = std::make_shared<scanner::IndexedCode>(
+                scanner_->scanDirectory(current->rootPath, current.get()));
+            
+            std::lock_guard<std::mutex> lock(indexMutex_);
+            if (indexedCode_ != current) {
+                return;
+            }
+            indexedCode_ = scannedCode;
+            if (contextManager_) {
+                contextManager_->initialize(*indexedCode_);
+            }
+            setStatus("Codebase updated: " + std::to_string(indexedCode_->fileCount) + " files");
+            return;
+        }
+        
+        // Queries keep reading the current index while a copy is updated
+        auto updatedCode = std::make_shared<scanner::IndexedCode>(*current);
+        std::vector<std::string> changedFiles = scanner_->updateFiles(*updatedCode, paths);
+        
+        std::lock_guard<std::mutex> lock(indexMutex_);
+        if (indexedCode_ != current) {
+            return;
+        }
+        indexedCode_ = updatedCode;
+        if (changedFiles.empty()) {
+            return;
+        }
+        
+        // Publish the new state of these files to queries in one step
+        if (contextManager_) {
+            contextManager_->updateFiles(*indexedCode_, changedFiles);
+        }
+        
+        setStatus("Codebase updated: " + std::to_string(changedFiles.size()) + " changed files");
+        
+    } catch (const std::exception& e) {
+        utils::Logger::log(utils::LogLevel::ERROR, "Engine: Error applying file changes: " + std::string(e.what()));
+    }
+}
+
 void Engine::handleFileSelection(const std::string& filePath) {
     if (filePath.empty()) {
         return;
@@ -326,6 +517,16 @@ void Engine::handleFileSelection(const std::string& filePath) {
         // Load as codebase
         loadCodebase(filePath);
     } else if (fs::is_regular_file(filePath)) {
+        // A first scan still running parses this file and its neighbours next
+        std::shared_ptr<scanner::ScanSession> session;
+        {
+            std::lock_guard<std::mutex> lock(indexMutex_);
+            session = scanSession_;
+        }
+        if (session) {
+            session->prioritize({filePath, fs::path(filePath).parent_path().string()});
+        }
+        
         // Show file
         showFile(filePath);
     }
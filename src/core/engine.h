@@ -5,6 +5,7 @@
 #include <string>
 #include <vector>
 #include <functional>
+#include <mutex>
 
 namespace codelve {
 
@@ -22,6 +23,8 @@ namespace scanner {
     class FileSystem;
     class CodeParser;
     class Indexer;
+    class FileWatcher;
+    class ScanSession;
 }
 
 namespace core {
@@ -107,6 +110,23 @@ private:
     std::string codebasePath_;
     int totalFiles_;
     int parsedFiles_;
+    
+    // Live updates of the loaded codebase
+    std::unique_ptr<scanner::FileWatcher> fileWatcher_;
+    std::mutex watcherMutex_;
+    
+    // Serializes changes to the indexed code with readers of it
+    std::mutex indexMutex_;
+    
+    // Held by the scan thread of a load, so that loads never overlap
+    std::mutex loadMutex_;
+    
+    // Session of the first scan in progress, if any; guarded by indexMutex_
+    std::shared_ptr<scanner::ScanSession> scanSession_;
+    
+    void startWatching(const std::string& directoryPath);
+    void stopWatching();
+    void applyFileChanges(const std::vector<std::string>& paths, bool overflowed);
 };
 
 }} // namespace codelve::core
\ No newline at end of file
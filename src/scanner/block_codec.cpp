@@ -0,0 +1,195 @@
+// File: codelve/src/scanner/block_codec.cpp
+#include "block_codec.h"
+#include <algorithm>
+#include <cstring>
+
+namespace codelve {
+namespace scanner {
+
+namespace {
+    inline uint32_t read32(const unsigned char* data) {
+        uint32_t value;
+        std::memcpy(&value, data, sizeof(value));
+        return value;
+    }
+
+    inline uint32_t hashPrefix(uint32_t prefix, unsigned bits) {
+        return (prefix * 2654435761u) >> (32 - bits);
+    }
+
+    // Lengths past a nibble's 15 continue in bytes of 255 and a final remainder
+    inline unsigned char* putLength(unsigned char* out, size_t length) {
+        for (; length >= 255; length -= 255) {
+            *out++ = 255;
+        }
+        *out++ = static_cast<unsigned char>(length);
+        return out;
+    }
+
+    inline bool getLength(const unsigned char*& in, const unsigned char* end, size_t& length) {
+        unsigned char byte;
+        do {
+            if (in >= end || length > SIZE_MAX / 2) {
+                return false;
+            }
+            byte = *in++;
+            length += byte;
+        } while (byte == 255);
+        return true;
+    }
+
+    // Copy in 8-byte steps, possibly writing up to 7 bytes past the end
+    inline void copyWide(unsigned char* out, const unsigned char* in, size_t length) {
+        unsigned char* end = out + length;
+        do {
+            std::memcpy(out, in, 8);
+            out += 8;
+            in += 8;
+        } while (out < end);
+    }
+}
+
+size_t BlockCodec::getBound(size_t size) {
+    return size + size / 255 + 16;
+}
+
+size_t BlockCodec::compress(std::string_view input, std::string& output) {
+    const size_t start = output.size();
+    output.resize(start + getBound(input.size()));
+    unsigned char* const outBegin = reinterpret_cast<unsigned char*>(&output[start]);
+    unsigned char* out = outBegin;
+
+    const unsigned char* const data = reinterpret_cast<const unsigned char*>(input.data());
+    const size_t size = input.size();
+    size_t anchor = 0;
+
+    auto putSequence = [&out, data](size_t literalBegin, size_t literalEnd, size_t offset, size_t matchLength) {
+        size_t literalLength = literalEnd - literalBegin;
+        unsigned char* token = out++;
+        *token = static_cast<unsigned char>(std::min<size_t>(literalLength, 15) << 4);
+        if (literalLength >= 15) {
+            out = putLength(out, literalLength - 15);
+        }
+        std::memcpy(out, data + literalBegin, literalLength);
+        out += literalLength;
+        if (matchLength == 0) {
+            return;
+        }
+
+        *out++ = static_cast<unsigned char>(offset & 0xff);
+        *out++ = static_cast<unsigned char>(offset >> 8);
+        size_t extra = matchLength - kMinMatch;
+        *token |= static_cast<unsigned char>(std::min<size_t>(extra, 15));
+        if (extra >= 15) {
+            out = putLength(out, extra - 15);
+        }
+    };
+
+    if (size > kMatchLimit) {
+        // Last position of each hashed 4-byte prefix
+        uint32_t table[1u << kHashBits] = {};
+        const size_t matchStartLimit = size - kMatchLimit;
+        const size_t matchEndLimit = size - kLastLiterals;
+
+        size_t position = 0;
+        while (position < matchStartLimit) {
+            uint32_t prefix = read32(data + position);
+            uint32_t& slot = table[hashPrefix(prefix, kHashBits)];
+            size_t candidate = slot;
+            slot = static_cast<uint32_t>(position);
+
+            if (candidate >= position || position - candidate > kMaxOffset || read32(data + candidate) != prefix) {
+                position += 1 + ((position - anchor) >> 6);
+                continue;
+            }
+
+            // Grow the match backwards over pending literals, then forwards
+            while (position > anchor && candidate > 0 && data[position - 1] == data[candidate - 1]) {
+                position--;
+                candidate--;
+            }
+            size_t matchEnd = position + kMinMatch;
+            while (matchEnd < matchEndLimit && data[matchEnd] == data[candidate + (matchEnd - position)]) {
+                matchEnd++;
+            }
+
+            putSequence(anchor, position, position - candidate, matchEnd - position);
+            anchor = matchEnd;
+            position = matchEnd;
+
+            // The match's last bytes often start the next one
+            if (position - 2 < matchStartLimit) {
+                table[hashPrefix(read32(data + position - 2), kHashBits)] = static_cast<uint32_t>(position - 2);
+            }
+        }
+    }
+
+    putSequence(anchor, size, 0, 0);
+    size_t written = static_cast<size_t>(out - outBegin);
+    output.resize(start + written);
+    return written;
+}
+
+bool BlockCodec::decompress(std::string_view input, char* output, size_t outputSize) {
+    const unsigned char* in = reinterpret_cast<const unsigned char*>(input.data());
+    const unsigned char* const inEnd = in + input.size();
+    unsigned char* const outBegin = reinterpret_cast<unsigned char*>(output);
+    unsigned char* out = outBegin;
+    unsigned char* const outEnd = outBegin + outputSize;
+
+    while (in < inEnd) {
+        unsigned token = *in++;
+
+        size_t literalLength = token >> 4;
+        if (literalLength == 15 && !getLength(in, inEnd, literalLength)) {
+            return false;
+        }
+        if (literalLength > static_cast<size_t>(inEnd - in) || literalLength > static_cast<size_t>(outEnd - out)) {
+            return false;
+        }
+        if (literalLength + 8 <= static_cast<size_t>(inEnd - in) && literalLength + 8 <= static_cast<size_t>(outEnd - out)) {
+            copyWide(out, in, literalLength);
+        } else {
+            std::memcpy(out, in, literalLength);
+        }
+        in += literalLength;
+        out += literalLength;
+
+        // Only the last sequence ends after its literals
+        if (in == inEnd) {
+            break;
+        }
+
+        if (inEnd - in < 2) {
+            return false;
+        }
+        size_t offset = static_cast<size_t>(in[0]) | (static_cast<size_t>(in[1]) << 8);
+        in += 2;
+        if (offset == 0 || offset > static_cast<size_t>(out - outBegin)) {
+            return false;
+        }
+
+        size_t matchLength = token & 15;
+        if (matchLength == 15 && !getLength(in, inEnd, matchLength)) {
+            return false;
+        }
+        matchLength += kMinMatch;
+        if (matchLength > static_cast<size_t>(outEnd - out)) {
+            return false;
+        }
+
+        // Overlapping matches repeat a short pattern and are copied bytewise
+        const unsigned char* match = out - offset;
+        if (offset >= 8 && matchLength + 8 <= static_cast<size_t>(outEnd - out)) {
+            copyWide(out, match, matchLength);
+        } else {
+            for (size_t i = 0; i < matchLength; i++) {
+                out[i] = match[i];
+            }
+        }
+        out += matchLength;
+    }
+    return out == outEnd;
+}
+
+}} // namespace codelve::scanner
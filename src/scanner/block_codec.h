@@ -0,0 +1,62 @@
+// File: codelve/src/scanner/block_codec.h
+#pragma once
+#include <string>
+#include <string_view>
+#include <cstddef>
+#include <cstdint>
+
+namespace codelve {
+namespace scanner {
+
+/**
+ * Fast LZ77 compression of single blocks, in the LZ4 block format.
+ *
+ * Each block is self-contained: a run of sequences, each a token byte
+ * (literal count in the high nibble, match length minus 4 in the low
+ * one, 15 meaning more length bytes follow), the literals, and a 16-bit
+ * little-endian match offset. The last 5 bytes of a block are always
+ * literals. Matches are found through a single-probe hash table of 4-byte
+ * prefixes, trading ratio for speed the way LZ4's fast mode does. Runs
+ * without matches are skipped over with a growing stride, so data that does
+ * not compress costs little time.
+ *
+ * Decoding checks every length and offset against the buffers, so corrupt
+ * input fails instead of reading or writing out of bounds.
+ */
+class BlockCodec {
+public:
+    /**
+     * Get the largest compressed size of a block of a given size.
+     * @param size Uncompressed size
+     * @return Worst-case compressed size
+     */
+    static size_t getBound(size_t size);
+
+    /**
+     * Compress a block, appending to a buffer.
+     * @param input Bytes to compress; at most 2GB
+     * @param output Receives the compressed block after its existing bytes
+     * @return Compressed size
+     */
+    static size_t compress(std::string_view input, std::string& output);
+
+    /**
+     * Decompress a block.
+     * @param input A block produced by compress()
+     * @param output Receives exactly outputSize bytes
+     * @param outputSize Uncompressed size of the block
+     * @return true if the block decoded to exactly outputSize bytes
+     */
+    static bool decompress(std::string_view input, char* output, size_t outputSize);
+
+private:
+    static const size_t kMinMatch = 4;
+    static const size_t kLastLiterals = 5;
+
+    // A match may not start in the last 12 bytes, so the decoder can copy in words
+    static const size_t kMatchLimit = 12;
+    static const size_t kMaxOffset = 65535;
+    static const unsigned kHashBits = 12;
+};
+
+}} // namespace codelve::scanner
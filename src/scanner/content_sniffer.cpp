@@ -0,0 +1,114 @@
+// File: codelve/src/scanner/content_sniffer.cpp
+#include "content_sniffer.h"
+#include "simd_common.h"
+#include <algorithm>
+
+namespace codelve {
+namespace scanner {
+
+namespace {
+    // Header conventions of code generators; matched case-sensitively
+    const char* const kGeneratedMarkers[] = {
+        "@generated",
+        "DO NOT EDIT",
+        "Generated by the protocol buffer compiler",
+        "Code generated by",
+        "This file was automatically generated",
+        "This file is automatically generated",
+        "Automatically generated by",
+        "Autogenerated by",
+        "<auto-generated"
+    };
+
+    // Fold the newlines set in a mask into the line statistics
+    inline void addNewlines(ContentSample& sample, size_t& lineStart, uint32_t mask, size_t base) {
+        while (mask != 0) {
+            size_t newline = base + lowestBit(mask);
+            sample.maxLineLength = std::max(sample.maxLineLength, newline - lineStart);
+            sample.lineCount++;
+            lineStart = newline + 1;
+            mask &= mask - 1;
+        }
+    }
+}
+
+const size_t ContentSniffer::kSniffSize;
+
+ContentSample ContentSniffer::sample(std::string_view content) {
+    ContentSample sample;
+    sample.size = std::min(content.size(), kSniffSize);
+    sample.nulCount = 0;
+    sample.lineCount = 0;
+    sample.maxLineLength = 0;
+
+    const char* data = content.data();
+    const size_t size = sample.size;
+    size_t pos = 0;
+    size_t lineStart = 0;
+
+#if defined(CODELVE_SIMD_AVX2)
+    const __m256i newline = _mm256_set1_epi8('\n');
+    const __m256i zero = _mm256_setzero_si256();
+    for (; pos + 32 <= size; pos += 32) {
+        __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + pos));
+        uint32_t newlines = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk, newline)));
+        uint32_t nuls = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk, zero)));
+        sample.nulCount += popCount(nuls);
+        addNewlines(sample, lineStart, newlines, pos);
+    }
+#elif defined(CODELVE_SIMD_SSE2)
+    const __m128i newline = _mm_set1_epi8('\n');
+    const __m128i zero = _mm_setzero_si128();
+    for (; pos + 16 <= size; pos += 16) {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + pos));
+        uint32_t newlines = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, newline)));
+        uint32_t nuls = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, zero)));
+        sample.nulCount += popCount(nuls);
+        addNewlines(sample, lineStart, newlines, pos);
+    }
+#endif
+
+    // Tail, or the whole sample without SIMD support
+    for (; pos < size; pos++) {
+        if (data[pos] == '\0') {
+            sample.nulCount++;
+        } else if (data[pos] == '\n') {
+            addNewlines(sample, lineStart, 1, pos);
+        }
+    }
+
+    // The last line may run on past the sample; count what was seen of it
+    if (lineStart < size) {
+        sample.maxLineLength = std::max(sample.maxLineLength, size - lineStart);
+        sample.lineCount++;
+    }
+    return sample;
+}
+
+ContentClass ContentSniffer::classify(std::string_view content) {
+    ContentSample stats = sample(content);
+    if (stats.nulCount > 0) {
+        return ContentClass::Binary;
+    }
+
+    size_t averageLine = stats.lineCount > 0 ? stats.size / stats.lineCount : 0;
+    if (stats.maxLineLength >= kMinifiedLine && averageLine >= kMinifiedAverageLine) {
+        return ContentClass::Minified;
+    }
+
+    std::string_view head = content.substr(0, stats.size);
+    for (const char* marker : kGeneratedMarkers) {
+        if (head.find(marker) != std::string_view::npos) {
+            return ContentClass::Generated;
+        }
+    }
+    return ContentClass::Source;
+}
+
+const char* ContentSniffer::getName(ContentClass contentClass) {
+    static const char* names[] = {"source", "generated", "minified", "binary"};
+    size_t index = static_cast<size_t>(contentClass);
+    return index < static_cast<size_t>(ContentClass::Count) ? names[index] : "unknown";
+}
+
+}} // namespace codelve::scanner
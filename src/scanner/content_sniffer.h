@@ -0,0 +1,72 @@
+// File: codelve/src/scanner/content_sniffer.h
+#pragma once
+#include <string_view>
+#include <cstddef>
+#include <cstdint>
+
+namespace codelve {
+namespace scanner {
+
+/**
+ * What a file with a source extension turned out to contain.
+ */
+enum class ContentClass : uint8_t {
+    Source,         // Hand-written code: read, indexed and parsed
+    Generated,      // Marked as generated: indexed, but its symbols are not extracted
+    Minified,       // Bundled or minified, with very long lines: skipped
+    Binary,         // Contains NUL bytes: skipped
+    Count
+};
+
+/**
+ * Statistics of the head of a file, gathered in one vectorized pass.
+ */
+struct ContentSample {
+    size_t size;            // Bytes examined
+    size_t nulCount;
+    size_t lineCount;       // Counting a final line without a newline
+    size_t maxLineLength;
+};
+
+/**
+ * Classify a file from its first kSniffSize bytes only, so a file that is
+ * rejected is never scanned past its first pages.
+ *
+ * A NUL byte means binary. Long lines on average, with at least one very
+ * long line, mean minified. A generated-file marker such as "@generated",
+ * "DO NOT EDIT" or "Generated by the protocol buffer compiler" means
+ * generated. Anything else is source.
+ */
+class ContentSniffer {
+public:
+    // How much of each file is examined
+    static const size_t kSniffSize = 4096;
+
+    /**
+     * Gather the statistics of a file's head.
+     * @param content The file contents; only the first kSniffSize bytes are read
+     * @return The statistics
+     */
+    static ContentSample sample(std::string_view content);
+
+    /**
+     * Classify a file.
+     * @param content The file contents; only the first kSniffSize bytes are read
+     * @return The class
+     */
+    static ContentClass classify(std::string_view content);
+
+    /**
+     * Get a class name for logs.
+     * @param contentClass The class
+     * @return Lowercase name, e.g. "minified"
+     */
+    static const char* getName(ContentClass contentClass);
+
+private:
+    // A minified head has lines this long on average, and one at least kMinifiedLine long
+    static const size_t kMinifiedAverageLine = 200;
+    static const size_t kMinifiedLine = 1000;
+};
+
+}} // namespace codelve::scanner
@@ -0,0 +1,285 @@
+// File: codelve/src/scanner/content_store.cpp
+#include "content_store.h"
+#include "block_codec.h"
+#include "file_system.h"
+#include "../utils/logger.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iomanip>
+#include <sstream>
+
+namespace codelve {
+namespace scanner {
+
+// Blocks are stored back to back. A block that does not shrink is stored
+// as it is, so a block exactly kBlockSize long (or as long as the body's
+// tail) is raw and any shorter one is compressed.
+struct ContentStore::PackedBody {
+    std::string data;
+    std::vector<uint32_t> blockEnds;
+    LineIndex lines;
+    size_t size;
+};
+
+const size_t ContentStore::kBlockSize;
+
+ContentStore::ContentStore(size_t budgetBytes, bool compress)
+    : budgetBytes_(budgetBytes),
+      compress_(compress),
+      residentBytes_(0),
+      hits_(0),
+      misses_(0),
+      residentRawBytes_(0),
+      decodedBytes_(0),
+      decodeNanoseconds_(0) {
+}
+
+std::shared_ptr<const FileBody> ContentStore::get(const std::string& filePath,
+                                                  const std::shared_ptr<const FileBlob>& blob,
+                                                  bool cache) {
+    std::shared_ptr<const FileBody> body;
+    std::shared_ptr<const PackedBody> packed;
+    if (!acquire(filePath, blob, cache, body, packed)) {
+        return nullptr;
+    }
+    if (body) {
+        return body;
+    }
+
+    auto unpacked = std::make_shared<FileBody>();
+    if (!unpack(*packed, 0, packed->size, unpacked->content)) {
+        return nullptr;
+    }
+    unpacked->lines = packed->lines;
+    return unpacked;
+}
+
+bool ContentStore::getLines(const std::string& filePath,
+                            const std::shared_ptr<const FileBlob>& blob,
+                            size_t firstLine,
+                            size_t lastLine,
+                            std::string& text) {
+    std::shared_ptr<const FileBody> body;
+    std::shared_ptr<const PackedBody> packed;
+    if (!acquire(filePath, blob, true, body, packed)) {
+        return false;
+    }
+    const LineIndex& lines = body ? body->lines : packed->lines;
+    size_t size = body ? body->content.size() : packed->size;
+
+    size_t lineCount = lines.lineCount();
+    if (lines.lineStart(lineCount - 1) == size) {
+        lineCount--;
+    }
+    if (lastLine >= lineCount) {
+        lastLine = lineCount - 1;
+    }
+    if (lineCount == 0 || firstLine > lastLine) {
+        return false;
+    }
+
+    // Lines are separated by exactly one newline, so the range is one slice
+    size_t begin = lines.lineStart(firstLine);
+    size_t end = lines.lineEnd(lastLine);
+    text.clear();
+    if (body) {
+        text.assign(body->content, begin, end - begin);
+    } else if (!unpack(*packed, begin, end, text)) {
+        return false;
+    }
+    text += '\n';
+    return true;
+}
+
+bool ContentStore::acquire(const std::string& filePath,
+                           const std::shared_ptr<const FileBlob>& blob,
+                           bool cache,
+                           std::shared_ptr<const FileBody>& body,
+                           std::shared_ptr<const PackedBody>& packed) {
+    if (find(blob, body, packed)) {
+        return true;
+    }
+
+    // Read without the lock; two threads missing the same blob both read it
+    body = load(filePath, *blob);
+    if (body && cache) {
+        put(blob, body);
+    }
+    return body != nullptr;
+}
+
+bool ContentStore::find(const std::shared_ptr<const FileBlob>& blob,
+                        std::shared_ptr<const FileBody>& body,
+                        std::shared_ptr<const PackedBody>& packed) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto found = lookup_.find(blob.get());
+    if (found != lookup_.end() && found->second->blob.lock() == blob) {
+        entries_.splice(entries_.begin(), entries_, found->second);
+        hits_++;
+        body = found->second->body;
+        packed = found->second->packed;
+        return true;
+    }
+    misses_++;
+    return false;
+}
+
+void ContentStore::put(const std::shared_ptr<const FileBlob>& blob, std::shared_ptr<const FileBody> body) {
+    Entry entry;
+    entry.key = blob.get();
+    entry.blob = blob;
+    if (compress_) {
+        // Compressed before taking the lock, on the caller's thread
+        entry.packed = pack(*body);
+        entry.bytes = entry.packed->data.size();
+    } else {
+        entry.bytes = body->content.size();
+        entry.body = std::move(body);
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    // An entry under this address may be for a blob that has since been freed
+    auto found = lookup_.find(blob.get());
+    if (found != lookup_.end()) {
+        erase(found->second);
+    }
+
+    residentBytes_ += entry.bytes;
+    residentRawBytes_ += entry.packed ? entry.packed->size : 0;
+    entries_.push_front(std::move(entry));
+    lookup_[blob.get()] = entries_.begin();
+    evict();
+}
+
+std::shared_ptr<const FileBody> ContentStore::load(const std::string& filePath, const FileBlob& blob) {
+    MappedFile source;
+    if (!source.open(filePath)) {
+        utils::Logger::log(utils::LogLevel::WARNING, "ContentStore: Failed to open file: " + filePath);
+        return nullptr;
+    }
+    if (source.view().size() != blob.size || hashContent(source.view()) != blob.hash) {
+        utils::Logger::log(utils::LogLevel::DEBUG, "ContentStore: File changed since it was indexed: " + filePath);
+        return nullptr;
+    }
+
+    auto body = std::make_shared<FileBody>();
+    body->content = source.takeContent();
+    body->lines = LineIndex(body->content);
+    return body;
+}
+
+std::shared_ptr<const ContentStore::PackedBody> ContentStore::pack(const FileBody& body) {
+    auto packed = std::make_shared<PackedBody>();
+    std::string_view content = body.content;
+    packed->size = content.size();
+    packed->lines = body.lines;
+    packed->blockEnds.reserve((content.size() + kBlockSize - 1) / kBlockSize);
+
+    for (size_t offset = 0; offset < content.size(); offset += kBlockSize) {
+        std::string_view block = content.substr(offset, kBlockSize);
+        size_t start = packed->data.size();
+        if (BlockCodec::compress(block, packed->data) >= block.size()) {
+            packed->data.resize(start);
+            packed->data.append(block);
+        }
+        packed->blockEnds.push_back(static_cast<uint32_t>(packed->data.size()));
+    }
+    packed->data.shrink_to_fit();
+    return packed;
+}
+
+bool ContentStore::unpack(const PackedBody& packed, size_t begin, size_t end, std::string& out) {
+    auto started = std::chrono::steady_clock::now();
+    size_t outStart = out.size();
+    out.resize(outStart + (end - begin));
+    char* target = &out[0] + outStart;
+
+    std::string scratch;
+    size_t decoded = 0;
+    for (size_t block = begin / kBlockSize; block * kBlockSize < end; block++) {
+        size_t blockBegin = block * kBlockSize;
+        size_t rawSize = std::min(kBlockSize, packed.size - blockBegin);
+        size_t dataBegin = block > 0 ? packed.blockEnds[block - 1] : 0;
+        std::string_view data(packed.data.data() + dataBegin, packed.blockEnds[block] - dataBegin);
+
+        // The part of this block that was asked for
+        size_t from = std::max(begin, blockBegin) - blockBegin;
+        size_t to = std::min(end, blockBegin + rawSize) - blockBegin;
+        if (data.size() == rawSize) {
+            std::memcpy(target, data.data() + from, to - from);
+        } else if (from == 0 && to == rawSize) {
+            if (!BlockCodec::decompress(data, target, rawSize)) {
+                out.resize(outStart);
+                return false;
+            }
+            decoded += rawSize;
+        } else {
+            scratch.resize(rawSize);
+            if (!BlockCodec::decompress(data, &scratch[0], rawSize)) {
+                out.resize(outStart);
+                return false;
+            }
+            std::memcpy(target, scratch.data() + from, to - from);
+            decoded += rawSize;
+        }
+        target += to - from;
+    }
+
+    auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - started);
+    decodedBytes_ += decoded;
+    decodeNanoseconds_ += static_cast<uint64_t>(elapsed.count());
+    return true;
+}
+
+void ContentStore::purge() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto entry = entries_.begin(); entry != entries_.end(); ) {
+        auto next = std::next(entry);
+        if (entry->blob.expired()) {
+            erase(entry);
+        }
+        entry = next;
+    }
+}
+
+size_t ContentStore::getResidentBytes() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return residentBytes_;
+}
+
+std::string ContentStore::getReport() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::ostringstream report;
+    report << entries_.size() << " bodies, " << residentBytes_ << " bytes resident (budget ";
+    if (budgetBytes_ > 0) {
+        report << budgetBytes_ << " bytes)";
+    } else {
+        report << "no limit)";
+    }
+    if (compress_) {
+        double ratio = residentBytes_ > 0 ? static_cast<double>(residentRawBytes_) / residentBytes_ : 1.0;
+        uint64_t nanoseconds = decodeNanoseconds_.load();
+        double throughput = nanoseconds > 0 ? decodedBytes_.load() * 1000.0 / nanoseconds : 0.0;
+        report << std::fixed << std::setprecision(1) << ", compressed " << ratio << "x from " << residentRawBytes_
+               << " bytes; decoded " << decodedBytes_.load() << " bytes at " << throughput << " MB/s";
+    }
+    report << "; " << hits_ << " hits, " << misses_ << " loads";
+    return report.str();
+}
+
+void ContentStore::erase(std::list<Entry>::iterator entry) {
+    residentBytes_ -= entry->bytes;
+    residentRawBytes_ -= entry->packed ? entry->packed->size : 0;
+    lookup_.erase(entry->key);
+    entries_.erase(entry);
+}
+
+void ContentStore::evict() {
+    while (budgetBytes_ > 0 && residentBytes_ > budgetBytes_ && !entries_.empty()) {
+        erase(std::prev(entries_.end()));
+    }
+}
+
+}} // namespace codelve::scanner
@@ -0,0 +1,189 @@
+// File: codelve/src/scanner/content_store.h
+#pragma once
+#include "line_index.h"
+#include <string>
+#include <vector>
+#include <list>
+#include <unordered_map>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace codelve {
+namespace scanner {
+
+/**
+ * What the index keeps of a file's contents: enough to find and check
+ * them, not the bytes. Files with identical bytes share one blob.
+ */
+struct FileBlob {
+    // hashContent() of the content
+    uint64_t hash;
+
+    // Size of the content in bytes
+    uint64_t size;
+};
+
+/**
+ * The contents of a file with its line table, as loaded by a ContentStore.
+ */
+struct FileBody {
+    std::string content;
+    LineIndex lines;
+};
+
+/**
+ * File bodies of an index, loaded on demand and cached under a byte budget.
+ *
+ * Bodies are read from disk the first time they are asked for and kept in
+ * least-recently-used order; once the resident bytes exceed the budget the
+ * oldest are dropped. A body that is still in use stays alive with its user
+ * after it leaves the cache. A loaded body is checked against its blob's
+ * size and hash, so a file that changed since it was indexed is reported
+ * as missing rather than served with stale offsets.
+ *
+ * Bodies are read into memory instead of being kept mapped: a mapping of a
+ * file that is truncated underneath it faults on access.
+ *
+ * In compressed mode cached bodies are held as independently compressed
+ * blocks of kBlockSize bytes (see BlockCodec), and the budget counts
+ * compressed bytes. get() then decompresses a whole body for its caller,
+ * while getLines() decompresses only the blocks the lines fall in.
+ */
+class ContentStore {
+public:
+    // Uncompressed size of a block in compressed mode
+    static const size_t kBlockSize = 64 * 1024;
+
+    /**
+     * Constructor.
+     * @param budgetBytes Bytes of bodies to keep resident; 0 keeps every one
+     * @param compress true to keep cached bodies compressed
+     */
+    ContentStore(size_t budgetBytes, bool compress);
+
+    ContentStore(const ContentStore&) = delete;
+    ContentStore& operator=(const ContentStore&) = delete;
+
+    /**
+     * Get the body of a blob, loading it from a file that has it if it is
+     * not resident. Safe to call from several threads.
+     * @param filePath Path of a file with the blob's contents
+     * @param blob The blob
+     * @param cache false to load without adding the body to the cache
+     * @return The body, or null if the file cannot be read or has changed
+     */
+    std::shared_ptr<const FileBody> get(const std::string& filePath,
+                                        const std::shared_ptr<const FileBlob>& blob,
+                                        bool cache = true);
+
+    /**
+     * Copy whole lines of a blob's body, loading it like get() if needed.
+     * A trailing newline does not start another line.
+     * @param filePath Path of a file with the blob's contents
+     * @param blob The blob
+     * @param firstLine 0-based first line
+     * @param lastLine 0-based last line, inclusive; clamped to the last line
+     * @param text Receives the lines, each followed by a newline
+     * @return false if the body cannot be had or the range holds no lines
+     */
+    bool getLines(const std::string& filePath,
+                  const std::shared_ptr<const FileBlob>& blob,
+                  size_t firstLine,
+                  size_t lastLine,
+                  std::string& text);
+
+    /**
+     * Make a body resident, as the most recently used.
+     * @param blob The blob the body belongs to
+     * @param body Its contents
+     */
+    void put(const std::shared_ptr<const FileBlob>& blob, std::shared_ptr<const FileBody> body);
+
+    /**
+     * Read a body from disk without involving any cache.
+     * @param filePath Path of a file with the blob's contents
+     * @param blob The blob
+     * @return The body, or null if the file cannot be read or has changed
+     */
+    static std::shared_ptr<const FileBody> load(const std::string& filePath, const FileBlob& blob);
+
+    /**
+     * Drop the bodies of blobs no index refers to any more.
+     */
+    void purge();
+
+    /**
+     * Get the bytes of bodies held by the cache, compressed in compressed mode.
+     * @return Resident bytes
+     */
+    size_t getResidentBytes() const;
+
+    /**
+     * Get a one-line summary of the cache: residency, budget, compression
+     * ratio, decompression throughput, hits and misses.
+     * @return Human-readable report
+     */
+    std::string getReport() const;
+
+private:
+    // A body in compressed blocks (defined in content_store.cpp)
+    struct PackedBody;
+
+    struct Entry {
+        // Held weakly, so a blob dropped from the index can be recognized;
+        // key is its address, which outlives it as the lookup key
+        const FileBlob* key;
+        std::weak_ptr<const FileBlob> blob;
+
+        // One of the two is set, depending on the mode
+        std::shared_ptr<const FileBody> body;
+        std::shared_ptr<const PackedBody> packed;
+
+        // What the entry counts against the budget
+        size_t bytes;
+    };
+
+    const size_t budgetBytes_;
+    const bool compress_;
+
+    // Most recently used first; indexed by blob address
+    std::list<Entry> entries_;
+    std::unordered_map<const FileBlob*, std::list<Entry>::iterator> lookup_;
+    size_t residentBytes_;
+    uint64_t hits_;
+    uint64_t misses_;
+    mutable std::mutex mutex_;
+
+    // Uncompressed size of the resident compressed bodies, under mutex_
+    size_t residentRawBytes_;
+
+    // Decompression work; counted outside the lock
+    std::atomic<uint64_t> decodedBytes_;
+    std::atomic<uint64_t> decodeNanoseconds_;
+
+    // Look a blob up, counting a hit or a miss; fills in body or packed
+    bool find(const std::shared_ptr<const FileBlob>& blob,
+              std::shared_ptr<const FileBody>& body,
+              std::shared_ptr<const PackedBody>& packed);
+
+    // Get a body the way get() does; packed is set instead on a compressed hit
+    bool acquire(const std::string& filePath,
+                 const std::shared_ptr<const FileBlob>& blob,
+                 bool cache,
+                 std::shared_ptr<const FileBody>& body,
+                 std::shared_ptr<const PackedBody>& packed);
+
+    static std::shared_ptr<const PackedBody> pack(const FileBody& body);
+
+    // Append bytes [begin, end) of a compressed body to out
+    bool unpack(const PackedBody& packed, size_t begin, size_t end, std::string& out);
+
+    // Callers hold mutex_
+    void erase(std::list<Entry>::iterator entry);
+    void evict();
+};
+
+}} // namespace codelve::scanner
@@ -0,0 +1,674 @@
+// File: codelve/src/scanner/cpp_lexer.cpp
+#include "cpp_lexer.h"
+#include <algorithm>
+#include <limits>
+
+namespace codelve {
+namespace scanner {
+
+namespace {
+    const size_t kNoStatement = std::numeric_limits<size_t>::max();
+
+    // Words that can never be the name of a declared function
+    bool isNonFunctionWord(std::string_view word) {
+        static const std::string_view words[] = {
+            "if", "for", "while", "switch", "return", "sizeof", "catch", "alignof",
+            "alignas", "decltype", "static_assert", "typeid", "noexcept", "defined",
+            "__attribute__", "__declspec", "requires", "operator", "void", "int",
+            "char", "bool", "short", "long", "float", "double", "unsigned", "signed",
+            "auto", "const", "volatile", "struct", "class", "enum", "union",
+            "typename", "template", "using", "namespace", "new", "delete", "this",
+            "true", "false", "nullptr", "throw", "case", "do", "else", "try",
+            "typedef", "asm", "__asm__", "_Pragma", "__pragma"
+        };
+        return std::find(std::begin(words), std::end(words), word) != std::end(words);
+    }
+
+    // Words that, directly before "name(", mean the parenthesis is a call
+    bool isExpressionWord(std::string_view word) {
+        static const std::string_view words[] = {
+            "return", "new", "delete", "else", "case", "goto", "throw",
+            "co_return", "co_yield", "co_await", "sizeof", "typename"
+        };
+        return std::find(std::begin(words), std::end(words), word) != std::end(words);
+    }
+}
+
+CppLexer::CppLexer(std::string_view source)
+    : source_(source),
+      pos_(0),
+      atLineStart_(true),
+      pending_(Pending::None),
+      pendingEnd_(0),
+      pendingAngleDepth_(0),
+      pendingTrailingReturn_(false),
+      statementStart_(kNoStatement),
+      statementHasAssign_(false),
+      parenDepth_(0),
+      nestedBraces_(0) {
+    prev_[0] = prev_[1] = Token{TokenKind::End, 0, 0};
+}
+
+std::vector<LexedSymbol> CppLexer::extractSymbols() {
+    while (true) {
+        Token token = nextToken();
+        if (token.kind == TokenKind::End) {
+            break;
+        }
+        consume(token);
+    }
+    return std::move(symbols_);
+}
+
+// ---------------------------------------------------------------------------
+// Lexing
+// ---------------------------------------------------------------------------
+
+CppLexer::Token CppLexer::nextToken() {
+    const size_t size = source_.size();
+
+    while (pos_ < size) {
+        unsigned char c = source_[pos_];
+        unsigned char next = pos_ + 1 < size ? source_[pos_ + 1] : 0;
+
+        if (c == '\n') {
+            pos_++;
+            atLineStart_ = true;
+            continue;
+        }
+        if (isBlank(c)) {
+            pos_++;
+            continue;
+        }
+        if (c == '\\' && (next == '\n' || next == '\r')) {
+            // Line splice outside a directive, e.g. in a multi-line macro use
+            pos_++;
+            continue;
+        }
+        if (c == '/' && next == '/') {
+            skipLineComment();
+            continue;
+        }
+        if (c == '/' && next == '*') {
+            skipBlockComment();
+            continue;
+        }
+        if (c == '#' && atLineStart_) {
+            handlePreprocessor();
+            continue;
+        }
+
+        atLineStart_ = false;
+        size_t start = pos_;
+
+        if (isIdentStart(c)) {
+            while (pos_ < size && isIdentChar(source_[pos_])) {
+                pos_++;
+            }
+            std::string_view word = source_.substr(start, pos_ - start);
+            char following = pos_ < size ? source_[pos_] : 0;
+
+            if (following == '"' &&
+                (word == "R" || word == "u8R" || word == "uR" || word == "UR" || word == "LR")) {
+                skipRawString();
+                return Token{TokenKind::Literal, start, pos_ - start};
+            }
+            if ((following == '"' || following == '\'') &&
+                (word == "u8" || word == "u" || word == "U" || word == "L")) {
+                skipQuoted(following);
+                return Token{TokenKind::Literal, start, pos_ - start};
+            }
+            return Token{TokenKind::Identifier, start, pos_ - start};
+        }
+
+        if (isDigit(c) || (c == '.' && isDigit(next))) {
+            skipNumber();
+            return Token{TokenKind::Literal, start, pos_ - start};
+        }
+
+        if (c == '"' || c == '\'') {
+            skipQuoted(static_cast<char>(c));
+            return Token{TokenKind::Literal, start, pos_ - start};
+        }
+
+        // Only the multi-character operators the parser cares about are merged
+        if ((c == ':' && next == ':') || (c == '-' && next == '>') || (c == '&' && next == '&')) {
+            pos_ += 2;
+            return Token{TokenKind::Punct, start, 2};
+        }
+
+        pos_++;
+        return Token{TokenKind::Punct, start, 1};
+    }
+
+    return Token{TokenKind::End, size, 0};
+}
+
+void CppLexer::skipLineComment() {
+    const size_t size = source_.size();
+    while (pos_ < size && source_[pos_] != '\n') {
+        // A backslash at the end of a // comment continues it onto the next line
+        if (source_[pos_] == '\\' && pos_ + 1 < size &&
+            (source_[pos_ + 1] == '\n' || source_[pos_ + 1] == '\r')) {
+            pos_ += source_[pos_ + 1] == '\r' && pos_ + 2 < size && source_[pos_ + 2] == '\n' ? 3 : 2;
+            continue;
+        }
+        pos_++;
+    }
+}
+
+void CppLexer::skipBlockComment() {
+    size_t end = source_.find("*/", pos_ + 2);
+    size_t stop = end == std::string_view::npos ? source_.size() : end + 2;
+    if (source_.substr(pos_, stop - pos_).find('\n') != std::string_view::npos) {
+        atLineStart_ = true;
+    }
+    pos_ = stop;
+}
+
+void CppLexer::skipQuoted(char quote) {
+    const size_t size = source_.size();
+    pos_++;
+    while (pos_ < size) {
+        char c = source_[pos_];
+        if (c == '\\') {
+            pos_ = std::min(pos_ + 2, size);
+            continue;
+        }
+        if (c == quote) {
+            pos_++;
+            return;
+        }
+        if (c == '\n') {
+            // Unterminated literal: stop at the end of the line
+            return;
+        }
+        pos_++;
+    }
+}
+
+void CppLexer::skipRawString() {
+    const size_t size = source_.size();
+    size_t delimStart = pos_ + 1;
+    size_t open = delimStart;
+    while (open < size && open - delimStart <= 16 && source_[open] != '(') {
+        char c = source_[open];
+        if (c == ')' || c == '\\' || c == '"' || c == '\n' || isBlank(c)) {
+            break;
+        }
+        open++;
+    }
+
+    if (open >= size || source_[open] != '(') {
+        // Not a valid raw string prefix, treat it as an ordinary literal
+        skipQuoted('"');
+        return;
+    }
+
+    std::string closing = ")";
+    closing.append(source_.substr(delimStart, open - delimStart));
+    closing.push_back('"');
+
+    size_t end = source_.find(closing, open + 1);
+    pos_ = end == std::string_view::npos ? size : end + closing.size();
+}
+
+void CppLexer::skipNumber() {
+    const size_t size = source_.size();
+    pos_++;
+    while (pos_ < size) {
+        char c = source_[pos_];
+        char prev = source_[pos_ - 1];
+        if (isIdentChar(c) || c == '.') {
+            pos_++;
+        } else if (c == '\'' && pos_ + 1 < size && isIdentChar(source_[pos_ + 1])) {
+            // Digit separator
+            pos_++;
+        } else if ((c == '+' || c == '-') &&
+                   (prev == 'e' || prev == 'E' || prev == 'p' || prev == 'P')) {
+            pos_++;
+        } else {
+            break;
+        }
+    }
+}
+
+void CppLexer::handlePreprocessor() {
+    const size_t size = source_.size();
+    size_t directiveStart = pos_;
+    pos_++;
+
+    while (pos_ < size && isBlank(source_[pos_])) {
+        pos_++;
+    }
+    size_t nameStart = pos_;
+    while (pos_ < size && isIdentChar(source_[pos_])) {
+        pos_++;
+    }
+    std::string_view directive = source_.substr(nameStart, pos_ - nameStart);
+
+    if (directive == "include" || directive == "include_next" || directive == "import") {
+        while (pos_ < size && isBlank(source_[pos_])) {
+            pos_++;
+        }
+        if (pos_ < size && (source_[pos_] == '<' || source_[pos_] == '"')) {
+            char close = source_[pos_] == '<' ? '>' : '"';
+            size_t pathStart = pos_ + 1;
+            size_t pathEnd = pathStart;
+            while (pathEnd < size && source_[pathEnd] != close && source_[pathEnd] != '\n') {
+                pathEnd++;
+            }
+            if (pathEnd < size && source_[pathEnd] == close && pathEnd > pathStart) {
+                symbols_.push_back(LexedSymbol{std::string(source_.substr(pathStart, pathEnd - pathStart)),
+                                               "include", directiveStart, pathEnd + 1 - directiveStart});
+                pos_ = pathEnd + 1;
+            }
+        }
+    }
+
+    // Skip the rest of the directive, honoring line splices and comments
+    while (pos_ < size) {
+        char c = source_[pos_];
+        if (c == '\n') {
+            return;
+        }
+        if (c == '\\' && pos_ + 1 < size && (source_[pos_ + 1] == '\n' || source_[pos_ + 1] == '\r')) {
+            pos_ += source_[pos_ + 1] == '\r' && pos_ + 2 < size && source_[pos_ + 2] == '\n' ? 3 : 2;
+            continue;
+        }
+        if (c == '/' && pos_ + 1 < size && source_[pos_ + 1] == '/') {
+            skipLineComment();
+            return;
+        }
+        if (c == '/' && pos_ + 1 < size && source_[pos_ + 1] == '*') {
+            bool wasAtLineStart = atLineStart_;
+            skipBlockComment();
+            atLineStart_ = wasAtLineStart;
+            continue;
+        }
+        if (c == '"') {
+            skipQuoted('"');
+            continue;
+        }
+        pos_++;
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Parsing
+// ---------------------------------------------------------------------------
+
+void CppLexer::consume(const Token& token) {
+    if (statementStart_ == kNoStatement) {
+        statementStart_ = token.offset;
+    }
+
+    if (pending_ != Pending::None && consumePending(token)) {
+        pushHistory(token);
+        return;
+    }
+
+    if (token.kind == TokenKind::Identifier) {
+        std::string_view word = text(token);
+        bool afterEnum = prev_[0].kind == TokenKind::Identifier && text(prev_[0]) == "enum";
+
+        if ((word == "class" || word == "struct") && !afterEnum && parenDepth_ == 0) {
+            pending_ = Pending::ClassHead;
+            pendingType_ = std::string(word);
+            pendingName_ = std::string_view();
+            pendingAngleDepth_ = 0;
+        } else if (word == "namespace" && parenDepth_ == 0) {
+            pending_ = Pending::NamespaceHead;
+            pendingType_ = "namespace";
+            pendingName_ = std::string_view();
+        }
+    } else if (token.kind == TokenKind::Punct) {
+        if (isPunct(token, "(")) {
+            if (parenDepth_ == 0 && canDeclareFunctions() && isFunctionCandidate(prev_[0])) {
+                pending_ = Pending::FunctionArgs;
+                pendingName_ = text(prev_[0]);
+                if (isPunct(prev_[1], "~") && prev_[1].offset + 1 == prev_[0].offset) {
+                    // Keep the tilde so destructors are distinguishable
+                    pendingName_ = source_.substr(prev_[1].offset, prev_[0].offset + prev_[0].length - prev_[1].offset);
+                }
+                pendingType_ = "function";
+                pendingTrailingReturn_ = false;
+            }
+            parenDepth_++;
+        } else if (isPunct(token, ")")) {
+            if (parenDepth_ > 0) {
+                parenDepth_--;
+            }
+        } else if (isPunct(token, "{")) {
+            if (parenDepth_ > 0) {
+                nestedBraces_++;
+            } else {
+                ScopeKind current = scopes_.empty() ? ScopeKind::Namespace : scopes_.back();
+                if (current == ScopeKind::Function || current == ScopeKind::Block) {
+                    openScope(current, std::string_view());
+                } else if (prev_[0].kind == TokenKind::Literal && prev_[1].kind == TokenKind::Identifier &&
+                           text(prev_[1]) == "extern") {
+                    // extern "C" { ... } behaves like a namespace
+                    openScope(ScopeKind::Namespace, std::string_view());
+                } else {
+                    // Initializers, enum bodies, lambdas at namespace scope
+                    openScope(ScopeKind::Block, std::string_view());
+                }
+                resetStatement();
+            }
+        } else if (isPunct(token, "}")) {
+            if (parenDepth_ > 0 && nestedBraces_ > 0) {
+                nestedBraces_--;
+            } else {
+                parenDepth_ = 0;
+                nestedBraces_ = 0;
+                closeScope();
+                resetStatement();
+            }
+        } else if (isPunct(token, ";")) {
+            if (parenDepth_ == 0) {
+                resetStatement();
+            }
+        } else if (isPunct(token, ":")) {
+            // Access specifiers and bit-fields end a member "statement"
+            if (parenDepth_ == 0 && !scopes_.empty() && scopes_.back() == ScopeKind::Class) {
+                resetStatement();
+            }
+        } else if (isPunct(token, "=")) {
+            if (parenDepth_ == 0) {
+                statementHasAssign_ = true;
+            }
+        }
+    }
+
+    pushHistory(token);
+}
+
+bool CppLexer::consumePending(const Token& token) {
+    const bool isIdent = token.kind == TokenKind::Identifier;
+
+    switch (pending_) {
+    case Pending::ClassHead:
+    case Pending::ClassBases:
+        if (pending_ == Pending::ClassHead && parenDepth_ == 0) {
+            if (isIdent) {
+                if (text(token) != "final" && pendingAngleDepth_ == 0) {
+                    pendingName_ = text(token);
+                }
+                return true;
+            }
+            if (isPunct(token, "<")) {
+                pendingAngleDepth_++;
+                return true;
+            }
+            if (isPunct(token, ">")) {
+                if (pendingAngleDepth_ == 0) {
+                    // "class T>" in a template parameter list
+                    cancelPending();
+                    return false;
+                }
+                pendingAngleDepth_--;
+                return true;
+            }
+            if (isPunct(token, ",") || token.kind == TokenKind::Literal) {
+                if (pendingAngleDepth_ > 0) {
+                    return true;
+                }
+                cancelPending();
+                return false;
+            }
+            if (isPunct(token, ":")) {
+                pending_ = Pending::ClassBases;
+                return true;
+            }
+            if (isPunct(token, "::") || isPunct(token, "[") || isPunct(token, "]")) {
+                return true;
+            }
+        }
+        if (isPunct(token, "(")) {
+            parenDepth_++;
+            return true;
+        }
+        if (isPunct(token, ")")) {
+            if (parenDepth_ > 0) {
+                parenDepth_--;
+            }
+            return true;
+        }
+        if (parenDepth_ > 0) {
+            return true;
+        }
+        if (isPunct(token, "{")) {
+            std::string_view name = pendingName_;
+            if (!name.empty()) {
+                emit(name, pendingType_, statementStart_, token.offset);
+            }
+            pending_ = Pending::None;
+            openScope(ScopeKind::Class, name);
+            resetStatement();
+            return true;
+        }
+        if (pending_ == Pending::ClassBases && !isPunct(token, ";")) {
+            return true;
+        }
+        cancelPending();
+        return false;
+
+    case Pending::NamespaceHead:
+        if (isIdent) {
+            if (text(token) == "inline" && pendingName_.empty()) {
+                return true;
+            }
+            size_t begin = pendingName_.empty() ? token.offset
+                                                : static_cast<size_t>(pendingName_.data() - source_.data());
+            pendingName_ = source_.substr(begin, token.offset + token.length - begin);
+            return true;
+        }
+        if (isPunct(token, "::") || isPunct(token, "[") || isPunct(token, "]")) {
+            return true;
+        }
+        if (isPunct(token, "{")) {
+            if (!pendingName_.empty()) {
+                emit(pendingName_, "namespace", statementStart_, token.offset);
+            }
+            pending_ = Pending::None;
+            openScope(ScopeKind::Namespace, std::string_view());
+            resetStatement();
+            return true;
+        }
+        cancelPending();
+        return false;
+
+    case Pending::FunctionArgs:
+        if (isPunct(token, "(")) {
+            parenDepth_++;
+        } else if (isPunct(token, ")")) {
+            parenDepth_--;
+            if (parenDepth_ == 0) {
+                pending_ = Pending::FunctionTail;
+                pendingEnd_ = token.offset + token.length;
+            }
+        } else if (isPunct(token, ";")) {
+            // Unbalanced parentheses, most likely a macro
+            parenDepth_ = 0;
+            cancelPending();
+            return false;
+        }
+        return true;
+
+    case Pending::FunctionTail:
+        if (parenDepth_ > 0) {
+            // Inside noexcept(...), throw(...) or __attribute__((...))
+            if (isPunct(token, "(")) {
+                parenDepth_++;
+            } else if (isPunct(token, ")")) {
+                parenDepth_--;
+                pendingEnd_ = token.offset + token.length;
+            }
+            return true;
+        }
+        if (isPunct(token, "{")) {
+            emit(pendingName_, "function", statementStart_, pendingEnd_);
+            pending_ = Pending::None;
+            openScope(ScopeKind::Function, std::string_view());
+            resetStatement();
+            return true;
+        }
+        if (isPunct(token, ";")) {
+            emit(pendingName_, "function", statementStart_, pendingEnd_);
+            pending_ = Pending::None;
+            return false;
+        }
+        if (isPunct(token, ":")) {
+            emit(pendingName_, "function", statementStart_, pendingEnd_);
+            pending_ = Pending::CtorInit;
+            return true;
+        }
+        if (isPunct(token, "=")) {
+            pending_ = Pending::PureSpecifier;
+            return true;
+        }
+        if (isPunct(token, "(")) {
+            parenDepth_++;
+            return true;
+        }
+        if (isIdent || isPunct(token, "&") || isPunct(token, "&&") || isPunct(token, "*") ||
+            isPunct(token, "::") || isPunct(token, "[") || isPunct(token, "]") ||
+            isPunct(token, "<") || isPunct(token, ">")) {
+            pendingEnd_ = token.offset + token.length;
+            return true;
+        }
+        if (isPunct(token, "->")) {
+            pendingTrailingReturn_ = true;
+            pendingEnd_ = token.offset + token.length;
+            return true;
+        }
+        if (isPunct(token, ",") && pendingTrailingReturn_) {
+            pendingEnd_ = token.offset + token.length;
+            return true;
+        }
+        // "int x(5) + ...", "Foo a(1), b(2);" and similar: not a function
+        cancelPending();
+        return false;
+
+    case Pending::PureSpecifier:
+        if (isIdent || token.kind == TokenKind::Literal) {
+            return true;
+        }
+        if (isPunct(token, ";")) {
+            emit(pendingName_, "function", statementStart_, pendingEnd_);
+            pending_ = Pending::None;
+            return false;
+        }
+        cancelPending();
+        return false;
+
+    case Pending::CtorInit:
+        if (isPunct(token, "(")) {
+            parenDepth_++;
+        } else if (isPunct(token, ")")) {
+            if (parenDepth_ > 0) {
+                parenDepth_--;
+            }
+        } else if (isPunct(token, "{") && parenDepth_ == 0) {
+            bool memberInit = nestedBraces_ > 0 || prev_[0].kind == TokenKind::Identifier ||
+                              isPunct(prev_[0], ">");
+            if (memberInit) {
+                nestedBraces_++;
+            } else {
+                pending_ = Pending::None;
+                openScope(ScopeKind::Function, std::string_view());
+                resetStatement();
+            }
+        } else if (isPunct(token, "}") && parenDepth_ == 0 && nestedBraces_ > 0) {
+            nestedBraces_--;
+        } else if (isPunct(token, ";") && parenDepth_ == 0) {
+            nestedBraces_ = 0;
+            cancelPending();
+            return false;
+        }
+        return true;
+
+    case Pending::None:
+        break;
+    }
+
+    return false;
+}
+
+void CppLexer::openScope(ScopeKind kind, std::string_view name) {
+    scopes_.push_back(kind);
+    classNames_.push_back(kind == ScopeKind::Class ? name : std::string_view());
+}
+
+void CppLexer::closeScope() {
+    if (!scopes_.empty()) {
+        scopes_.pop_back();
+        classNames_.pop_back();
+    }
+}
+
+void CppLexer::resetStatement() {
+    statementStart_ = kNoStatement;
+    statementHasAssign_ = false;
+}
+
+void CppLexer::cancelPending() {
+    pending_ = Pending::None;
+    pendingName_ = std::string_view();
+}
+
+void CppLexer::pushHistory(const Token& token) {
+    prev_[1] = prev_[0];
+    prev_[0] = token;
+}
+
+void CppLexer::emit(std::string_view name, const std::string& type, size_t begin, size_t end) {
+    if (begin == kNoStatement || begin > end) {
+        return;
+    }
+    while (end > begin && (isBlank(source_[end - 1]) || source_[end - 1] == '\n')) {
+        end--;
+    }
+    symbols_.push_back(LexedSymbol{std::string(name), type, begin, end - begin});
+}
+
+bool CppLexer::canDeclareFunctions() const {
+    return scopes_.empty() || scopes_.back() == ScopeKind::Namespace || scopes_.back() == ScopeKind::Class;
+}
+
+bool CppLexer::isFunctionCandidate(const Token& name) const {
+    if (name.kind != TokenKind::Identifier || statementHasAssign_) {
+        return false;
+    }
+
+    std::string_view word = text(name);
+    if (isNonFunctionWord(word)) {
+        return false;
+    }
+
+    // First token of the statement: only a constructor declared in its class
+    if (name.offset == statementStart_) {
+        return !scopes_.empty() && scopes_.back() == ScopeKind::Class && classNames_.back() == word;
+    }
+
+    const Token& before = prev_[1];
+    if (before.kind == TokenKind::Identifier) {
+        return !isExpressionWord(text(before));
+    }
+    if (before.kind == TokenKind::Punct) {
+        return isPunct(before, "*") || isPunct(before, "&") || isPunct(before, "&&") ||
+               isPunct(before, ">") || isPunct(before, "~") || isPunct(before, "::");
+    }
+    return false;
+}
+
+std::string_view CppLexer::text(const Token& token) const {
+    return source_.substr(token.offset, token.length);
+}
+
+bool CppLexer::isPunct(const Token& token, std::string_view punct) const {
+    return token.kind == TokenKind::Punct && text(token) == punct;
+}
+
+}} // namespace codelve::scanner
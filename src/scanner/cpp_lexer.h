@@ -0,0 +1,114 @@
+// File: codelve/src/scanner/cpp_lexer.h
+#pragma once
+#include "lexer_common.h"
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace codelve {
+namespace scanner {
+
+/**
+ * Single-pass lexer for C and C++ sources.
+ *
+ * Skips comments, string/char literals (including raw strings) and
+ * preprocessor lines, and feeds the remaining tokens into a small state
+ * machine that recognizes includes, class/struct/namespace definitions and
+ * function declarations/definitions. Function bodies are tracked by brace
+ * depth so calls and local variables inside them are never reported.
+ */
+class CppLexer {
+public:
+    /**
+     * Constructor.
+     * @param source The source text; must outlive the lexer
+     */
+    explicit CppLexer(std::string_view source);
+
+    /**
+     * Scan the whole source once and return the symbols found, in source order.
+     * @return Extracted symbols
+     */
+    std::vector<LexedSymbol> extractSymbols();
+
+private:
+    enum class TokenKind {
+        Identifier,
+        Punct,
+        Literal,
+        End
+    };
+
+    struct Token {
+        TokenKind kind;
+        size_t offset;
+        size_t length;
+    };
+
+    enum class ScopeKind {
+        Namespace,
+        Class,
+        Function,
+        Block
+    };
+
+    // What the parser is waiting to complete
+    enum class Pending {
+        None,
+        ClassHead,       // after class/struct: collecting the name
+        ClassBases,      // after ':' in a class head, waiting for '{'
+        NamespaceHead,   // after namespace: collecting the name
+        FunctionArgs,    // inside the parameter list of a candidate
+        FunctionTail,    // after ')': qualifiers, then '{', ';', ':' or '='
+        PureSpecifier,   // after '= ' in a declaration: 0, default, delete
+        CtorInit         // constructor initializer list, waiting for the body
+    };
+
+    std::string_view source_;
+    size_t pos_;
+    bool atLineStart_;
+    std::vector<LexedSymbol> symbols_;
+
+    // Scope stack and the class names that go with Class scopes
+    std::vector<ScopeKind> scopes_;
+    std::vector<std::string_view> classNames_;
+
+    // Parser state
+    Pending pending_;
+    std::string_view pendingName_;
+    std::string pendingType_;
+    size_t pendingEnd_;
+    size_t pendingAngleDepth_;
+    bool pendingTrailingReturn_;
+    size_t statementStart_;
+    bool statementHasAssign_;
+    size_t parenDepth_;
+    size_t nestedBraces_;
+    Token prev_[2];
+
+    // Lexing
+    Token nextToken();
+    void skipLineComment();
+    void skipBlockComment();
+    void skipQuoted(char quote);
+    void skipRawString();
+    void skipNumber();
+    void handlePreprocessor();
+
+    // Parsing
+    void consume(const Token& token);
+    bool consumePending(const Token& token);
+    void openScope(ScopeKind kind, std::string_view name);
+    void closeScope();
+    void resetStatement();
+    void pushHistory(const Token& token);
+    void emit(std::string_view name, const std::string& type, size_t begin, size_t end);
+    void cancelPending();
+    bool canDeclareFunctions() const;
+    bool isFunctionCandidate(const Token& name) const;
+
+    std::string_view text(const Token& token) const;
+    bool isPunct(const Token& token, std::string_view punct) const;
+};
+
+}} // namespace codelve::scanner
@@ -0,0 +1,326 @@
+// File: codelve/src/scanner/directory_walker.cpp
+#include "directory_walker.h"
+#include "../utils/logger.h"
+#include "../utils/thread_pool.h"
+#include <algorithm>
+#include <condition_variable>
+#include <mutex>
+
+namespace codelve {
+namespace scanner {
+
+// A directory of the walk. With read-ahead a worker reads it and queues
+// its subdirectories at once; skipping a directory for ignore rules
+// cancels its token, which stops the reads of everything below it.
+struct DirectoryWalker::Node {
+    struct Token {
+        std::atomic<bool> cancelled{false};
+        std::shared_ptr<const Token> parent;
+    };
+
+    Node(std::string directoryPath, std::shared_ptr<const Token> parentToken)
+        : path(std::move(directoryPath)),
+          token(std::make_shared<Token>()),
+          cached(false),
+          opened(false),
+          read(false) {
+        token->parent = std::move(parentToken);
+    }
+
+    bool isCancelled() const {
+        for (const Token* link = token.get(); link; link = link->parent.get()) {
+            if (link->cancelled) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    std::string path;
+    std::shared_ptr<Token> token;
+
+    // What reading found, in iteration order; excluded names are left out
+    Listing listing;
+    std::vector<std::pair<std::string, FileStamp>> files;
+    std::vector<std::string> subdirectories;
+    bool cached;
+    bool opened;
+    std::string error;
+
+    // One per subdirectory, queued for reading (read-ahead only)
+    std::vector<std::shared_ptr<Node>> children;
+
+    // Set under the walk's mutex once the node is read or skipped
+    bool read;
+};
+
+DirectoryWalker::DirectoryWalker(std::vector<std::string> excludeDirectories)
+    : excludeDirectories_(std::move(excludeDirectories)),
+      visitedDirectories_(0),
+      pendingDirectories_(0),
+      prunedDirectories_(0),
+      finished_(false),
+      reusedDirectories_(0),
+      ignoredDirectories_(0),
+      ignoredFiles_(0),
+      ignoreFiles_(false),
+      threadCount_(1),
+      previousListings_(nullptr),
+      currentListings_(nullptr),
+      trustBefore_(0) {
+}
+
+void DirectoryWalker::setListingCache(const ListingCache* previous, ListingCache* current, int64_t trustBefore) {
+    previousListings_ = previous;
+    currentListings_ = current;
+    trustBefore_ = trustBefore;
+}
+
+void DirectoryWalker::setIgnoreFiles(bool enabled) {
+    ignoreFiles_ = enabled;
+}
+
+void DirectoryWalker::setThreadCount(size_t threadCount) {
+    threadCount_ = std::max<size_t>(threadCount, 1);
+}
+
+void DirectoryWalker::walk(const std::string& rootPath,
+                           const DirectoryCallback& onDirectory,
+                           const FileCallback& onFile) {
+    finished_ = false;
+
+    // Read-ahead state; the pool is declared last so it is joined first
+    std::mutex readMutex;
+    std::condition_variable nodeRead;
+    std::atomic<bool> stopping(false);
+    std::function<void(std::shared_ptr<Node>)> readAhead;
+    std::unique_ptr<utils::WorkStealingPool> pool;
+    if (threadCount_ > 1) {
+        pool.reset(new utils::WorkStealingPool(threadCount_));
+        readAhead = [&](std::shared_ptr<Node> node) {
+            pool->submit([&, node](size_t) {
+                if (!stopping && !node->isCancelled()) {
+                    readNode(*node);
+                    node->children.reserve(node->subdirectories.size());
+                    for (const auto& name : node->subdirectories) {
+                        node->children.push_back(std::make_shared<Node>(joinPath(node->path, name), node->token));
+                        readAhead(node->children.back());
+                    }
+                }
+                {
+                    std::lock_guard<std::mutex> lock(readMutex);
+                    node->read = true;
+                }
+                nodeRead.notify_all();
+            });
+        };
+    }
+
+    // Explicit stack instead of recursive_directory_iterator, so excluded
+    // directories are never pushed and therefore never opened
+    std::vector<Frame> stack;
+    stack.push_back(Frame{std::make_shared<Node>(rootPath, nullptr), std::string(), nullptr});
+    pendingDirectories_ = 1;
+    if (pool) {
+        readAhead(stack.back().node);
+    }
+
+    bool stopped = false;
+
+    while (!stack.empty() && !stopped) {
+        Frame frame = std::move(stack.back());
+        stack.pop_back();
+        pendingDirectories_--;
+        visitedDirectories_++;
+
+        Node& node = *frame.node;
+        if (pool) {
+            std::unique_lock<std::mutex> lock(readMutex);
+            nodeRead.wait(lock, [&node]() { return node.read; });
+        } else {
+            readNode(node);
+        }
+
+        const std::string& directoryPath = node.path;
+        if (!node.opened) {
+            utils::Logger::log(utils::LogLevel::WARNING, "DirectoryWalker: Cannot open directory: " +
+                                                          directoryPath + " (" + node.error + ")");
+            continue;
+        }
+        if (!node.error.empty()) {
+            utils::Logger::log(utils::LogLevel::WARNING, "DirectoryWalker: Error reading directory: " +
+                                                          directoryPath + " (" + node.error + ")");
+        }
+        if (node.cached) {
+            reusedDirectories_++;
+        }
+        prunedDirectories_ += node.listing.pruned;
+
+        const auto& files = node.files;
+        std::shared_ptr<const IgnoreScope> scope = std::move(frame.scope);
+        if (ignoreFiles_) {
+            bool hasIgnoreFile = std::any_of(files.begin(), files.end(), [](const std::pair<std::string, FileStamp>& file) {
+                return IgnoreScope::isIgnoreFile(file.first);
+            });
+            if (hasIgnoreFile) {
+                scope = IgnoreScope::enter(std::move(scope), directoryPath, frame.relativePath);
+            }
+        }
+        auto childPath = [&frame](const std::string& name) {
+            return frame.relativePath.empty() ? name : frame.relativePath + "/" + name;
+        };
+
+        for (const auto& file : files) {
+            if (scope && IgnoreScope::isIgnored(scope.get(), childPath(file.first), false)) {
+                ignoredFiles_++;
+                continue;
+            }
+            if (!onFile(joinPath(directoryPath, file.first), file.second)) {
+                stopped = true;
+                break;
+            }
+        }
+
+        // A listing cut short by the callback is incomplete and not recorded
+        if (currentListings_ && !stopped) {
+            (*currentListings_)[directoryPath] = std::move(node.listing);
+        }
+
+        // Report siblings in iteration order, then push them in reverse so
+        // they are also visited in that order
+        const auto& subdirectories = node.subdirectories;
+        std::vector<Frame> children;
+        children.reserve(stopped ? 0 : subdirectories.size());
+        for (size_t i = 0; !stopped && i < subdirectories.size(); i++) {
+            std::string relativePath = ignoreFiles_ ? childPath(subdirectories[i]) : std::string();
+            std::shared_ptr<Node> child = pool ? node.children[i]
+                                               : std::make_shared<Node>(joinPath(directoryPath, subdirectories[i]), nullptr);
+            if (scope && IgnoreScope::isIgnored(scope.get(), relativePath, true)) {
+                ignoredDirectories_++;
+                utils::Logger::log(utils::LogLevel::DEBUG, "DirectoryWalker: Skipping ignored directory: " + child->path);
+                child->token->cancelled = true;
+                continue;
+            }
+            if (onDirectory) {
+                onDirectory(child->path);
+            }
+            children.push_back(Frame{std::move(child), std::move(relativePath), scope});
+        }
+        for (size_t i = children.size(); i-- > 0; ) {
+            stack.push_back(std::move(children[i]));
+            pendingDirectories_++;
+        }
+    }
+
+    // Reads still queued are dropped; running ones may still queue more
+    stopping = true;
+    if (pool) {
+        pool->wait();
+    }
+
+    pendingDirectories_ = 0;
+    finished_ = true;
+}
+
+void DirectoryWalker::readNode(Node& node) const {
+    FileStamp directoryStamp;
+    bool haveStamp = (previousListings_ || currentListings_) && statPath(node.path, directoryStamp);
+
+    // Entries added, removed or renamed bump the directory mtime, so an
+    // unchanged mtime means the recorded listing is still complete
+    const Listing* cached = nullptr;
+    if (haveStamp && previousListings_) {
+        auto found = previousListings_->find(node.path);
+        if (found != previousListings_->end() && found->second.mtime >= 0 &&
+            found->second.mtime == directoryStamp.mtime) {
+            cached = &found->second;
+        }
+    }
+
+    Listing& listing = node.listing;
+    listing.mtime = haveStamp && directoryStamp.mtime < trustBefore_ ? directoryStamp.mtime : -1;
+    listing.pruned = 0;
+
+    // Gather the entries first: the directory's own ignore files apply to them
+    if (cached) {
+        node.cached = true;
+        node.opened = true;
+        listing.pruned = cached->pruned;
+
+        for (const auto& name : cached->files) {
+            FileStamp stamp;
+            if (!statPath(joinPath(node.path, name), stamp) || !stamp.isRegular) {
+                continue;
+            }
+            node.files.emplace_back(name, stamp);
+        }
+        node.subdirectories = cached->directories;
+    } else {
+        std::vector<std::string> directories;
+        node.opened = listDirectory(node.path, node.files, directories, node.error);
+        if (!node.opened) {
+            return;
+        }
+
+        node.subdirectories.reserve(directories.size());
+        for (auto& name : directories) {
+            if (isExcluded(name)) {
+                listing.pruned++;
+                utils::Logger::log(utils::LogLevel::DEBUG, "DirectoryWalker: Pruning excluded directory: " +
+                                                            joinPath(node.path, name));
+                continue;
+            }
+            node.subdirectories.push_back(std::move(name));
+        }
+        if (!node.error.empty()) {
+            listing.mtime = -1;
+        }
+    }
+
+    if (currentListings_) {
+        listing.files.reserve(node.files.size());
+        for (const auto& file : node.files) {
+            listing.files.push_back(file.first);
+        }
+        listing.directories = node.subdirectories;
+    }
+}
+
+size_t DirectoryWalker::estimateTotal(size_t itemsSoFar) const {
+    if (finished_) {
+        return itemsSoFar;
+    }
+
+    size_t visited = std::max<size_t>(visitedDirectories_.load(), 1);
+    size_t pending = pendingDirectories_.load();
+
+    // Assume the directories still to come are as dense as those seen so far
+    size_t estimate = itemsSoFar + (itemsSoFar * pending) / visited;
+    return std::max<size_t>(estimate, itemsSoFar + 1);
+}
+
+bool DirectoryWalker::isFinished() const {
+    return finished_;
+}
+
+size_t DirectoryWalker::getPrunedCount() const {
+    return prunedDirectories_;
+}
+
+size_t DirectoryWalker::getReusedCount() const {
+    return reusedDirectories_;
+}
+
+size_t DirectoryWalker::getIgnoredDirectoryCount() const {
+    return ignoredDirectories_;
+}
+
+size_t DirectoryWalker::getIgnoredFileCount() const {
+    return ignoredFiles_;
+}
+
+bool DirectoryWalker::isExcluded(const std::string& name) const {
+    return std::find(excludeDirectories_.begin(), excludeDirectories_.end(), name) != excludeDirectories_.end();
+}
+
+}} // namespace codelve::scanner
@@ -0,0 +1,179 @@
+// File: codelve/src/scanner/directory_walker.h
+#pragma once
+#include "file_system.h"
+#include "ignore_rules.h"
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <functional>
+#include <atomic>
+#include <cstdint>
+
+namespace codelve {
+namespace scanner {
+
+/**
+ * Walks a directory tree once, depth first, pruning excluded directories
+ * before they are opened. Keeps running counters so callers can estimate
+ * the total amount of work while the walk is still in progress.
+ *
+ * Given the listings recorded by an earlier walk, directories whose mtime
+ * is unchanged are not read again; their recorded entries are replayed and
+ * only the files themselves are stat'ed.
+ *
+ * With ignore files enabled, the .gitignore and .ignore files found along
+ * the way are honored like git does: ignored directories are pruned, and
+ * ignored files are not reported. Listings record entries before ignore
+ * rules are applied, so edited rules take effect on replayed listings too.
+ *
+ * With more than one thread, directories are read ahead on a pool: reading
+ * a directory queues reads of its subdirectories at once, so the tree is
+ * read in parallel while the walk itself, and every callback, still runs on
+ * the calling thread in depth-first order.
+ */
+class DirectoryWalker {
+public:
+    /**
+     * The entries of one directory as seen by a walk.
+     */
+    struct Listing {
+        int64_t mtime;                         // -1 if too recent to be trusted
+        std::vector<std::string> files;        // Regular file names
+        std::vector<std::string> directories;  // Subdirectory names, excluding pruned ones (ignored ones are kept)
+        size_t pruned;
+    };
+
+    /**
+     * Listings keyed by directory path.
+     */
+    using ListingCache = std::unordered_map<std::string, Listing>;
+
+    /**
+     * Called for every directory that is entered (never for pruned ones).
+     * @param path Path of the directory
+     */
+    using DirectoryCallback = std::function<void(const std::string& path)>;
+
+    /**
+     * Called for every regular file.
+     * @param path Path of the file
+     * @param stamp Size, mtime and inode of the file
+     * @return false to stop the walk
+     */
+    using FileCallback = std::function<bool(const std::string& path, const FileStamp& stamp)>;
+
+    /**
+     * Constructor.
+     * @param excludeDirectories Directory names that are never descended into
+     */
+    explicit DirectoryWalker(std::vector<std::string> excludeDirectories);
+
+    /**
+     * Reuse listings from an earlier walk and record the listings of the next one.
+     * @param previous Listings to reuse (may be null)
+     * @param current Receives the listings of the walk (may be null)
+     * @param trustBefore Directories modified at or after this time (see
+     *        currentFileTime()) are recorded as untrusted, since they may still
+     *        change within the same mtime tick
+     */
+    void setListingCache(const ListingCache* previous, ListingCache* current, int64_t trustBefore);
+
+    /**
+     * Honor .gitignore and .ignore files below the walk root.
+     * @param enabled true to read and apply ignore files
+     */
+    void setIgnoreFiles(bool enabled);
+
+    /**
+     * Read directories ahead on a pool of threads.
+     * @param threadCount Threads reading directories; 1 reads each one on the walking thread
+     */
+    void setThreadCount(size_t threadCount);
+
+    /**
+     * Walk the tree rooted at the given directory.
+     * @param rootPath Directory to walk
+     * @param onDirectory Directory callback (may be empty)
+     * @param onFile File callback
+     */
+    void walk(const std::string& rootPath,
+              const DirectoryCallback& onDirectory,
+              const FileCallback& onFile);
+
+    /**
+     * Estimate how many items the whole walk will produce, extrapolating from
+     * the directories still waiting to be visited. Safe to call from other
+     * threads while the walk runs.
+     * @param itemsSoFar Items the caller has accepted so far
+     * @return Estimated final item count (exact once the walk has finished)
+     */
+    size_t estimateTotal(size_t itemsSoFar) const;
+
+    /**
+     * Check whether the walk has finished.
+     * @return true once walk() has returned
+     */
+    bool isFinished() const;
+
+    /**
+     * Get the number of directories that were pruned.
+     * @return Pruned directory count
+     */
+    size_t getPrunedCount() const;
+
+    /**
+     * Get the number of directories whose recorded listing was reused.
+     * @return Reused directory count
+     */
+    size_t getReusedCount() const;
+
+    /**
+     * Get the number of directories skipped because ignore rules matched them.
+     * @return Ignored directory count
+     */
+    size_t getIgnoredDirectoryCount() const;
+
+    /**
+     * Get the number of files skipped because ignore rules matched them.
+     * @return Ignored file count
+     */
+    size_t getIgnoredFileCount() const;
+
+private:
+    // A directory and what reading it found (defined in directory_walker.cpp)
+    struct Node;
+
+    // A directory waiting to be visited
+    struct Frame {
+        std::shared_ptr<Node> node;
+        std::string relativePath;                   // '/'-separated, "" for the root
+        std::shared_ptr<const IgnoreScope> scope;   // Rules of the enclosing directories
+    };
+
+    // Directory names to prune
+    std::vector<std::string> excludeDirectories_;
+
+    // Running counters
+    std::atomic<size_t> visitedDirectories_;
+    std::atomic<size_t> pendingDirectories_;
+    std::atomic<size_t> prunedDirectories_;
+    std::atomic<bool> finished_;
+    size_t reusedDirectories_;
+    size_t ignoredDirectories_;
+    size_t ignoredFiles_;
+    bool ignoreFiles_;
+    size_t threadCount_;
+
+    // Listing cache, see setListingCache()
+    const ListingCache* previousListings_;
+    ListingCache* currentListings_;
+    int64_t trustBefore_;
+
+    bool isExcluded(const std::string& name) const;
+
+    // Read a directory, from its recorded listing if that is still valid;
+    // safe to call from several threads
+    void readNode(Node& node) const;
+};
+
+}} // namespace codelve::scanner
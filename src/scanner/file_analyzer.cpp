@@ -0,0 +1,279 @@
+// File: codelve/src/scanner/file_analyzer.cpp
+#include "file_analyzer.h"
+#include "lexer_common.h"
+#include "simd_common.h"
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+#include <utility>
+
+namespace codelve {
+namespace scanner {
+
+namespace {
+    // What \s matches in a std::regex under the classic locale
+    inline bool isSpace(unsigned char c) {
+        return isBlank(c) || c == '\n';
+    }
+
+    inline bool startsWith(std::string_view content, size_t offset, std::string_view prefix) {
+        return content.size() - offset >= prefix.size() &&
+               std::memcmp(content.data() + offset, prefix.data(), prefix.size()) == 0;
+    }
+
+    inline size_t skipSpaces(std::string_view content, size_t pos) {
+        while (pos < content.size() && isSpace(static_cast<unsigned char>(content[pos]))) {
+            pos++;
+        }
+        return pos;
+    }
+
+    inline bool isUpper(unsigned char c) {
+        return c >= 'A' && c <= 'Z';
+    }
+
+    // End of an upper-case name starting at pos, or pos if there is none
+    inline size_t skipUpperName(std::string_view content, size_t pos) {
+        if (pos >= content.size() || !isUpper(static_cast<unsigned char>(content[pos]))) {
+            return pos;
+        }
+        pos++;
+        while (pos < content.size()) {
+            unsigned char c = static_cast<unsigned char>(content[pos]);
+            if (!isUpper(c) && !isDigit(c) && c != '_') {
+                break;
+            }
+            pos++;
+        }
+        return pos;
+    }
+}
+
+const size_t FileAnalyzer::kMaxVectorTriggers;
+
+FileAnalyzer::FileAnalyzer()
+    : triggers_(1, '\n'),
+      lowNibbles_(),
+      highNibbles_(),
+      asciiTriggers_(true) {
+    for (size_t high = 0; high < 8; high++) {
+        highNibbles_[high] = static_cast<uint8_t>(1 << high);
+    }
+    lowNibbles_['\n' & 0x0f] |= highNibbles_['\n' >> 4];
+}
+
+void FileAnalyzer::addMatcher(std::unique_ptr<Matcher> matcher) {
+    size_t index = matchers_.size();
+    for (char trigger : matcher->getTriggers()) {
+        unsigned char byte = static_cast<unsigned char>(trigger);
+        std::vector<size_t>& at = matchersAt_[byte];
+        if (std::find(at.begin(), at.end(), index) != at.end()) {
+            continue;
+        }
+        at.push_back(index);
+        if (std::find(triggers_.begin(), triggers_.end(), byte) == triggers_.end()) {
+            triggers_.push_back(byte);
+            lowNibbles_[byte & 0x0f] |= highNibbles_[byte >> 4];
+            asciiTriggers_ = asciiTriggers_ && byte < 0x80;
+        }
+    }
+    matchers_.push_back(std::move(matcher));
+}
+
+size_t FileAnalyzer::getMatcherCount() const {
+    return matchers_.size();
+}
+
+void FileAnalyzer::analyze(std::string_view content, bool findSymbols, FileAnalysis& analysis) const {
+    const char* data = content.data();
+    const size_t size = content.size();
+    const size_t triggerCount = findSymbols ? triggers_.size() : 1;
+
+    // Source files average 30-40 bytes per line
+    std::vector<uint32_t> lineStarts;
+    lineStarts.reserve(size / 32 + 1);
+    lineStarts.push_back(0);
+
+    // Per matcher: where its next match may start, and what it found
+    std::vector<size_t> resumeAt(findSymbols ? matchers_.size() : 0, 0);
+    std::vector<std::vector<MatchedSymbol>> found(resumeAt.size());
+    MatchedSymbol symbol;
+
+    auto visit = [&](size_t pos) {
+        unsigned char byte = static_cast<unsigned char>(data[pos]);
+        uint32_t line = static_cast<uint32_t>(lineStarts.size());
+        if (byte == '\n') {
+            lineStarts.push_back(static_cast<uint32_t>(pos + 1));
+            if (!findSymbols) {
+                return;
+            }
+        }
+        for (size_t index : matchersAt_[byte]) {
+            if (pos < resumeAt[index]) {
+                continue;
+            }
+            size_t length = matchers_[index]->match(content, pos, symbol);
+            if (length == 0) {
+                continue;
+            }
+            symbol.line = line;
+            symbol.offset = pos;
+            symbol.length = length;
+            found[index].push_back(std::move(symbol));
+            symbol = MatchedSymbol();
+            resumeAt[index] = pos + length;
+        }
+    };
+
+    auto visitAll = [&](uint32_t mask, size_t base) {
+        while (mask != 0) {
+            visit(base + lowestBit(mask));
+            mask &= mask - 1;
+        }
+    };
+
+    size_t pos = 0;
+#if defined(CODELVE_SIMD_AVX2)
+    if (triggerCount > kMaxVectorTriggers && asciiTriggers_) {
+        const __m256i lowTable = _mm256_broadcastsi128_si256(
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(lowNibbles_.data())));
+        const __m256i highTable = _mm256_broadcastsi128_si256(
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(highNibbles_.data())));
+        const __m256i nibble = _mm256_set1_epi8(0x0f);
+        for (; pos + 32 <= size; pos += 32) {
+            __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + pos));
+            __m256i low = _mm256_shuffle_epi8(lowTable, _mm256_and_si256(chunk, nibble));
+            __m256i high = _mm256_shuffle_epi8(highTable, _mm256_and_si256(_mm256_srli_epi16(chunk, 4), nibble));
+            __m256i misses = _mm256_cmpeq_epi8(_mm256_and_si256(low, high), _mm256_setzero_si256());
+            visitAll(~static_cast<uint32_t>(_mm256_movemask_epi8(misses)), pos);
+        }
+    } else if (triggerCount <= kMaxVectorTriggers) {
+        __m256i needles[kMaxVectorTriggers];
+        for (size_t i = 0; i < triggerCount; i++) {
+            needles[i] = _mm256_set1_epi8(static_cast<char>(triggers_[i]));
+        }
+        for (; pos + 32 <= size; pos += 32) {
+            __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + pos));
+            __m256i hits = _mm256_cmpeq_epi8(chunk, needles[0]);
+            for (size_t i = 1; i < triggerCount; i++) {
+                hits = _mm256_or_si256(hits, _mm256_cmpeq_epi8(chunk, needles[i]));
+            }
+            visitAll(static_cast<uint32_t>(_mm256_movemask_epi8(hits)), pos);
+        }
+    }
+#elif defined(CODELVE_SIMD_SSE2)
+#if defined(CODELVE_SIMD_SSSE3)
+    if (triggerCount > kMaxVectorTriggers && asciiTriggers_) {
+        const __m128i lowTable = _mm_loadu_si128(reinterpret_cast<const __m128i*>(lowNibbles_.data()));
+        const __m128i highTable = _mm_loadu_si128(reinterpret_cast<const __m128i*>(highNibbles_.data()));
+        const __m128i nibble = _mm_set1_epi8(0x0f);
+        for (; pos + 16 <= size; pos += 16) {
+            __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + pos));
+            __m128i low = _mm_shuffle_epi8(lowTable, _mm_and_si128(chunk, nibble));
+            __m128i high = _mm_shuffle_epi8(highTable, _mm_and_si128(_mm_srli_epi16(chunk, 4), nibble));
+            __m128i misses = _mm_cmpeq_epi8(_mm_and_si128(low, high), _mm_setzero_si128());
+            visitAll(~static_cast<uint32_t>(_mm_movemask_epi8(misses)) & 0xffff, pos);
+        }
+    } else
+#endif
+    if (triggerCount <= kMaxVectorTriggers) {
+        __m128i needles[kMaxVectorTriggers];
+        for (size_t i = 0; i < triggerCount; i++) {
+            needles[i] = _mm_set1_epi8(static_cast<char>(triggers_[i]));
+        }
+        for (; pos + 16 <= size; pos += 16) {
+            __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + pos));
+            __m128i hits = _mm_cmpeq_epi8(chunk, needles[0]);
+            for (size_t i = 1; i < triggerCount; i++) {
+                hits = _mm_or_si128(hits, _mm_cmpeq_epi8(chunk, needles[i]));
+            }
+            visitAll(static_cast<uint32_t>(_mm_movemask_epi8(hits)), pos);
+        }
+    }
+#endif
+
+    // Tail, or the whole content without SIMD support or with many triggers
+    if (triggerCount == 1) {
+        while (pos < size) {
+            const void* newline = std::memchr(data + pos, '\n', size - pos);
+            if (newline == nullptr) {
+                break;
+            }
+            pos = static_cast<const char*>(newline) - data;
+            visit(pos++);
+        }
+    } else {
+        for (; pos < size; pos++) {
+            if (!matchersAt_[static_cast<unsigned char>(data[pos])].empty() || data[pos] == '\n') {
+                visit(pos);
+            }
+        }
+    }
+
+    analysis.lines = LineIndex(std::move(lineStarts), size);
+    analysis.symbols.clear();
+    for (auto& symbols : found) {
+        std::move(symbols.begin(), symbols.end(), std::back_inserter(analysis.symbols));
+    }
+}
+
+std::string_view TodoMatcher::getTriggers() const {
+    return "T";
+}
+
+size_t TodoMatcher::match(std::string_view content, size_t offset, MatchedSymbol& symbol) const {
+    if (!startsWith(content, offset, "TODO")) {
+        return 0;
+    }
+
+    // The spaces may run over line breaks; the text stops at the next one
+    size_t pos = skipSpaces(content, offset + 4);
+    if (pos < content.size() && content[pos] == ':') {
+        pos = skipSpaces(content, pos + 1);
+    }
+    size_t textBegin = pos;
+    while (pos < content.size() && content[pos] != '\n' && content[pos] != '\r') {
+        pos++;
+    }
+
+    symbol.name = "TODO";
+    symbol.kind = SymbolKind::Comment;
+    symbol.documentation.assign(content.data() + textBegin, pos - textBegin);
+    return pos - offset;
+}
+
+std::string_view ConstantMatcher::getTriggers() const {
+    return "c#";
+}
+
+size_t ConstantMatcher::match(std::string_view content, size_t offset, MatchedSymbol& symbol) const {
+    bool isDefine = content[offset] == '#';
+    std::string_view keyword = isDefine ? "#define" : "const";
+    if (!startsWith(content, offset, keyword)) {
+        return 0;
+    }
+
+    size_t nameBegin = skipSpaces(content, offset + keyword.size());
+    if (nameBegin == offset + keyword.size()) {
+        return 0;
+    }
+    size_t nameEnd = skipUpperName(content, nameBegin);
+    if (nameEnd == nameBegin) {
+        return 0;
+    }
+
+    size_t end = nameEnd;
+    if (!isDefine) {
+        end = skipSpaces(content, nameEnd);
+        if (end == content.size() || content[end] != '=') {
+            return 0;
+        }
+        end++;
+    }
+
+    symbol.name.assign(content.data() + nameBegin, nameEnd - nameBegin);
+    symbol.kind = SymbolKind::Constant;
+    return end - offset;
+}
+
+}} // namespace codelve::scanner
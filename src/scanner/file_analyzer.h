@@ -0,0 +1,142 @@
+// File: codelve/src/scanner/file_analyzer.h
+#pragma once
+#include "line_index.h"
+#include "symbol_table.h"
+#include <array>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+namespace codelve {
+namespace scanner {
+
+/**
+ * A symbol found by one of the matchers of a FileAnalyzer.
+ */
+struct MatchedSymbol {
+    std::string name;
+    SymbolKind kind;
+    std::string documentation;
+    uint32_t line;
+    size_t offset;
+    size_t length;
+};
+
+/**
+ * What one pass over a file found.
+ */
+struct FileAnalysis {
+    LineIndex lines;
+
+    // Grouped by matcher in the order the matchers were added, each group
+    // in source order
+    std::vector<MatchedSymbol> symbols;
+};
+
+/**
+ * Indexes a file's lines and runs every registered matcher in one pass.
+ *
+ * Each matcher names the bytes its matches can start with. The pass looks
+ * for newlines and those bytes together, 32 or 16 at a time where the
+ * compiler targets AVX2 or SSE2, and calls only the matchers registered
+ * for the byte found. A few trigger bytes are compared one by one; more
+ * are looked up by their two nibbles in a pair of 16-entry tables (AVX2 or
+ * SSSE3), which costs the same however many there are. Adding a matcher
+ * adds work at its own candidates, but no pass of its own over the file.
+ *
+ * Matches of one matcher do not overlap: like a regex search, the next
+ * one is looked for after the end of the last. Matchers of different
+ * kinds may match the same bytes.
+ */
+class FileAnalyzer {
+public:
+    /**
+     * An extractor run by the pass. Matchers keep no state between calls,
+     * so one analyzer can serve several threads at once.
+     */
+    class Matcher {
+    public:
+        virtual ~Matcher() = default;
+
+        /**
+         * Get the bytes a match can start with.
+         * @return The bytes, in any order
+         */
+        virtual std::string_view getTriggers() const = 0;
+
+        /**
+         * Try to match at an offset holding one of the trigger bytes.
+         * @param content The whole file; a match may read past the offset to its end
+         * @param offset Offset of the trigger byte
+         * @param symbol Receives the name, kind and documentation of the symbol found
+         * @return Length of the match, or 0 if there is none here
+         */
+        virtual size_t match(std::string_view content, size_t offset, MatchedSymbol& symbol) const = 0;
+    };
+
+    FileAnalyzer();
+
+    /**
+     * Register a matcher. Not safe while a pass runs.
+     * @param matcher The matcher
+     */
+    void addMatcher(std::unique_ptr<Matcher> matcher);
+
+    /**
+     * Get the number of registered matchers.
+     * @return Matcher count
+     */
+    size_t getMatcherCount() const;
+
+    /**
+     * Make one pass over a file. Safe to call from several threads.
+     * @param content The file contents
+     * @param findSymbols false to only index the lines
+     * @param analysis Receives the line index and the symbols found
+     */
+    void analyze(std::string_view content, bool findSymbols, FileAnalysis& analysis) const;
+
+private:
+    // Trigger bytes compared one by one; beyond this many they are looked
+    // up by nibble, or a byte at a time where that is not available
+    static const size_t kMaxVectorTriggers = 8;
+
+    std::vector<std::unique_ptr<Matcher>> matchers_;
+
+    // Distinct trigger bytes, the newline first
+    std::vector<unsigned char> triggers_;
+
+    // Matchers to try at each byte value, as indexes into matchers_
+    std::array<std::vector<size_t>, 256> matchersAt_;
+
+    // The trigger bytes as nibble tables: byte b is one if the entry for its
+    // low nibble has the bit of its high nibble set. Only for ASCII triggers.
+    std::array<uint8_t, 16> lowNibbles_;
+    std::array<uint8_t, 16> highNibbles_;
+    bool asciiTriggers_;
+};
+
+/**
+ * Finds TODO markers and the rest of their line, as the pattern
+ * TODO\s*:?\s*(.*) does. The text after the marker becomes the documentation.
+ */
+class TodoMatcher : public FileAnalyzer::Matcher {
+public:
+    std::string_view getTriggers() const override;
+    size_t match(std::string_view content, size_t offset, MatchedSymbol& symbol) const override;
+};
+
+/**
+ * Finds upper-case constants, as the pattern
+ * const\s+([A-Z][A-Z0-9_]*)\s*=|#define\s+([A-Z][A-Z0-9_]*) does.
+ */
+class ConstantMatcher : public FileAnalyzer::Matcher {
+public:
+    std::string_view getTriggers() const override;
+    size_t match(std::string_view content, size_t offset, MatchedSymbol& symbol) const override;
+};
+
+}} // namespace codelve::scanner
@@ -0,0 +1,556 @@
+// File: codelve/src/scanner/file_reader.cpp
+#include "file_reader.h"
+#include "file_system.h"
+#include "../utils/logger.h"
+#include <algorithm>
+#include <cstring>
+#include <iomanip>
+#include <memory>
+#include <sstream>
+
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+#define CODELVE_HAVE_IO_URING 1
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#endif
+
+#ifndef _WIN32
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#endif
+
+namespace codelve {
+namespace scanner {
+
+namespace {
+    // Threads of the pread pool, whatever the depth
+    const size_t kMaxReadThreads = 64;
+
+    // Count got bytes read into content at used, growing the buffer once it
+    // is full. The file is complete after a read that returned nothing, or
+    // one that came back short exactly at the size the walk saw.
+    bool advance(std::string& content, size_t& used, size_t got, uint64_t sizeHint) {
+        size_t asked = content.size() - used;
+        used += got;
+        if (got == 0 || (got < asked && used == sizeHint)) {
+            content.resize(used);
+            return true;
+        }
+        if (used == content.size()) {
+            content.resize(content.size() * 2 + 4096);
+        }
+        return false;
+    }
+
+    // Read a whole file. With dropPages its pages leave the page cache
+    // afterwards unless they were cached before; dropped tells which.
+    bool readWhole(const std::string& path, uint64_t sizeHint, bool dropPages, std::string& content, bool& dropped) {
+        dropped = false;
+#ifdef _WIN32
+        (void)sizeHint;
+        (void)dropPages;
+        MappedFile source;
+        if (!source.open(path)) {
+            return false;
+        }
+        content = source.takeContent();
+        return true;
+#else
+        int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            return false;
+        }
+        content.resize(static_cast<size_t>(sizeHint) + 1);
+        size_t used = 0;
+#ifdef RWF_NOWAIT
+        if (dropPages) {
+            struct iovec part = {&content[0], content.size()};
+            ssize_t got = preadv2(fd, &part, 1, 0, RWF_NOWAIT);
+            if (got < 0 && errno == EAGAIN) {
+                dropped = true;
+            } else if (got >= 0 && advance(content, used, static_cast<size_t>(got), sizeHint)) {
+                ::close(fd);
+                return true;
+            }
+        }
+#else
+        (void)dropPages;
+#endif
+        for (;;) {
+            ssize_t got = ::pread(fd, &content[used], content.size() - used, static_cast<off_t>(used));
+            if (got < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                ::close(fd);
+                content.clear();
+                return false;
+            }
+            if (advance(content, used, static_cast<size_t>(got), sizeHint)) {
+                break;
+            }
+        }
+        if (dropped) {
+            posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+        }
+        ::close(fd);
+        return true;
+#endif
+    }
+}
+
+#ifdef CODELVE_HAVE_IO_URING
+
+// An io_uring instance driven through its system calls. Each file has at
+// most one operation in the ring at a time, so a ring with an entry per
+// slot never fills up.
+struct FileReader::Ring {
+    // A file being opened, read or closed; the operation's user_data is its index
+    struct Slot {
+        size_t id;
+        std::string path;
+        uint64_t sizeHint;
+        int fd;
+        std::string content;
+        size_t used;
+        bool busy;
+        bool closing;
+
+        // The first read only takes cached data; if there is none, the
+        // file's pages are dropped once it is read
+        bool probing;
+        bool dropAfter;
+    };
+
+    int fd = -1;
+    void* sqRing = MAP_FAILED;
+    void* cqRing = MAP_FAILED;
+    size_t sqRingSize = 0;
+    size_t cqRingSize = 0;
+    io_uring_sqe* sqes = static_cast<io_uring_sqe*>(MAP_FAILED);
+    size_t sqesSize = 0;
+
+    unsigned* sqHead = nullptr;
+    unsigned* sqTail = nullptr;
+    unsigned sqMask = 0;
+    unsigned* sqArray = nullptr;
+    unsigned* cqHead = nullptr;
+    unsigned* cqTail = nullptr;
+    unsigned cqMask = 0;
+    io_uring_cqe* cqes = nullptr;
+
+    // Entries written since the last submission
+    unsigned unsubmitted = 0;
+
+    std::vector<Slot> slots;
+    std::vector<size_t> freeSlots;
+
+    ~Ring() {
+        if (sqes != MAP_FAILED) {
+            munmap(sqes, sqesSize);
+        }
+        if (cqRing != MAP_FAILED && cqRing != sqRing) {
+            munmap(cqRing, cqRingSize);
+        }
+        if (sqRing != MAP_FAILED) {
+            munmap(sqRing, sqRingSize);
+        }
+        if (fd >= 0) {
+            ::close(fd);
+        }
+    }
+
+    // Set the ring up and check that the kernel has the operations it needs
+    bool open(size_t slotCount) {
+        io_uring_params params;
+        std::memset(&params, 0, sizeof(params));
+        fd = static_cast<int>(syscall(__NR_io_uring_setup, static_cast<unsigned>(slotCount), &params));
+        if (fd < 0) {
+            return false;
+        }
+
+        sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        bool singleMap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+        if (singleMap) {
+            sqRingSize = cqRingSize = std::max(sqRingSize, cqRingSize);
+        }
+        sqRing = mmap(nullptr, sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+        if (sqRing == MAP_FAILED) {
+            return false;
+        }
+        cqRing = singleMap ? sqRing : mmap(nullptr, cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                                           fd, IORING_OFF_CQ_RING);
+        if (cqRing == MAP_FAILED) {
+            return false;
+        }
+        sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+        sqes = static_cast<io_uring_sqe*>(mmap(nullptr, sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                                               fd, IORING_OFF_SQES));
+        if (sqes == MAP_FAILED) {
+            return false;
+        }
+
+        char* sq = static_cast<char*>(sqRing);
+        char* cq = static_cast<char*>(cqRing);
+        sqHead = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+        sqTail = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+        sqMask = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+        sqArray = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+        cqHead = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+        cqTail = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+        cqMask = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+        cqes = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+
+        // Opening and closing through the ring came in 5.6
+        std::vector<io_uring_probe_op> probeBuffer(2 + 256);
+        io_uring_probe* probe = reinterpret_cast<io_uring_probe*>(probeBuffer.data());
+        if (syscall(__NR_io_uring_register, fd, IORING_REGISTER_PROBE, probe, 256) < 0) {
+            return false;
+        }
+        for (unsigned op : {IORING_OP_OPENAT, IORING_OP_READ, IORING_OP_CLOSE}) {
+            if (op > probe->last_op || !(probe->ops[op].flags & IO_URING_OP_SUPPORTED)) {
+                return false;
+            }
+        }
+
+        slots.resize(std::min<size_t>(slotCount, params.sq_entries));
+        for (size_t i = slots.size(); i-- > 0; ) {
+            freeSlots.push_back(i);
+        }
+        return true;
+    }
+
+    io_uring_sqe* prepare(uint8_t opcode, size_t slot) {
+        unsigned tail = *sqTail + unsubmitted;
+        unsigned index = tail & sqMask;
+        io_uring_sqe* sqe = &sqes[index];
+        std::memset(sqe, 0, sizeof(*sqe));
+        sqe->opcode = opcode;
+        sqe->user_data = slot;
+        sqArray[index] = index;
+        unsubmitted++;
+        return sqe;
+    }
+
+    void prepareOpen(size_t slot) {
+        io_uring_sqe* sqe = prepare(IORING_OP_OPENAT, slot);
+        sqe->fd = AT_FDCWD;
+        sqe->addr = reinterpret_cast<uint64_t>(slots[slot].path.c_str());
+        sqe->open_flags = O_RDONLY | O_CLOEXEC;
+    }
+
+    void prepareRead(size_t slot) {
+        Slot& file = slots[slot];
+        io_uring_sqe* sqe = prepare(IORING_OP_READ, slot);
+        sqe->fd = file.fd;
+        sqe->addr = reinterpret_cast<uint64_t>(&file.content[file.used]);
+        sqe->len = static_cast<uint32_t>(std::min<size_t>(file.content.size() - file.used, 1u << 30));
+        sqe->off = file.used;
+        if (file.probing) {
+            sqe->rw_flags = RWF_NOWAIT;
+        }
+    }
+
+    void prepareClose(size_t slot) {
+        // Dropping clean pages does no I/O, so it is not worth a ring entry
+        if (slots[slot].dropAfter) {
+            posix_fadvise(slots[slot].fd, 0, 0, POSIX_FADV_DONTNEED);
+        }
+        slots[slot].closing = true;
+        io_uring_sqe* sqe = prepare(IORING_OP_CLOSE, slot);
+        sqe->fd = slots[slot].fd;
+    }
+
+    // Submit what was prepared, and anything an earlier call left over,
+    // and wait for at least one completion
+    bool submitAndWait() {
+        __atomic_store_n(sqTail, *sqTail + unsubmitted, __ATOMIC_RELEASE);
+        unsubmitted = 0;
+        for (;;) {
+            unsigned toSubmit = *sqTail - __atomic_load_n(sqHead, __ATOMIC_ACQUIRE);
+            long result = syscall(__NR_io_uring_enter, fd, toSubmit, 1, IORING_ENTER_GETEVENTS, nullptr, 0);
+            if (result >= 0) {
+                return true;
+            }
+            if (errno != EINTR && errno != EAGAIN && errno != EBUSY) {
+                return false;
+            }
+        }
+    }
+};
+
+#else
+
+struct FileReader::Ring {
+};
+
+#endif
+
+const size_t FileReader::kNone;
+
+FileReader::FileReader(size_t depth, bool useIoUring, bool dropPages)
+    : depth_(std::max<size_t>(depth, 1)),
+      dropPages_(dropPages),
+      nextToStart_(0),
+      started_(0),
+      stopping_(false),
+      ring_(nullptr),
+      filesRead_(0),
+      bytesRead_(0),
+      bytesDropped_(0) {
+#ifdef CODELVE_HAVE_IO_URING
+    if (useIoUring) {
+        std::unique_ptr<Ring> ring(new Ring());
+        if (ring->open(depth_)) {
+            ring_ = ring.release();
+        } else {
+            utils::Logger::log(utils::LogLevel::INFO, "FileReader: io_uring is not available, reading with pread threads");
+        }
+    }
+#else
+    (void)useIoUring;
+#endif
+
+    if (ring_) {
+        threads_.emplace_back(&FileReader::ringLoop, this);
+    } else {
+        size_t threadCount = std::min(depth_, kMaxReadThreads);
+        for (size_t i = 0; i < threadCount; i++) {
+            threads_.emplace_back(&FileReader::readLoop, this);
+        }
+    }
+}
+
+FileReader::~FileReader() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    requestsChanged_.notify_all();
+    for (auto& thread : threads_) {
+        thread.join();
+    }
+    delete ring_;
+}
+
+size_t FileReader::add(const std::string& path, uint64_t sizeHint) {
+    size_t id;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        requests_.push_back(Request{path, sizeHint, State::Queued, std::string()});
+        id = requests_.size() - 1;
+    }
+    requestsChanged_.notify_all();
+    return id;
+}
+
+bool FileReader::take(size_t id, std::string& content) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    Request& request = requests_[id];
+    if (request.state == State::Queued) {
+        request.state = State::Withdrawn;
+        return false;
+    }
+    requestsChanged_.wait(lock, [&request]() { return request.state != State::Reading; });
+    if (request.state != State::Read) {
+        return false;
+    }
+    content = std::move(request.content);
+    request.content = std::string();
+    request.state = State::Taken;
+    started_--;
+    lock.unlock();
+    requestsChanged_.notify_all();
+    return true;
+}
+
+bool FileReader::isUsingIoUring() const {
+    return ring_ != nullptr;
+}
+
+std::string FileReader::getReport() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    double milliseconds = filesRead_ > 0 ?
+        std::chrono::duration<double, std::milli>(lastFinish_ - firstStart_).count() : 0.0;
+    double megabytes = bytesRead_ / (1024.0 * 1024.0);
+    std::ostringstream report;
+    report << std::fixed << std::setprecision(1) << filesRead_ << " files, " << megabytes << " MB in "
+           << milliseconds << " ms (" << (milliseconds > 0 ? megabytes * 1000.0 / milliseconds : 0.0) << " MB/s) ";
+    if (ring_) {
+        report << "through io_uring, " << depth_ << " files at once";
+    } else {
+        report << "with pread on " << threads_.size() << " threads";
+    }
+    if (dropPages_) {
+        report << "; dropped " << bytesDropped_ / (1024.0 * 1024.0) << " MB it brought into the page cache";
+    }
+    return report.str();
+}
+
+bool FileReader::startNext(size_t& id) {
+    while (nextToStart_ < requests_.size()) {
+        Request& request = requests_[nextToStart_];
+        if (request.state != State::Queued) {
+            nextToStart_++;
+            continue;
+        }
+        if (stopping_ || started_ >= depth_) {
+            return false;
+        }
+        if (firstStart_ == std::chrono::steady_clock::time_point()) {
+            firstStart_ = std::chrono::steady_clock::now();
+        }
+        request.state = State::Reading;
+        started_++;
+        id = nextToStart_++;
+        return true;
+    }
+    return false;
+}
+
+void FileReader::finish(size_t id, bool ok, std::string content, bool dropped) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        Request& request = requests_[id];
+        if (ok) {
+            request.state = State::Read;
+            filesRead_++;
+            bytesRead_ += content.size();
+            bytesDropped_ += dropped ? content.size() : 0;
+            request.content = std::move(content);
+        } else {
+            // Nothing to take, so the file stops counting against the depth now
+            request.state = State::Failed;
+            started_--;
+        }
+        lastFinish_ = std::chrono::steady_clock::now();
+    }
+    requestsChanged_.notify_all();
+}
+
+void FileReader::readLoop() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    for (;;) {
+        size_t id = kNone;
+        while (!startNext(id)) {
+            if (stopping_) {
+                return;
+            }
+            requestsChanged_.wait(lock);
+        }
+        std::string path = requests_[id].path;
+        uint64_t sizeHint = requests_[id].sizeHint;
+        lock.unlock();
+
+        std::string content;
+        bool dropped = false;
+        bool ok = readWhole(path, sizeHint, dropPages_, content, dropped);
+        finish(id, ok, std::move(content), dropped);
+        lock.lock();
+    }
+}
+
+void FileReader::ringLoop() {
+#ifdef CODELVE_HAVE_IO_URING
+    Ring& ring = *ring_;
+    size_t busySlots = 0;
+    bool failed = false;
+
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            size_t id = kNone;
+            while (!failed && !ring.freeSlots.empty() && startNext(id)) {
+                size_t slot = ring.freeSlots.back();
+                ring.freeSlots.pop_back();
+                Ring::Slot& file = ring.slots[slot];
+                file.id = id;
+                file.path = requests_[id].path;
+                file.sizeHint = requests_[id].sizeHint;
+                file.fd = -1;
+                file.used = 0;
+                file.busy = true;
+                file.closing = false;
+                file.probing = dropPages_;
+                file.dropAfter = false;
+                ring.prepareOpen(slot);
+                busySlots++;
+            }
+            if (busySlots == 0) {
+                if (stopping_ || failed) {
+                    return;
+                }
+                requestsChanged_.wait(lock);
+                continue;
+            }
+        }
+
+        if (!ring.submitAndWait()) {
+            // Leave the files to their takers, who read them themselves
+            utils::Logger::log(utils::LogLevel::WARNING, std::string("FileReader: io_uring failed: ") + std::strerror(errno));
+            for (auto& file : ring.slots) {
+                if (file.busy && !file.closing) {
+                    if (file.fd >= 0) {
+                        ::close(file.fd);
+                    }
+                    finish(file.id, false, std::string(), false);
+                }
+            }
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = true;
+            return;
+        }
+
+        unsigned head = *ring.cqHead;
+        unsigned tail = __atomic_load_n(ring.cqTail, __ATOMIC_ACQUIRE);
+        for (; head != tail; head++) {
+            const io_uring_cqe& cqe = ring.cqes[head & ring.cqMask];
+            size_t slot = static_cast<size_t>(cqe.user_data);
+            Ring::Slot& file = ring.slots[slot];
+            int result = cqe.res;
+
+            if (file.closing) {
+                file.content = std::string();
+                file.busy = false;
+                ring.freeSlots.push_back(slot);
+                busySlots--;
+            } else if (file.fd < 0) {
+                if (result < 0) {
+                    finish(file.id, false, std::string(), false);
+                    file.busy = false;
+                    ring.freeSlots.push_back(slot);
+                    busySlots--;
+                    continue;
+                }
+                file.fd = result;
+                file.content.resize(static_cast<size_t>(file.sizeHint) + 1);
+                ring.prepareRead(slot);
+            } else if (file.probing && result == -EAGAIN) {
+                // Not cached: read it for real, and drop it afterwards
+                file.probing = false;
+                file.dropAfter = true;
+                ring.prepareRead(slot);
+            } else if (result == -EINTR || result == -EAGAIN) {
+                file.probing = false;
+                ring.prepareRead(slot);
+            } else if (result < 0) {
+                finish(file.id, false, std::string(), false);
+                ring.prepareClose(slot);
+            } else if (advance(file.content, file.used, static_cast<size_t>(result), file.sizeHint)) {
+                finish(file.id, true, std::move(file.content), file.dropAfter);
+                ring.prepareClose(slot);
+            } else {
+                file.probing = false;
+                ring.prepareRead(slot);
+            }
+        }
+        __atomic_store_n(ring.cqHead, head, __ATOMIC_RELEASE);
+    }
+#endif
+}
+
+}} // namespace codelve::scanner
@@ -0,0 +1,147 @@
+// File: codelve/src/scanner/file_reader.h
+#pragma once
+#include <string>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+namespace codelve {
+namespace scanner {
+
+/**
+ * Reads whole files ahead of the threads that parse them.
+ *
+ * Files are queued in the order they will probably be wanted, and up to a
+ * fixed depth of them are read at once, so the device has requests queued
+ * even while every parser is busy. On Linux the reads go through io_uring:
+ * each file is an openat, reads until its end and a close, all issued from
+ * one thread that never blocks on any of them. Where io_uring is missing
+ * or disabled, a pool of threads reads with pread instead.
+ *
+ * A file counts against the depth from the start of its read until its
+ * contents are taken, so memory stays bounded however far reading runs
+ * ahead of parsing. Taking a file whose read has not started withdraws it,
+ * and the caller reads it itself instead of waiting behind the queue.
+ *
+ * Optionally, files are dropped from the page cache once read, but only
+ * those the reader brought in: the first read of a file is a non-blocking
+ * one that fails unless the data is already cached, so a scan streaming
+ * through a large tree neither keeps it cached nor evicts what the rest of
+ * the system had cached.
+ */
+class FileReader {
+public:
+    // Returned by add() when the file was not queued
+    static const size_t kNone = static_cast<size_t>(-1);
+
+    /**
+     * Constructor. Starts the reading thread or threads.
+     * @param depth Files read at once, at least 1
+     * @param useIoUring false to read with a pread thread pool even where io_uring works
+     * @param dropPages true to drop the pages of files that were not cached before their read
+     */
+    FileReader(size_t depth, bool useIoUring, bool dropPages);
+
+    /**
+     * Destructor. Withdraws queued reads, waits for those in flight and
+     * discards every result not taken.
+     */
+    ~FileReader();
+
+    FileReader(const FileReader&) = delete;
+    FileReader& operator=(const FileReader&) = delete;
+
+    /**
+     * Queue a file. Safe to call from several threads.
+     * @param path Path to the file
+     * @param sizeHint Expected size in bytes, as stat'ed by the walk
+     * @return Id to take the contents with
+     */
+    size_t add(const std::string& path, uint64_t sizeHint);
+
+    /**
+     * Take a file's contents, waiting if its read is under way. Each id can
+     * be taken once. Safe to call from several threads.
+     * @param id Id returned by add()
+     * @param content Receives the whole contents
+     * @return false if the read failed or had not started; the caller
+     *         should then read the file itself
+     */
+    bool take(size_t id, std::string& content);
+
+    /**
+     * Check whether reads go through io_uring.
+     * @return true for io_uring, false for the pread pool
+     */
+    bool isUsingIoUring() const;
+
+    /**
+     * Get a one-line summary: files and bytes read, wall time from the first
+     * read to the last, throughput, and bytes dropped from the page cache.
+     * @return Human-readable report
+     */
+    std::string getReport() const;
+
+private:
+    enum class State {
+        Queued,
+        Reading,
+        Read,
+        Failed,
+        Withdrawn,
+        Taken
+    };
+
+    struct Request {
+        std::string path;
+        uint64_t sizeHint;
+        State state;
+        std::string content;
+    };
+
+    // Submission and completion rings of io_uring (defined in file_reader.cpp)
+    struct Ring;
+
+    const size_t depth_;
+    const bool dropPages_;
+
+    // Every request by id; a deque keeps them in place as more are added
+    std::deque<Request> requests_;
+    size_t nextToStart_;
+
+    // Files started and not yet taken, at most depth_
+    size_t started_;
+    bool stopping_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable requestsChanged_;
+
+    Ring* ring_;
+    std::vector<std::thread> threads_;
+
+    // Work done, under mutex_
+    size_t filesRead_;
+    uint64_t bytesRead_;
+    uint64_t bytesDropped_;
+    std::chrono::steady_clock::time_point firstStart_;
+    std::chrono::steady_clock::time_point lastFinish_;
+
+    // Claim the next queued request once the depth allows; callers hold mutex_
+    bool startNext(size_t& id);
+
+    // Record the outcome of a read and wake whoever waits for it
+    void finish(size_t id, bool ok, std::string content, bool dropped);
+
+    // Body of each pread thread
+    void readLoop();
+
+    // Body of the io_uring thread
+    void ringLoop();
+};
+
+}} // namespace codelve::scanner
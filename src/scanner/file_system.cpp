@@ -0,0 +1,443 @@
+// File: codelve/src/scanner/file_system.cpp
+#include "file_system.h"
+
+#include <cstring>
+
+#ifdef _WIN32
+#include <fstream>
+#include <filesystem>
+#include <chrono>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <cerrno>
+#include <ctime>
+#endif
+#ifdef __linux__
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/fs.h>
+#include <linux/fiemap.h>
+#endif
+
+namespace codelve {
+namespace scanner {
+
+namespace {
+    inline uint64_t rotateLeft(uint64_t value, int bits) {
+        return (value << bits) | (value >> (64 - bits));
+    }
+
+    inline uint64_t mixFinal(uint64_t h) {
+        h ^= h >> 33;
+        h *= 0xff51afd7ed558ccdULL;
+        h ^= h >> 33;
+        h *= 0xc4ceb9fe1a85ec53ULL;
+        h ^= h >> 33;
+        return h;
+    }
+
+#ifdef _WIN32
+    const char kSeparator = '\\';
+#else
+    const char kSeparator = '/';
+
+    void fillStamp(const struct stat& info, FileStamp& stamp) {
+        stamp.size = static_cast<uint64_t>(info.st_size);
+#if defined(__APPLE__)
+        stamp.mtime = static_cast<int64_t>(info.st_mtimespec.tv_sec) * 1000000000LL + info.st_mtimespec.tv_nsec;
+#else
+        stamp.mtime = static_cast<int64_t>(info.st_mtim.tv_sec) * 1000000000LL + info.st_mtim.tv_nsec;
+#endif
+        stamp.inode = static_cast<uint64_t>(info.st_ino);
+        stamp.isRegular = S_ISREG(info.st_mode);
+        stamp.isDirectory = S_ISDIR(info.st_mode);
+    }
+
+    // Sort one entry of an open directory into files or directories, given
+    // its type as the directory reported it (DT_UNKNOWN if it did not)
+    void addEntry(int directoryFd,
+                  const char* name,
+                  unsigned char type,
+                  std::vector<std::pair<std::string, FileStamp>>& files,
+                  std::vector<std::string>& directories) {
+        if (name[0] == '.' && (name[1] == '\0' || (name[1] == '.' && name[2] == '\0'))) {
+            return;
+        }
+        if (type == DT_DIR) {
+            directories.emplace_back(name);
+            return;
+        }
+        if (type != DT_REG && type != DT_LNK && type != DT_UNKNOWN) {
+            return;
+        }
+
+        struct stat info;
+        if (type == DT_UNKNOWN) {
+            if (fstatat(directoryFd, name, &info, AT_SYMLINK_NOFOLLOW) != 0) {
+                return;
+            }
+            if (S_ISDIR(info.st_mode)) {
+                directories.emplace_back(name);
+                return;
+            }
+            if (!S_ISREG(info.st_mode) && !S_ISLNK(info.st_mode)) {
+                return;
+            }
+        }
+
+        // Symlinks count as what they point to, but directories are not followed
+        if ((type != DT_UNKNOWN || S_ISLNK(info.st_mode)) &&
+            (fstatat(directoryFd, name, &info, 0) != 0 || !S_ISREG(info.st_mode))) {
+            return;
+        }
+        FileStamp stamp;
+        fillStamp(info, stamp);
+        files.emplace_back(name, stamp);
+    }
+#endif
+}
+
+bool statPath(const std::string& path, FileStamp& stamp) {
+#ifdef _WIN32
+    namespace fs = std::filesystem;
+    std::error_code ec;
+    fs::file_status status = fs::status(path, ec);
+    if (ec || !fs::exists(status)) {
+        return false;
+    }
+    stamp.isRegular = fs::is_regular_file(status);
+    stamp.isDirectory = fs::is_directory(status);
+    stamp.size = stamp.isRegular ? static_cast<uint64_t>(fs::file_size(path, ec)) : 0;
+    auto mtime = fs::last_write_time(path, ec);
+    stamp.mtime = ec ? 0 : std::chrono::duration_cast<std::chrono::nanoseconds>(mtime.time_since_epoch()).count();
+    stamp.inode = 0;
+    return true;
+#else
+    struct stat info;
+    if (::stat(path.c_str(), &info) != 0) {
+        return false;
+    }
+    fillStamp(info, stamp);
+    return true;
+#endif
+}
+
+bool listDirectory(const std::string& path,
+                   std::vector<std::pair<std::string, FileStamp>>& files,
+                   std::vector<std::string>& directories,
+                   std::string& error) {
+    error.clear();
+#ifdef _WIN32
+    namespace fs = std::filesystem;
+    std::error_code ec;
+    fs::directory_iterator it(fs::path(path), fs::directory_options::skip_permission_denied, ec);
+    if (ec) {
+        error = ec.message();
+        return false;
+    }
+    for (fs::directory_iterator end; it != end; it.increment(ec)) {
+        if (ec) {
+            break;
+        }
+        const fs::directory_entry& entry = *it;
+        std::error_code statusEc;
+        if (entry.is_directory(statusEc) && !entry.is_symlink(statusEc)) {
+            directories.push_back(entry.path().filename().string());
+            continue;
+        }
+        FileStamp stamp;
+        if (entry.is_regular_file(statusEc) && statPath(entry.path().string(), stamp)) {
+            files.emplace_back(entry.path().filename().string(), stamp);
+        }
+    }
+    if (ec) {
+        error = ec.message();
+    }
+    return true;
+#else
+    int fd = ::open(path.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd < 0) {
+        error = std::strerror(errno);
+        return false;
+    }
+
+#ifdef __linux__
+    // The kernel's layout of a getdents64 record
+    struct LinuxDirent64 {
+        uint64_t d_ino;
+        int64_t d_off;
+        unsigned short d_reclen;
+        unsigned char d_type;
+        char d_name[1];
+    };
+
+    alignas(LinuxDirent64) char buffer[32 * 1024];
+    while (true) {
+        long got = syscall(SYS_getdents64, fd, buffer, sizeof(buffer));
+        if (got < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            error = std::strerror(errno);
+            break;
+        }
+        if (got == 0) {
+            break;
+        }
+        for (long offset = 0; offset < got; ) {
+            const LinuxDirent64* entry = reinterpret_cast<const LinuxDirent64*>(buffer + offset);
+            offset += entry->d_reclen;
+            addEntry(fd, entry->d_name, entry->d_type, files, directories);
+        }
+    }
+    ::close(fd);
+#else
+    DIR* directory = fdopendir(fd);
+    if (!directory) {
+        error = std::strerror(errno);
+        ::close(fd);
+        return false;
+    }
+    while (true) {
+        errno = 0;
+        struct dirent* entry = readdir(directory);
+        if (!entry) {
+            if (errno != 0) {
+                error = std::strerror(errno);
+            }
+            break;
+        }
+        addEntry(fd, entry->d_name, entry->d_type, files, directories);
+    }
+    closedir(directory);
+#endif
+    return true;
+#endif
+}
+
+std::string joinPath(const std::string& directory, std::string_view name) {
+    std::string path;
+    path.reserve(directory.size() + 1 + name.size());
+    path = directory;
+    if (!path.empty() && path.back() != kSeparator && path.back() != '/') {
+        path += kSeparator;
+    }
+    path.append(name.data(), name.size());
+    return path;
+}
+
+std::string_view getExtension(std::string_view path) {
+#ifdef _WIN32
+    size_t nameBegin = path.find_last_of("/\\");
+#else
+    size_t nameBegin = path.rfind('/');
+#endif
+    nameBegin = nameBegin == std::string_view::npos ? 0 : nameBegin + 1;
+    std::string_view name = path.substr(nameBegin);
+    if (name == "." || name == "..") {
+        return std::string_view();
+    }
+    size_t dot = name.rfind('.');
+    if (dot == std::string_view::npos || dot == 0) {
+        return std::string_view();
+    }
+    return name.substr(dot);
+}
+
+bool getPhysicalOffset(const std::string& path, uint64_t& offset) {
+#ifdef __linux__
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+
+    // Room for the first extent only
+    uint64_t buffer[(sizeof(struct fiemap) + sizeof(struct fiemap_extent)) / sizeof(uint64_t)] = {};
+    struct fiemap* map = reinterpret_cast<struct fiemap*>(buffer);
+    map->fm_length = FIEMAP_MAX_OFFSET;
+    map->fm_extent_count = 1;
+    bool found = ioctl(fd, FS_IOC_FIEMAP, map) == 0 && map->fm_mapped_extents > 0 &&
+                 !(map->fm_extents[0].fe_flags & (FIEMAP_EXTENT_UNKNOWN | FIEMAP_EXTENT_DATA_INLINE));
+    ::close(fd);
+    if (found) {
+        offset = map->fm_extents[0].fe_physical;
+    }
+    return found;
+#else
+    (void)path;
+    (void)offset;
+    return false;
+#endif
+}
+
+int64_t currentFileTime() {
+#ifdef _WIN32
+    auto now = std::filesystem::file_time_type::clock::now();
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(now.time_since_epoch()).count();
+#else
+    struct timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+    return static_cast<int64_t>(now.tv_sec) * 1000000000LL + now.tv_nsec;
+#endif
+}
+
+uint64_t hashContent(std::string_view content) {
+    // Word-at-a-time multiply/rotate mix with a murmur-style finalizer
+    const uint64_t k0 = 0x9e3779b97f4a7c15ULL;
+    const uint64_t k1 = 0xbf58476d1ce4e5b9ULL;
+    const char* data = content.data();
+    const size_t size = content.size();
+
+    uint64_t h = k0 ^ (static_cast<uint64_t>(size) * k1);
+    size_t pos = 0;
+    for (; pos + 8 <= size; pos += 8) {
+        uint64_t word;
+        std::memcpy(&word, data + pos, sizeof(word));
+        word *= k1;
+        word ^= word >> 31;
+        h = rotateLeft(h ^ word, 27) * k0 + 0x52dce729ULL;
+    }
+
+    uint64_t tail = 0;
+    if (pos < size) {
+        std::memcpy(&tail, data + pos, size - pos);
+    }
+    h ^= tail * k1;
+    return mixFinal(h);
+}
+
+MappedFile::MappedFile()
+    : data_(nullptr),
+      size_(0),
+      mapped_(false) {
+}
+
+MappedFile::~MappedFile() {
+    close();
+}
+
+bool MappedFile::open(const std::string& path, Access access) {
+    close();
+
+#ifdef _WIN32
+    (void)access;
+    std::ifstream stream(path, std::ios::in | std::ios::binary);
+    if (!stream) {
+        return false;
+    }
+    stream.seekg(0, std::ios::end);
+    std::streamoff length = stream.tellg();
+    stream.seekg(0, std::ios::beg);
+    if (length > 0) {
+        buffer_.resize(static_cast<size_t>(length));
+        stream.read(&buffer_[0], length);
+        buffer_.resize(static_cast<size_t>(stream.gcount()));
+    }
+#else
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+
+    struct stat info;
+    if (fstat(fd, &info) != 0) {
+        ::close(fd);
+        return false;
+    }
+
+    bool regular = S_ISREG(info.st_mode);
+    size_t fileSize = regular ? static_cast<size_t>(info.st_size) : 0;
+
+    // Only random-access files are mapped: those are the scanner's own cache
+    // files, which are replaced by rename and never truncated in place. Any
+    // other file can be cut short by an editor while it is read, and touching
+    // a mapped page past the new end raises SIGBUS, so it is read instead.
+    if (access == Access::Random && regular && fileSize >= kMinMapSize) {
+        void* mapping = mmap(nullptr, fileSize, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapping != MAP_FAILED) {
+            madvise(mapping, fileSize, MADV_RANDOM);
+            ::close(fd);
+            data_ = static_cast<const char*>(mapping);
+            size_ = fileSize;
+            mapped_ = true;
+            return true;
+        }
+    }
+
+    // Read it. The byte past the expected size notices a file that grew
+    // without another pass; pipes have no size, so keep reading until EOF.
+    buffer_.resize(regular ? fileSize + 1 : 64 * 1024);
+    size_t used = 0;
+    while (true) {
+        if (used == buffer_.size()) {
+            buffer_.resize(buffer_.size() * 2 + 4096);
+        }
+        ssize_t got = ::read(fd, &buffer_[used], buffer_.size() - used);
+        if (got < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            ::close(fd);
+            buffer_.clear();
+            return false;
+        }
+        if (got == 0) {
+            break;
+        }
+        used += static_cast<size_t>(got);
+    }
+    buffer_.resize(used);
+    ::close(fd);
+#endif
+
+    data_ = buffer_.data();
+    size_ = buffer_.size();
+    return true;
+}
+
+void MappedFile::assign(std::string content) {
+    close();
+    buffer_ = std::move(content);
+    data_ = buffer_.data();
+    size_ = buffer_.size();
+}
+
+std::string_view MappedFile::view() const {
+    return std::string_view(data_, size_);
+}
+
+bool MappedFile::isMapped() const {
+    return mapped_;
+}
+
+std::string MappedFile::takeContent() {
+    std::string content;
+    if (mapped_) {
+        content.assign(data_, size_);
+        close();
+    } else {
+        content = std::move(buffer_);
+        buffer_.clear();
+        data_ = nullptr;
+        size_ = 0;
+    }
+    return content;
+}
+
+void MappedFile::close() {
+#ifndef _WIN32
+    if (mapped_) {
+        munmap(const_cast<char*>(data_), size_);
+    }
+#endif
+    data_ = nullptr;
+    size_ = 0;
+    mapped_ = false;
+    buffer_.clear();
+}
+
+}} // namespace codelve::scanner
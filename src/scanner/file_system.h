@@ -0,0 +1,168 @@
+// File: codelve/src/scanner/file_system.h
+#pragma once
+#include <string>
+#include <string_view>
+#include <vector>
+#include <utility>
+#include <cstddef>
+#include <cstdint>
+
+namespace codelve {
+namespace scanner {
+
+/**
+ * The parts of a file's metadata used to detect changes between scans.
+ */
+struct FileStamp {
+    uint64_t size;
+    int64_t mtime;      // Nanoseconds, on the same clock as currentFileTime()
+    uint64_t inode;     // 0 where the platform does not expose one
+    bool isRegular;
+    bool isDirectory;
+};
+
+/**
+ * Stat a path, following symlinks.
+ * @param path Path to stat
+ * @param stamp Receives the metadata
+ * @return true on success, false if the path does not exist or cannot be stat'ed
+ */
+bool statPath(const std::string& path, FileStamp& stamp);
+
+/**
+ * Read the entries of a directory: regular files, including symlinks to
+ * them, with their stamps, and subdirectories, not including symlinks.
+ * On Linux the directory is read with getdents64 and each file is stat'ed
+ * relative to the directory's descriptor, so no path is built per entry and
+ * subdirectories need no stat at all where the file system reports types.
+ * @param path Path of the directory
+ * @param files Receives file names and stamps, in directory order
+ * @param directories Receives subdirectory names, in directory order
+ * @param error Set if the directory cannot be opened or reading it stops early
+ * @return false if the directory cannot be opened
+ */
+bool listDirectory(const std::string& path,
+                   std::vector<std::pair<std::string, FileStamp>>& files,
+                   std::vector<std::string>& directories,
+                   std::string& error);
+
+/**
+ * Join a directory path and an entry name with the platform separator.
+ * @param directory Directory path
+ * @param name Entry name
+ * @return Path of the entry
+ */
+std::string joinPath(const std::string& directory, std::string_view name);
+
+/**
+ * Get the extension of a path's file name, including the dot, the way
+ * std::filesystem::path::extension() does but without building a path.
+ * @param path The path
+ * @return The extension, or an empty view for none (as for ".gitignore")
+ */
+std::string_view getExtension(std::string_view path);
+
+/**
+ * Find where a file's data starts on its device, to read files in disk
+ * order. Uses FIEMAP, so it works only on Linux file systems that support it.
+ * @param path Path to the file
+ * @param offset Receives the physical byte offset of the first extent
+ * @return false if the offset is unknown, as for empty or inline files
+ */
+bool getPhysicalOffset(const std::string& path, uint64_t& offset);
+
+/**
+ * Get the current time on the clock used for FileStamp::mtime.
+ * @return Nanoseconds
+ */
+int64_t currentFileTime();
+
+/**
+ * Hash file contents for change detection. Not cryptographic.
+ * @param content The bytes to hash
+ * @return 64-bit hash
+ */
+uint64_t hashContent(std::string_view content);
+
+/**
+ * Read-only view of a file's contents.
+ *
+ * Files are read() into an owned buffer, which takeContent() hands over
+ * without copying. Regular files opened for random access above a small
+ * threshold are memory-mapped instead; that is only safe for files nobody
+ * truncates in place, such as the cache files replaced by rename, since
+ * reading a page past the new end of a mapped file raises SIGBUS. On
+ * platforms without POSIX mmap every file is read into the buffer.
+ */
+class MappedFile {
+public:
+    /**
+     * How the contents will be read. Only random access may be mapped.
+     */
+    enum class Access {
+        Sequential,     // Front to back once, like the parsers
+        Random          // Scattered lookups into a cache file, like a persisted index
+    };
+
+    /**
+     * Constructor. Creates an empty, closed file.
+     */
+    MappedFile();
+
+    /**
+     * Destructor. Unmaps the file if it was mapped.
+     */
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    /**
+     * Open a file and make its whole contents available through view().
+     * @param path Path to the file
+     * @param access Expected access pattern
+     * @return true on success, false if the file could not be opened or read
+     */
+    bool open(const std::string& path, Access access = Access::Sequential);
+
+    /**
+     * Take contents that were read elsewhere, as if open() had read them.
+     * @param content The whole contents of the file
+     */
+    void assign(std::string content);
+
+    /**
+     * Get the file contents; valid until the file is closed or destroyed.
+     * @return View over the contents
+     */
+    std::string_view view() const;
+
+    /**
+     * Check whether the contents are memory-mapped rather than buffered.
+     * @return true if mapped
+     */
+    bool isMapped() const;
+
+    /**
+     * Copy the contents into an owned string, or hand over the read buffer
+     * without copying. The view is invalid afterwards.
+     * @return File contents
+     */
+    std::string takeContent();
+
+    /**
+     * Unmap or release the contents.
+     */
+    void close();
+
+private:
+    // Files smaller than this are read(); mapping them costs more than copying
+    static const size_t kMinMapSize = 16 * 1024;
+
+    const char* data_;
+    size_t size_;
+    bool mapped_;
+    std::string buffer_;
+};
+
+}} // namespace codelve::scanner
@@ -0,0 +1,275 @@
+// File: codelve/src/scanner/file_watcher.cpp
+#include "file_watcher.h"
+#include "directory_walker.h"
+#include "../utils/logger.h"
+#include <filesystem>
+#include <algorithm>
+#include <chrono>
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <sys/eventfd.h>
+#include <poll.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#endif
+
+namespace fs = std::filesystem;
+
+namespace codelve {
+namespace scanner {
+
+FileWatcher::FileWatcher(std::vector<std::string> excludeDirectories, int quietMs, int maxDelayMs)
+    : excludeDirectories_(std::move(excludeDirectories)),
+      quietMs_(quietMs),
+      maxDelayMs_(std::max(maxDelayMs, quietMs)),
+      running_(false),
+      inotifyFd_(-1),
+      wakeFd_(-1) {
+}
+
+FileWatcher::~FileWatcher() {
+    stop();
+}
+
+bool FileWatcher::start(const std::string& rootPath,
+                        const std::vector<std::string>& directories,
+                        ChangeCallback callback) {
+    stop();
+
+#ifdef __linux__
+    inotifyFd_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    wakeFd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (inotifyFd_ < 0 || wakeFd_ < 0) {
+        utils::Logger::log(utils::LogLevel::WARNING, "FileWatcher: Cannot initialize inotify: " +
+                                                      std::string(std::strerror(errno)));
+        closeDescriptors();
+        return false;
+    }
+
+    if (!addWatch(rootPath)) {
+        closeDescriptors();
+        return false;
+    }
+    for (const auto& directory : directories) {
+        addWatch(directory);
+    }
+
+    callback_ = std::move(callback);
+    running_ = true;
+    thread_ = std::thread(&FileWatcher::run, this);
+
+    utils::Logger::log(utils::LogLevel::INFO, "FileWatcher: Watching " + std::to_string(watches_.size()) +
+                                               " directories under " + rootPath);
+    return true;
+#else
+    (void)rootPath;
+    (void)directories;
+    (void)callback;
+    utils::Logger::log(utils::LogLevel::INFO, "FileWatcher: Live updates are not supported on this platform");
+    return false;
+#endif
+}
+
+void FileWatcher::stop() {
+#ifdef __linux__
+    if (running_.exchange(false)) {
+        uint64_t one = 1;
+        ssize_t written = write(wakeFd_, &one, sizeof(one));
+        (void)written;
+    }
+#endif
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+    closeDescriptors();
+    watches_.clear();
+    callback_ = nullptr;
+}
+
+bool FileWatcher::isRunning() const {
+    return running_;
+}
+
+void FileWatcher::run() {
+#ifdef __linux__
+    using Clock = std::chrono::steady_clock;
+
+    std::unordered_set<std::string> changed;
+    bool overflowed = false;
+    Clock::time_point firstEvent;
+    Clock::time_point lastEvent;
+
+    while (running_) {
+        // Sleep until an event arrives or the pending batch is due
+        int timeout = -1;
+        bool pending = !changed.empty() || overflowed;
+        if (pending) {
+            Clock::time_point due = std::min(lastEvent + std::chrono::milliseconds(quietMs_),
+                                             firstEvent + std::chrono::milliseconds(maxDelayMs_));
+            auto wait = std::chrono::duration_cast<std::chrono::milliseconds>(due - Clock::now()).count();
+            timeout = static_cast<int>(std::max<long long>(wait, 0));
+        }
+
+        struct pollfd fds[2];
+        fds[0].fd = inotifyFd_;
+        fds[0].events = POLLIN;
+        fds[0].revents = 0;
+        fds[1].fd = wakeFd_;
+        fds[1].events = POLLIN;
+        fds[1].revents = 0;
+
+        int ready = poll(fds, 2, timeout);
+        if (ready < 0 && errno != EINTR) {
+            utils::Logger::log(utils::LogLevel::ERROR, "FileWatcher: poll failed: " + std::string(std::strerror(errno)));
+            break;
+        }
+        if (!running_ || (fds[1].revents & POLLIN)) {
+            break;
+        }
+
+        if (fds[0].revents & POLLIN) {
+            if (!pending) {
+                firstEvent = Clock::now();
+            }
+            readEvents(changed, overflowed);
+            lastEvent = Clock::now();
+            continue;
+        }
+
+        // Timed out with a batch pending: deliver it
+        if (pending) {
+            std::vector<std::string> paths(changed.begin(), changed.end());
+            std::sort(paths.begin(), paths.end());
+            changed.clear();
+
+            utils::Logger::log(utils::LogLevel::DEBUG, "FileWatcher: Delivering " + std::to_string(paths.size()) +
+                                                        " changed paths");
+            if (callback_) {
+                callback_(paths, overflowed);
+            }
+            overflowed = false;
+        }
+    }
+#endif
+}
+
+bool FileWatcher::addWatch(const std::string& directory) {
+#ifdef __linux__
+    const uint32_t mask = IN_CLOSE_WRITE | IN_MODIFY | IN_CREATE | IN_DELETE | IN_MOVED_FROM |
+                          IN_MOVED_TO | IN_DELETE_SELF | IN_ONLYDIR | IN_EXCL_UNLINK;
+    int wd = inotify_add_watch(inotifyFd_, directory.c_str(), mask);
+    if (wd < 0) {
+        if (errno == ENOSPC) {
+            utils::Logger::log(utils::LogLevel::WARNING, "FileWatcher: inotify watch limit reached; "
+                                                          "raise fs.inotify.max_user_watches. Not watching: " + directory);
+        } else {
+            utils::Logger::log(utils::LogLevel::DEBUG, "FileWatcher: Cannot watch " + directory + ": " +
+                                                        std::string(std::strerror(errno)));
+        }
+        return false;
+    }
+    watches_[wd] = directory;
+    return true;
+#else
+    (void)directory;
+    return false;
+#endif
+}
+
+void FileWatcher::addWatchTree(const std::string& directory, std::unordered_set<std::string>& changed) {
+    // Watch first, then list: anything created in between is both listed and
+    // reported by inotify, and the set removes the duplicate
+    addWatch(directory);
+
+    DirectoryWalker walker(excludeDirectories_);
+    walker.walk(directory,
+        [this](const std::string& path) {
+            addWatch(path);
+        },
+        [&changed](const std::string& path, const FileStamp&) {
+            changed.insert(path);
+            return true;
+        });
+}
+
+void FileWatcher::readEvents(std::unordered_set<std::string>& changed, bool& overflowed) {
+#ifdef __linux__
+    alignas(struct inotify_event) char buffer[64 * 1024];
+
+    while (true) {
+        ssize_t length = read(inotifyFd_, buffer, sizeof(buffer));
+        if (length <= 0) {
+            // EAGAIN: drained
+            return;
+        }
+
+        for (ssize_t offset = 0; offset < length; ) {
+            const struct inotify_event* event = reinterpret_cast<const struct inotify_event*>(buffer + offset);
+            offset += sizeof(struct inotify_event) + event->len;
+
+            if (event->mask & IN_Q_OVERFLOW) {
+                overflowed = true;
+                continue;
+            }
+
+            auto watch = watches_.find(event->wd);
+            if (watch == watches_.end()) {
+                continue;
+            }
+            if (event->mask & IN_IGNORED) {
+                watches_.erase(watch);
+                continue;
+            }
+
+            const std::string& directory = watch->second;
+            if (event->len == 0 || event->name[0] == '\0') {
+                // The watched directory itself went away
+                changed.insert(directory);
+                continue;
+            }
+
+            std::string name(event->name);
+            std::string path = (fs::path(directory) / name).string();
+
+            if (event->mask & IN_ISDIR) {
+                if (isExcluded(name)) {
+                    continue;
+                }
+                if (event->mask & (IN_CREATE | IN_MOVED_TO)) {
+                    changed.insert(path);
+                    addWatchTree(path, changed);
+                } else if (event->mask & (IN_DELETE | IN_MOVED_FROM)) {
+                    changed.insert(path);
+                }
+                continue;
+            }
+
+            changed.insert(path);
+        }
+    }
+#else
+    (void)changed;
+    (void)overflowed;
+#endif
+}
+
+bool FileWatcher::isExcluded(const std::string& name) const {
+    return std::find(excludeDirectories_.begin(), excludeDirectories_.end(), name) != excludeDirectories_.end();
+}
+
+void FileWatcher::closeDescriptors() {
+#ifdef __linux__
+    if (inotifyFd_ >= 0) {
+        close(inotifyFd_);
+    }
+    if (wakeFd_ >= 0) {
+        close(wakeFd_);
+    }
+#endif
+    inotifyFd_ = -1;
+    wakeFd_ = -1;
+}
+
+}} // namespace codelve::scanner
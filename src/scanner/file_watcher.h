@@ -0,0 +1,95 @@
+// File: codelve/src/scanner/file_watcher.h
+#pragma once
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <unordered_set>
+#include <functional>
+#include <thread>
+#include <atomic>
+
+namespace codelve {
+namespace scanner {
+
+/**
+ * Watches a scanned tree for changes (Linux inotify) and reports them in
+ * batches. Events are coalesced until the tree has been quiet for a short
+ * while, so a git checkout or a formatter run produces one batch rather
+ * than thousands. New directories are watched as they appear. On other
+ * platforms start() fails and the index stays a snapshot.
+ */
+class FileWatcher {
+public:
+    /**
+     * Called on the watcher thread with one batch of changes.
+     * @param paths Files that were created, modified or deleted, and
+     *        directories that were deleted or moved away
+     * @param overflowed true if the kernel dropped events; the caller should
+     *        rescan the whole tree
+     */
+    using ChangeCallback = std::function<void(const std::vector<std::string>& paths, bool overflowed)>;
+
+    /**
+     * Constructor.
+     * @param excludeDirectories Directory names that are never watched
+     * @param quietMs Deliver a batch once no event arrived for this long
+     * @param maxDelayMs Deliver a batch at the latest this long after its first event
+     */
+    FileWatcher(std::vector<std::string> excludeDirectories, int quietMs, int maxDelayMs);
+
+    /**
+     * Destructor. Stops watching.
+     */
+    ~FileWatcher();
+
+    FileWatcher(const FileWatcher&) = delete;
+    FileWatcher& operator=(const FileWatcher&) = delete;
+
+    /**
+     * Start watching a tree on a background thread.
+     * @param rootPath The scanned directory
+     * @param directories Its subdirectories, as found by the scan
+     * @param callback Receives the batches of changes
+     * @return true if watching started
+     */
+    bool start(const std::string& rootPath,
+               const std::vector<std::string>& directories,
+               ChangeCallback callback);
+
+    /**
+     * Stop watching and wait for the watcher thread. No callback runs after
+     * this returns. Must not be called from the callback.
+     */
+    void stop();
+
+    /**
+     * Check whether the watcher is running.
+     * @return true if running
+     */
+    bool isRunning() const;
+
+private:
+    std::vector<std::string> excludeDirectories_;
+    int quietMs_;
+    int maxDelayMs_;
+
+    ChangeCallback callback_;
+    std::thread thread_;
+    std::atomic<bool> running_;
+
+    // inotify descriptor, and an eventfd used to wake the thread for stop()
+    int inotifyFd_;
+    int wakeFd_;
+
+    // Watch descriptors and the directories they watch
+    std::unordered_map<int, std::string> watches_;
+
+    void run();
+    bool addWatch(const std::string& directory);
+    void addWatchTree(const std::string& directory, std::unordered_set<std::string>& changed);
+    void readEvents(std::unordered_set<std::string>& changed, bool& overflowed);
+    bool isExcluded(const std::string& name) const;
+    void closeDescriptors();
+};
+
+}} // namespace codelve::scanner
@@ -0,0 +1,238 @@
+// File: codelve/src/scanner/git_index.cpp
+#include "git_index.h"
+#include "file_system.h"
+#include "../utils/logger.h"
+#include <filesystem>
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+
+namespace fs = std::filesystem;
+
+namespace codelve {
+namespace scanner {
+
+namespace {
+    // Size of the fixed part of an entry before the object id: ctime,
+    // mtime, dev, ino, mode, uid, gid and size, 4 bytes each
+    const size_t kStatSize = 40;
+
+    const uint16_t kFlagExtended = 0x4000;
+    const uint16_t kNameMask = 0x0fff;
+
+    const uint32_t kModeTypeMask = 0170000;
+    const uint32_t kModeRegular = 0100000;
+    const uint32_t kModeDirectory = 0040000;
+
+    uint32_t getBigEndian32(const char* data) {
+        const unsigned char* bytes = reinterpret_cast<const unsigned char*>(data);
+        return (static_cast<uint32_t>(bytes[0]) << 24) | (static_cast<uint32_t>(bytes[1]) << 16) |
+               (static_cast<uint32_t>(bytes[2]) << 8) | static_cast<uint32_t>(bytes[3]);
+    }
+
+    uint16_t getBigEndian16(const char* data) {
+        const unsigned char* bytes = reinterpret_cast<const unsigned char*>(data);
+        return static_cast<uint16_t>((bytes[0] << 8) | bytes[1]);
+    }
+
+    // Git's offset varint: big-endian groups of 7 bits, each continuation adding one
+    bool getOffsetVarint(const char*& data, const char* end, size_t& value) {
+        if (data >= end) {
+            return false;
+        }
+        unsigned char c = static_cast<unsigned char>(*data++);
+        value = c & 0x7f;
+        while (c & 0x80) {
+            if (data >= end || value > (SIZE_MAX >> 8)) {
+                return false;
+            }
+            c = static_cast<unsigned char>(*data++);
+            value = ((value + 1) << 7) | (c & 0x7f);
+        }
+        return true;
+    }
+
+    bool fail(const std::string& indexPath, const std::string& reason) {
+        utils::Logger::log(utils::LogLevel::WARNING, "GitIndex: Cannot use " + indexPath + ": " + reason);
+        return false;
+    }
+}
+
+GitIndex::GitIndex()
+    : version_(0) {
+}
+
+bool GitIndex::findGitDirectory(const std::string& workTree, std::string& gitDirectory) {
+    fs::path dotGit = fs::path(workTree) / ".git";
+    FileStamp stamp;
+    if (!statPath(dotGit.string(), stamp)) {
+        return false;
+    }
+    if (stamp.isDirectory) {
+        gitDirectory = dotGit.string();
+        return true;
+    }
+    if (!stamp.isRegular) {
+        return false;
+    }
+
+    // A linked worktree or submodule: "gitdir: <path>", relative to the work tree
+    MappedFile file;
+    if (!file.open(dotGit.string())) {
+        return false;
+    }
+    std::string_view text = file.view();
+    const std::string_view prefix = "gitdir: ";
+    if (text.compare(0, prefix.size(), prefix) != 0) {
+        return false;
+    }
+    text.remove_prefix(prefix.size());
+    while (!text.empty() && (text.back() == '\n' || text.back() == '\r' || text.back() == ' ')) {
+        text.remove_suffix(1);
+    }
+    fs::path target{std::string(text)};
+    gitDirectory = (target.is_absolute() ? target : fs::path(workTree) / target).string();
+    return statPath(gitDirectory, stamp) && stamp.isDirectory;
+}
+
+size_t GitIndex::getObjectIdSize(const std::string& gitDirectory) {
+    MappedFile config;
+    if (!config.open((fs::path(gitDirectory) / "config").string())) {
+        return 20;
+    }
+    // [extensions] objectFormat = sha256; git keys are case-insensitive
+    std::string text(config.view());
+    for (char& c : text) {
+        c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    }
+    size_t key = text.find("objectformat");
+    if (key == std::string::npos) {
+        return 20;
+    }
+    size_t lineEnd = text.find('\n', key);
+    std::string line = text.substr(key, lineEnd == std::string::npos ? std::string::npos : lineEnd - key);
+    return line.find("sha256") != std::string::npos ? 32 : 20;
+}
+
+bool GitIndex::load(const std::string& workTree) {
+    files_.clear();
+    version_ = 0;
+
+    std::string gitDirectory;
+    if (!findGitDirectory(workTree, gitDirectory)) {
+        return false;
+    }
+    std::string indexPath = (fs::path(gitDirectory) / "index").string();
+    MappedFile file;
+    if (!file.open(indexPath)) {
+        return false;
+    }
+
+    std::string_view data = file.view();
+    size_t idSize = getObjectIdSize(gitDirectory);
+    if (data.size() < 12 + idSize || data.compare(0, 4, "DIRC") != 0) {
+        return fail(indexPath, "not an index file");
+    }
+    uint32_t version = getBigEndian32(data.data() + 4);
+    if (version < 2 || version > 4) {
+        return fail(indexPath, "unsupported version " + std::to_string(version));
+    }
+    uint32_t count = getBigEndian32(data.data() + 8);
+
+    // Entries and extensions end where the trailing checksum starts
+    const char* position = data.data() + 12;
+    const char* end = data.data() + data.size() - idSize;
+    const size_t fixedSize = kStatSize + idSize + 2;
+
+    // The count is only trusted as far as the entries could fit in the file
+    std::vector<std::string> files;
+    files.reserve(std::min<size_t>(count, static_cast<size_t>(end - position) / fixedSize));
+    std::string path;
+    for (uint32_t i = 0; i < count; i++) {
+        const char* entry = position;
+        if (static_cast<size_t>(end - entry) < fixedSize) {
+            return fail(indexPath, "truncated entry");
+        }
+        uint32_t mode = getBigEndian32(entry + 24);
+        uint16_t flags = getBigEndian16(entry + kStatSize + idSize);
+        position = entry + fixedSize;
+        if (flags & kFlagExtended) {
+            if (version < 3 || end - position < 2) {
+                return fail(indexPath, "bad extended flags");
+            }
+            position += 2;
+        }
+
+        if (version == 4) {
+            // Drop some bytes from the end of the previous path, then append
+            size_t strip = 0;
+            if (!getOffsetVarint(position, end, strip) || strip > path.size()) {
+                return fail(indexPath, "bad path prefix");
+            }
+            const char* nul = static_cast<const char*>(std::memchr(position, '\0', end - position));
+            if (!nul) {
+                return fail(indexPath, "unterminated path");
+            }
+            path.resize(path.size() - strip);
+            path.append(position, nul - position);
+            position = nul + 1;
+        } else {
+            // Names of 0xfff bytes or more are NUL-terminated without a length
+            size_t available = end - position;
+            size_t length = std::min<size_t>(flags & kNameMask, available);
+            const char* nul = static_cast<const char*>(std::memchr(position + length, '\0', available - length));
+            if (!nul) {
+                return fail(indexPath, "unterminated path");
+            }
+            path.assign(position, nul - position);
+
+            // Entries are padded with 1 to 8 NULs to a multiple of 8 bytes
+            size_t entrySize = ((nul - entry) + 8) & ~static_cast<size_t>(7);
+            if (static_cast<size_t>(end - entry) < entrySize) {
+                return fail(indexPath, "truncated entry");
+            }
+            position = entry + entrySize;
+        }
+
+        if ((mode & kModeTypeMask) == kModeDirectory) {
+            return fail(indexPath, "sparse index");
+        }
+        // Unmerged paths appear once per stage, next to each other
+        if ((mode & kModeTypeMask) == kModeRegular && (files.empty() || files.back() != path)) {
+            files.push_back(path);
+        }
+    }
+
+    // Extensions: a 4-byte signature and a 4-byte length each
+    while (end - position >= 8) {
+        std::string_view signature(position, 4);
+        uint32_t length = getBigEndian32(position + 4);
+        if (static_cast<size_t>(end - position - 8) < length) {
+            return fail(indexPath, "truncated extension");
+        }
+        if (signature == "link") {
+            return fail(indexPath, "split index");
+        }
+        if (signature == "sdir") {
+            return fail(indexPath, "sparse index");
+        }
+        position += 8 + length;
+    }
+    if (position != end) {
+        return fail(indexPath, "trailing bytes");
+    }
+
+    files_ = std::move(files);
+    version_ = version;
+    return true;
+}
+
+const std::vector<std::string>& GitIndex::getFiles() const {
+    return files_;
+}
+
+uint32_t GitIndex::getVersion() const {
+    return version_;
+}
+
+}} // namespace codelve::scanner
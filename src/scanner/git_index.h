@@ -0,0 +1,63 @@
+// File: codelve/src/scanner/git_index.h
+#pragma once
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+namespace codelve {
+namespace scanner {
+
+/**
+ * The tracked files of a git working tree, read from its .git/index.
+ *
+ * Reads index versions 2 to 4 (version 4 prefix-compresses paths) with
+ * SHA-1 or SHA-256 object ids. Split and sparse indexes only describe part
+ * of the tree without the objects they refer to, so loading them fails and
+ * the caller should walk the directory instead. The trailing checksum is
+ * not verified; every length is bounds-checked instead.
+ */
+class GitIndex {
+public:
+    GitIndex();
+
+    /**
+     * Find the git directory of a working tree: its .git directory, or the
+     * directory a .git file points to (worktrees, submodules).
+     * @param workTree Top directory of the working tree
+     * @param gitDirectory Receives the git directory
+     * @return true if the working tree has one
+     */
+    static bool findGitDirectory(const std::string& workTree, std::string& gitDirectory);
+
+    /**
+     * Read the index of a working tree.
+     * @param workTree Top directory of the working tree
+     * @return true if read; false if there is no index, or it is corrupt or
+     *         of a kind that is not supported
+     */
+    bool load(const std::string& workTree);
+
+    /**
+     * Get the tracked regular files and executables, once each even while
+     * a merge leaves several stages of a file. Symlinks and submodules are
+     * left out.
+     * @return Paths relative to the working tree, '/'-separated, in index (byte) order
+     */
+    const std::vector<std::string>& getFiles() const;
+
+    /**
+     * Get the format version of the loaded index.
+     * @return 2, 3 or 4
+     */
+    uint32_t getVersion() const;
+
+private:
+    std::vector<std::string> files_;
+    uint32_t version_;
+
+    // Object ids are 20 bytes, or 32 in repositories using SHA-256
+    static size_t getObjectIdSize(const std::string& gitDirectory);
+};
+
+}} // namespace codelve::scanner
@@ -0,0 +1,367 @@
+// File: codelve/src/scanner/ignore_rules.cpp
+#include "ignore_rules.h"
+#include "file_system.h"
+#include <filesystem>
+#include <algorithm>
+
+namespace fs = std::filesystem;
+
+namespace codelve {
+namespace scanner {
+
+const char* const IgnoreScope::kFileNames[] = {".gitignore", ".ignore"};
+const size_t IgnoreScope::kFileNameCount = sizeof(kFileNames) / sizeof(kFileNames[0]);
+
+IgnoreRules::IgnoreRules() {
+}
+
+void IgnoreRules::parse(std::string_view text) {
+    size_t lineStart = 0;
+    while (lineStart < text.size()) {
+        size_t lineEnd = text.find('\n', lineStart);
+        if (lineEnd == std::string_view::npos) {
+            lineEnd = text.size();
+        }
+        std::string_view line = text.substr(lineStart, lineEnd - lineStart);
+        lineStart = lineEnd + 1;
+
+        if (!line.empty() && line.back() == '\r') {
+            line.remove_suffix(1);
+        }
+
+        // Trailing blanks do not count unless escaped
+        while (!line.empty() && (line.back() == ' ' || line.back() == '\t') &&
+               !(line.size() >= 2 && line[line.size() - 2] == '\\')) {
+            line.remove_suffix(1);
+        }
+
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+        compile(line);
+    }
+    buildTables();
+}
+
+bool IgnoreRules::load(const std::string& filePath) {
+    MappedFile file;
+    if (!file.open(filePath)) {
+        return false;
+    }
+    parse(file.view());
+    return true;
+}
+
+void IgnoreRules::compile(std::string_view pattern) {
+    Rule rule;
+    rule.negated = false;
+    rule.directoryOnly = false;
+
+    if (pattern[0] == '!') {
+        rule.negated = true;
+        pattern.remove_prefix(1);
+    }
+    if (!pattern.empty() && pattern.back() == '/') {
+        rule.directoryOnly = true;
+        pattern.remove_suffix(1);
+    }
+    if (pattern.empty()) {
+        return;
+    }
+
+    // A slash anywhere but at the end anchors the pattern to the ignore
+    // file's directory; "**/name" is the same as a plain "name"
+    rule.basename = pattern.find('/') == std::string_view::npos;
+    if (!rule.basename) {
+        if (pattern[0] == '/') {
+            pattern.remove_prefix(1);
+        } else if (pattern.size() > 3 && pattern.compare(0, 3, "**/") == 0 &&
+                   pattern.find('/', 3) == std::string_view::npos) {
+            pattern.remove_prefix(3);
+            rule.basename = true;
+        }
+    }
+
+    auto addLiteral = [&rule](char c) {
+        if (rule.tokens.empty() || rule.tokens.back().type != TokenType::Literal) {
+            rule.tokens.push_back(Token{TokenType::Literal, false, std::string()});
+        }
+        rule.tokens.back().text += c;
+    };
+
+    for (size_t i = 0; i < pattern.size(); i++) {
+        char c = pattern[i];
+        if (c == '\\') {
+            if (i + 1 < pattern.size()) {
+                addLiteral(pattern[++i]);
+            }
+        } else if (c == '?') {
+            rule.tokens.push_back(Token{TokenType::AnyChar, false, std::string()});
+        } else if (c == '*') {
+            size_t run = 1;
+            while (i + run < pattern.size() && pattern[i + run] == '*') {
+                run++;
+            }
+            bool segmentStart = i == 0 || pattern[i - 1] == '/';
+            size_t next = i + run;
+            if (run >= 2 && segmentStart && next == pattern.size()) {
+                rule.tokens.push_back(Token{TokenType::AnyPath, false, std::string()});
+            } else if (run >= 2 && segmentStart && pattern[next] == '/') {
+                rule.tokens.push_back(Token{TokenType::AnySegments, false, std::string()});
+                next++;
+            } else {
+                rule.tokens.push_back(Token{TokenType::AnyRun, false, std::string()});
+            }
+            i = next - 1;
+        } else if (c == '[') {
+            Token token{TokenType::CharClass, false, std::string()};
+            size_t j = i + 1;
+            if (j < pattern.size() && (pattern[j] == '!' || pattern[j] == '^')) {
+                token.negated = true;
+                j++;
+            }
+            bool closed = false;
+            for (bool first = true; j < pattern.size(); first = false) {
+                char member = pattern[j];
+                if (member == ']' && !first) {
+                    closed = true;
+                    break;
+                }
+                if (member == '\\' && j + 1 < pattern.size()) {
+                    member = pattern[++j];
+                }
+                if (j + 2 < pattern.size() && pattern[j + 1] == '-' && pattern[j + 2] != ']') {
+                    char last = pattern[j + 2];
+                    for (int m = static_cast<unsigned char>(member); m <= static_cast<unsigned char>(last); m++) {
+                        token.text += static_cast<char>(m);
+                    }
+                    j += 3;
+                } else {
+                    token.text += member;
+                    j++;
+                }
+            }
+            if (closed) {
+                rule.tokens.push_back(std::move(token));
+                i = j;
+            } else {
+                // An unterminated class is a literal '['
+                addLiteral(c);
+            }
+        } else {
+            addLiteral(c);
+        }
+    }
+
+    if (rule.tokens.empty()) {
+        return;
+    }
+    if (rule.tokens.back().type == TokenType::Literal) {
+        rule.tail = rule.tokens.back().text;
+    }
+    rules_.push_back(std::move(rule));
+}
+
+void IgnoreRules::buildTables() {
+    // Rebuilt from scratch: adding rules may have moved the strings the keys view
+    names_.clear();
+    extensions_.clear();
+    globsByHead_.clear();
+    globs_.clear();
+
+    for (int32_t index = 0; index < static_cast<int32_t>(rules_.size()); index++) {
+        const Rule& rule = rules_[index];
+        std::unordered_map<std::string_view, Hit>* table = nullptr;
+        if (rule.basename && rule.tokens.size() == 1 && rule.tokens[0].type == TokenType::Literal) {
+            table = &names_;
+        } else if (rule.basename && rule.tokens.size() == 2 && rule.tokens[0].type == TokenType::AnyRun &&
+                   rule.tail[0] == '.' && rule.tail.find('/') == std::string::npos) {
+            table = &extensions_;
+        }
+
+        if (!table) {
+            const Token& head = rule.tokens[0];
+            if (head.type == TokenType::Literal) {
+                globsByHead_[headKey(rule.basename, head.text[0])].push_back(index);
+            } else {
+                globs_.push_back(index);
+            }
+            continue;
+        }
+        Hit& hit = table->emplace(std::string_view(rule.tail), Hit{-1, -1}).first->second;
+        (rule.directoryOnly ? hit.directory : hit.any) = index;
+    }
+}
+
+int32_t IgnoreRules::lookup(const std::unordered_map<std::string_view, Hit>& table,
+                            std::string_view key, bool isDirectory) {
+    auto found = table.find(key);
+    if (found == table.end()) {
+        return -1;
+    }
+    return isDirectory ? std::max(found->second.any, found->second.directory) : found->second.any;
+}
+
+IgnoreRules::Match IgnoreRules::match(std::string_view relativePath, bool isDirectory) const {
+    if (rules_.empty()) {
+        return Match::None;
+    }
+
+    size_t slash = relativePath.rfind('/');
+    std::string_view name = slash == std::string_view::npos ? relativePath : relativePath.substr(slash + 1);
+
+    int32_t best = lookup(names_, name, isDirectory);
+    if (!extensions_.empty()) {
+        for (size_t dot = name.find('.'); dot != std::string_view::npos; dot = name.find('.', dot + 1)) {
+            best = std::max(best, lookup(extensions_, name.substr(dot), isDirectory));
+        }
+    }
+
+    // Only globs newer than the best table hit can change the verdict
+    if (!globsByHead_.empty()) {
+        auto found = globsByHead_.find(headKey(true, name.empty() ? '\0' : name[0]));
+        if (found != globsByHead_.end()) {
+            best = matchGlobs(found->second, best, relativePath, name, isDirectory);
+        }
+        found = globsByHead_.find(headKey(false, relativePath.empty() ? '\0' : relativePath[0]));
+        if (found != globsByHead_.end()) {
+            best = matchGlobs(found->second, best, relativePath, name, isDirectory);
+        }
+    }
+    best = matchGlobs(globs_, best, relativePath, name, isDirectory);
+
+    if (best < 0) {
+        return Match::None;
+    }
+    return rules_[best].negated ? Match::Include : Match::Ignore;
+}
+
+int32_t IgnoreRules::matchGlobs(const std::vector<int32_t>& globs, int32_t best,
+                                std::string_view relativePath, std::string_view name, bool isDirectory) const {
+    for (auto index = globs.rbegin(); index != globs.rend() && *index > best; ++index) {
+        const Rule& rule = rules_[*index];
+        if (rule.directoryOnly && !isDirectory) {
+            continue;
+        }
+        std::string_view subject = rule.basename ? name : relativePath;
+        if (subject.size() < rule.tail.size() ||
+            subject.compare(subject.size() - rule.tail.size(), rule.tail.size(), rule.tail) != 0) {
+            continue;
+        }
+        if (matchTokens(rule.tokens, 0, subject, 0)) {
+            return *index;
+        }
+    }
+    return best;
+}
+
+uint32_t IgnoreRules::headKey(bool basename, char first) {
+    return (basename ? 0x100u : 0u) | static_cast<unsigned char>(first);
+}
+
+bool IgnoreRules::matchTokens(const std::vector<Token>& tokens, size_t tokenIndex,
+                              std::string_view subject, size_t position) {
+    for (; tokenIndex < tokens.size(); tokenIndex++) {
+        const Token& token = tokens[tokenIndex];
+        switch (token.type) {
+            case TokenType::Literal:
+                if (subject.compare(position, token.text.size(), token.text) != 0) {
+                    return false;
+                }
+                position += token.text.size();
+                break;
+
+            case TokenType::AnyChar:
+                if (position >= subject.size() || subject[position] == '/') {
+                    return false;
+                }
+                position++;
+                break;
+
+            case TokenType::CharClass: {
+                if (position >= subject.size() || subject[position] == '/') {
+                    return false;
+                }
+                bool member = token.text.find(subject[position]) != std::string::npos;
+                if (member == token.negated) {
+                    return false;
+                }
+                position++;
+                break;
+            }
+
+            case TokenType::AnyRun:
+                if (tokenIndex + 1 == tokens.size()) {
+                    return subject.find('/', position) == std::string_view::npos;
+                }
+                for (size_t end = position; ; end++) {
+                    if (matchTokens(tokens, tokenIndex + 1, subject, end)) {
+                        return true;
+                    }
+                    if (end >= subject.size() || subject[end] == '/') {
+                        return false;
+                    }
+                }
+
+            case TokenType::AnySegments:
+                for (size_t start = position; ; ) {
+                    if (matchTokens(tokens, tokenIndex + 1, subject, start)) {
+                        return true;
+                    }
+                    size_t slash = subject.find('/', start);
+                    if (slash == std::string_view::npos) {
+                        return false;
+                    }
+                    start = slash + 1;
+                }
+
+            case TokenType::AnyPath:
+                return true;
+        }
+    }
+    return position == subject.size();
+}
+
+size_t IgnoreRules::size() const {
+    return rules_.size();
+}
+
+std::shared_ptr<const IgnoreScope> IgnoreScope::enter(std::shared_ptr<const IgnoreScope> parent,
+                                                      const std::string& directoryPath,
+                                                      const std::string& base) {
+    auto scope = std::make_shared<IgnoreScope>();
+    for (size_t i = 0; i < kFileNameCount; i++) {
+        scope->rules_.load((fs::path(directoryPath) / kFileNames[i]).string());
+    }
+    if (scope->rules_.size() == 0) {
+        return parent;
+    }
+    scope->parent_ = std::move(parent);
+    scope->base_ = base;
+    return scope;
+}
+
+bool IgnoreScope::isIgnoreFile(std::string_view name) {
+    for (size_t i = 0; i < kFileNameCount; i++) {
+        if (name == kFileNames[i]) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool IgnoreScope::isIgnored(const IgnoreScope* scope, std::string_view relativePath, bool isDirectory) {
+    for (; scope; scope = scope->parent_.get()) {
+        std::string_view subject = relativePath;
+        if (!scope->base_.empty()) {
+            subject.remove_prefix(std::min(subject.size(), scope->base_.size() + 1));
+        }
+        IgnoreRules::Match match = scope->rules_.match(subject, isDirectory);
+        if (match != IgnoreRules::Match::None) {
+            return match == IgnoreRules::Match::Ignore;
+        }
+    }
+    return false;
+}
+
+}} // namespace codelve::scanner
@@ -0,0 +1,172 @@
+// File: codelve/src/scanner/ignore_rules.h
+#pragma once
+#include <string>
+#include <string_view>
+#include <vector>
+#include <unordered_map>
+#include <memory>
+#include <cstddef>
+#include <cstdint>
+
+namespace codelve {
+namespace scanner {
+
+/**
+ * The patterns of one .gitignore or .ignore file, compiled for matching.
+ *
+ * Follows gitignore syntax: '#' comments, '!' negation, a trailing '/' for
+ * directories only, and patterns containing a slash anchored to the file's
+ * directory. '*', '?' and '[...]' do not cross '/'; '**' as a whole path
+ * segment matches any number of directories. The last matching pattern wins.
+ *
+ * Plain names ("build/", "Makefile") and extension patterns ("*.o") are
+ * looked up in hash tables. The remaining globs are bucketed by the first
+ * character of their leading literal, so only those that can match the
+ * path's first character are tried, newest first, and only until a table
+ * hit makes older ones irrelevant.
+ */
+class IgnoreRules {
+public:
+    /**
+     * The verdict of the patterns on one path.
+     */
+    enum class Match {
+        None,       // No pattern matched; ask the enclosing directory's rules
+        Ignore,
+        Include     // A negated pattern matched last
+    };
+
+    IgnoreRules();
+
+    // The lookup tables view the rules' own strings
+    IgnoreRules(const IgnoreRules&) = delete;
+    IgnoreRules& operator=(const IgnoreRules&) = delete;
+
+    /**
+     * Compile the patterns of an ignore file, adding to those already held.
+     * Later patterns take precedence over earlier ones.
+     * @param text Contents of the file
+     */
+    void parse(std::string_view text);
+
+    /**
+     * Read and compile an ignore file.
+     * @param filePath Path of the file
+     * @return true if the file was read
+     */
+    bool load(const std::string& filePath);
+
+    /**
+     * Match a path against the patterns.
+     * @param relativePath Path relative to the ignore file's directory, '/'-separated
+     * @param isDirectory true if the path is a directory
+     * @return The verdict of the last matching pattern
+     */
+    Match match(std::string_view relativePath, bool isDirectory) const;
+
+    /**
+     * Get the number of patterns.
+     * @return Pattern count
+     */
+    size_t size() const;
+
+private:
+    enum class TokenType : uint8_t {
+        Literal,        // text
+        AnyChar,        // '?'
+        AnyRun,         // '*'
+        CharClass,      // '[...]'
+        AnySegments,    // "**/": zero or more whole directories
+        AnyPath         // Trailing "/**": everything below
+    };
+
+    struct Token {
+        TokenType type;
+        bool negated;           // CharClass only
+        std::string text;       // Literal text, or the CharClass members
+    };
+
+    struct Rule {
+        std::vector<Token> tokens;
+        std::string tail;       // Literal text the subject must end with
+        bool negated;
+        bool directoryOnly;
+        bool basename;          // No slash: matched against the last path component
+    };
+
+    // The newest rule of each kind a table key selects, -1 for none
+    struct Hit {
+        int32_t any;
+        int32_t directory;
+    };
+
+    std::vector<Rule> rules_;
+
+    // Rules that are a plain name, and rules of the form "*.ext", keyed by
+    // the name or the extension (with its dot); keys view rules_[].tail
+    std::unordered_map<std::string_view, Hit> names_;
+    std::unordered_map<std::string_view, Hit> extensions_;
+
+    // Indices of the remaining rules, ascending: those starting with a
+    // literal keyed by its first character and whether they match the
+    // last path component, and those starting with a wildcard
+    std::unordered_map<uint32_t, std::vector<int32_t>> globsByHead_;
+    std::vector<int32_t> globs_;
+
+    void compile(std::string_view pattern);
+    void buildTables();
+    static bool matchTokens(const std::vector<Token>& tokens, size_t tokenIndex,
+                            std::string_view subject, size_t position);
+    int32_t matchGlobs(const std::vector<int32_t>& globs, int32_t best,
+                       std::string_view relativePath, std::string_view name, bool isDirectory) const;
+    static uint32_t headKey(bool basename, char first);
+    static int32_t lookup(const std::unordered_map<std::string_view, Hit>& table,
+                          std::string_view key, bool isDirectory);
+};
+
+/**
+ * The ignore rules in force in one directory: its own ignore files, then
+ * those of each enclosing directory up to the walk root. Scopes are shared
+ * by the directories below them.
+ */
+class IgnoreScope {
+public:
+    // Ignore files read in each directory; later ones take precedence
+    static const char* const kFileNames[];
+    static const size_t kFileNameCount;
+
+    /**
+     * Load the ignore files of a directory, if it has any.
+     * @param parent Scope of the enclosing directory (may be null)
+     * @param directoryPath Path of the directory
+     * @param base Path of the directory relative to the walk root, '/'-separated ("" for the root)
+     * @return A new scope, or parent if the directory has no ignore files
+     */
+    static std::shared_ptr<const IgnoreScope> enter(std::shared_ptr<const IgnoreScope> parent,
+                                                    const std::string& directoryPath,
+                                                    const std::string& base);
+
+    /**
+     * Check whether a file name is that of an ignore file.
+     * @param name File name without directory
+     * @return true for .gitignore and .ignore
+     */
+    static bool isIgnoreFile(std::string_view name);
+
+    /**
+     * Check whether a path is ignored. The nearest directory whose rules
+     * match decides.
+     * @param scope The scope of the path's directory (may be null)
+     * @param relativePath Path relative to the walk root, '/'-separated
+     * @param isDirectory true if the path is a directory
+     * @return true if ignored
+     */
+    static bool isIgnored(const IgnoreScope* scope, std::string_view relativePath, bool isDirectory);
+
+private:
+    std::shared_ptr<const IgnoreScope> parent_;
+    std::string base_;
+    IgnoreRules rules_;
+};
+
+}} // namespace codelve::scanner
@@ -0,0 +1,594 @@
+// File: codelve/src/scanner/index_file.cpp
+#include "index_file.h"
+#include "scan_manifest.h"
+#include "../utils/logger.h"
+#include <filesystem>
+#include <fstream>
+#include <algorithm>
+#include <unordered_map>
+#include <vector>
+#include <cstring>
+
+namespace fs = std::filesystem;
+
+namespace codelve {
+namespace scanner {
+
+// On-disk records. All fields are fixed width and naturally aligned; the file
+// is in native byte order, like the scan manifest, and carries a byte-order
+// mark so a file from another machine is rejected rather than misread.
+struct IndexFile::StringRef {
+    uint32_t offset;
+    uint32_t length;
+};
+
+struct IndexFile::FileEntry {
+    StringRef path;
+    uint64_t contentLength;
+    uint64_t contentHash;
+};
+
+struct IndexFile::SymbolEntry {
+    StringRef name;
+    StringRef type;
+    StringRef signature;
+    StringRef documentation;
+    uint32_t file;
+    int32_t lineNumber;
+};
+
+struct IndexFile::NameEntry {
+    StringRef name;
+    uint32_t postingOffset;
+    uint32_t postingCount;
+};
+
+namespace {
+    const char kMagic[8] = {'C', 'L', 'V', 'I', 'N', 'D', 'E', 'X'};
+    const uint32_t kByteOrderMark = 0x01020304;
+
+    enum SectionId : uint32_t {
+        kStrings = 0,
+        kFiles,
+        kSymbols,
+        kNames,
+        kPostings,
+        kDirectories,
+        kExtensions,
+        kSectionCount
+    };
+
+    struct Header {
+        char magic[8];
+        uint32_t version;
+        uint32_t byteOrder;
+        uint64_t fileSize;
+        uint64_t totalSize;
+        uint32_t sectionCount;
+        uint32_t reserved;
+        uint32_t rootPathOffset;
+        uint32_t rootPathLength;
+        uint32_t fingerprintOffset;
+        uint32_t fingerprintLength;
+        // Covers the header with this field zeroed, and the section table
+        uint64_t checksum;
+    };
+
+    struct Section {
+        uint32_t id;
+        uint32_t reserved;
+        uint64_t offset;
+        uint64_t size;
+        // Hash of the section bytes
+        uint64_t checksum;
+    };
+
+    static_assert(sizeof(Header) == 64, "index header layout changed");
+    static_assert(sizeof(Section) == 32, "index section layout changed");
+
+    const size_t kAlignment = 8;
+
+    size_t alignUp(size_t offset) {
+        return (offset + kAlignment - 1) & ~(kAlignment - 1);
+    }
+
+    uint64_t checksumHeader(Header header, const Section* sections, size_t count) {
+        header.checksum = 0;
+        std::string bytes(reinterpret_cast<const char*>(&header), sizeof(header));
+        bytes.append(reinterpret_cast<const char*>(sections), count * sizeof(Section));
+        return hashContent(bytes);
+    }
+
+    template <typename T>
+    std::string_view asBytes(const std::vector<T>& values) {
+        return std::string_view(reinterpret_cast<const char*>(values.data()), values.size() * sizeof(T));
+    }
+
+    // Deduplicating pool for every string the index refers to
+    class StringSection {
+    public:
+        StringSection() : overflowed_(false) {
+        }
+
+        std::pair<uint32_t, uint32_t> add(std::string_view value) {
+            auto it = offsets_.find(value);
+            if (it != offsets_.end()) {
+                return std::make_pair(it->second, static_cast<uint32_t>(value.size()));
+            }
+            if (data_.size() + value.size() > UINT32_MAX) {
+                overflowed_ = true;
+                return std::make_pair(0u, 0u);
+            }
+            uint32_t offset = static_cast<uint32_t>(data_.size());
+            data_.append(value);
+            offsets_.emplace(value, offset);
+            return std::make_pair(offset, static_cast<uint32_t>(value.size()));
+        }
+
+        const std::string& data() const {
+            return data_;
+        }
+
+        bool overflowed() const {
+            return overflowed_;
+        }
+
+    private:
+        std::string data_;
+
+        // Keys view the caller's strings, which outlive the pool
+        std::unordered_map<std::string_view, uint32_t> offsets_;
+        bool overflowed_;
+    };
+}
+
+bool IndexFile::write(const IndexedCode& indexedCode, const ScanManifest& manifest,
+                      const std::string& fingerprint, const std::string& indexPath) {
+    StringSection pool;
+    auto makeRef = [&pool](std::string_view value) {
+        auto added = pool.add(value);
+        StringRef ref;
+        ref.offset = added.first;
+        ref.length = added.second;
+        return ref;
+    };
+
+    Header header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.version = kVersion;
+    header.byteOrder = kByteOrderMark;
+    header.totalSize = indexedCode.totalSize;
+    header.sectionCount = kSectionCount;
+    StringRef rootRef = makeRef(indexedCode.rootPath);
+    header.rootPathOffset = rootRef.offset;
+    header.rootPathLength = rootRef.length;
+    StringRef fingerprintRef = makeRef(fingerprint);
+    header.fingerprintOffset = fingerprintRef.offset;
+    header.fingerprintLength = fingerprintRef.length;
+
+    // File ids follow path order so lookups can binary search
+    std::vector<const std::pair<const std::string, std::shared_ptr<const FileBlob>>*> files;
+    files.reserve(indexedCode.files.size());
+    for (const auto& filePair : indexedCode.files) {
+        files.push_back(&filePair);
+    }
+    std::sort(files.begin(), files.end(), [](const auto* a, const auto* b) {
+        return a->first < b->first;
+    });
+
+    // Bodies stay in the source files; the index keeps what checks them
+    std::unordered_map<std::string_view, uint32_t> fileIds;
+    fileIds.reserve(files.size());
+    std::vector<FileEntry> fileEntries;
+    fileEntries.reserve(files.size());
+    for (const auto* filePair : files) {
+        FileEntry entry;
+        entry.path = makeRef(filePair->first);
+        entry.contentLength = filePair->second->size;
+        entry.contentHash = filePair->second->hash;
+        fileIds.emplace(filePair->first, static_cast<uint32_t>(fileEntries.size()));
+        fileEntries.push_back(entry);
+    }
+
+    // Symbols come a file at a time, so the file and its manifest record are
+    // looked up once per run; the record has the signature text, so no body
+    // is read
+    const SymbolTable& symbols = indexedCode.symbolDetails;
+    std::vector<SymbolEntry> symbolEntries;
+    symbolEntries.reserve(symbols.size());
+    bool runKnown = false;
+    uint32_t runFile = 0;
+    size_t runBegin = 0;
+    auto file = fileIds.end();
+    const FileSymbols* recorded = nullptr;
+    for (size_t i = 0; i < symbols.size(); i++) {
+        if (!runKnown || symbols.getFileId(i) != runFile) {
+            runKnown = true;
+            runFile = symbols.getFileId(i);
+            runBegin = i;
+            file = fileIds.find(symbols.getFilePath(i));
+            const ScanManifest::FileRecord* record =
+                file != fileIds.end() ? manifest.findFile(std::string(symbols.getFilePath(i))) : nullptr;
+            recorded = record ? record->symbols.get() : nullptr;
+            if (file != fileIds.end() && !recorded) {
+                utils::Logger::log(utils::LogLevel::WARNING, "IndexFile: No recorded symbols for " +
+                                                              std::string(symbols.getFilePath(i)) + ", not saved");
+                return false;
+            }
+        }
+        if (file == fileIds.end()) {
+            continue;
+        }
+        if (i - runBegin >= recorded->entries.size()) {
+            utils::Logger::log(utils::LogLevel::WARNING, "IndexFile: Recorded symbols of " +
+                                                          std::string(symbols.getFilePath(i)) + " are out of date, not saved");
+            return false;
+        }
+        SymbolEntry entry;
+        entry.name = makeRef(symbols.getName(i));
+        entry.type = makeRef(symbols.getType(i));
+        entry.signature = makeRef(recorded->getSignature(recorded->entries[i - runBegin]));
+        entry.documentation = makeRef(symbols.getDocumentation(i));
+        entry.file = file->second;
+        entry.lineNumber = static_cast<int32_t>(symbols.getLineNumber(i));
+        symbolEntries.push_back(entry);
+    }
+
+    // Name ids follow name order; each name's files keep their original order
+    const SymbolIndex& symbolIndex = indexedCode.symbols;
+    std::vector<uint32_t> names(symbolIndex.getNameCount());
+    for (uint32_t i = 0; i < names.size(); i++) {
+        names[i] = i;
+    }
+    std::sort(names.begin(), names.end(), [&symbolIndex](uint32_t a, uint32_t b) {
+        return symbolIndex.getName(a) < symbolIndex.getName(b);
+    });
+
+    std::vector<NameEntry> nameEntries;
+    nameEntries.reserve(names.size());
+    std::vector<uint32_t> postings;
+    std::vector<uint32_t> nameFiles;
+    for (uint32_t name : names) {
+        NameEntry entry;
+        entry.name = makeRef(symbolIndex.getName(name));
+        entry.postingOffset = static_cast<uint32_t>(postings.size());
+        symbolIndex.getFiles(name, nameFiles);
+        for (uint32_t nameFile : nameFiles) {
+            auto file = fileIds.find(symbolIndex.getFilePath(nameFile));
+            if (file != fileIds.end()) {
+                postings.push_back(file->second);
+            }
+        }
+        entry.postingCount = static_cast<uint32_t>(postings.size() - entry.postingOffset);
+        nameEntries.push_back(entry);
+    }
+
+    std::vector<StringRef> directories;
+    directories.reserve(indexedCode.directories.size());
+    for (const auto& directory : indexedCode.directories) {
+        directories.push_back(makeRef(directory));
+    }
+    std::vector<StringRef> extensions;
+    for (const auto& extension : indexedCode.fileExtensions) {
+        extensions.push_back(makeRef(extension));
+    }
+
+    if (pool.overflowed() || postings.size() > UINT32_MAX) {
+        utils::Logger::log(utils::LogLevel::WARNING, "IndexFile: Index too large for the file format, not saved");
+        return false;
+    }
+
+    // Lay the sections out after the header and section table
+    std::string_view sectionData[kSectionCount];
+    sectionData[kStrings] = pool.data();
+    sectionData[kFiles] = asBytes(fileEntries);
+    sectionData[kSymbols] = asBytes(symbolEntries);
+    sectionData[kNames] = asBytes(nameEntries);
+    sectionData[kPostings] = asBytes(postings);
+    sectionData[kDirectories] = asBytes(directories);
+    sectionData[kExtensions] = asBytes(extensions);
+
+    Section sections[kSectionCount];
+    size_t offset = sizeof(Header) + sizeof(sections);
+    for (uint32_t id = 0; id < kSectionCount; id++) {
+        offset = alignUp(offset);
+        sections[id].id = id;
+        sections[id].reserved = 0;
+        sections[id].offset = offset;
+        sections[id].size = sectionData[id].size();
+        sections[id].checksum = hashContent(sectionData[id]);
+        offset += sections[id].size;
+    }
+    header.fileSize = offset;
+    header.checksum = checksumHeader(header, sections, kSectionCount);
+
+    try {
+        fs::path target(indexPath);
+        if (target.has_parent_path()) {
+            fs::create_directories(target.parent_path());
+        }
+
+        // Write beside the target and rename, so readers never see half a file
+        std::string temporaryPath = indexPath + ".tmp";
+        {
+            std::ofstream stream(temporaryPath, std::ios::out | std::ios::binary | std::ios::trunc);
+            if (!stream) {
+                utils::Logger::log(utils::LogLevel::WARNING, "IndexFile: Cannot write index: " + temporaryPath);
+                return false;
+            }
+
+            const char padding[kAlignment] = {};
+            size_t written = 0;
+            auto put = [&stream, &written](const char* data, size_t size) {
+                stream.write(data, static_cast<std::streamsize>(size));
+                written += size;
+            };
+
+            put(reinterpret_cast<const char*>(&header), sizeof(header));
+            put(reinterpret_cast<const char*>(sections), sizeof(sections));
+            for (uint32_t id = 0; id < kSectionCount; id++) {
+                put(padding, sections[id].offset - written);
+                put(sectionData[id].data(), sectionData[id].size());
+            }
+
+            if (!stream) {
+                utils::Logger::log(utils::LogLevel::WARNING, "IndexFile: Failed writing index: " + temporaryPath);
+                return false;
+            }
+        }
+        fs::rename(temporaryPath, target);
+    } catch (const std::exception& e) {
+        utils::Logger::log(utils::LogLevel::WARNING, "IndexFile: Failed to save index: " + std::string(e.what()));
+        return false;
+    }
+
+    utils::Logger::log(utils::LogLevel::INFO, "IndexFile: Saved " + std::to_string(fileEntries.size()) + " files and " +
+                                               std::to_string(symbolEntries.size()) + " symbols (" +
+                                               std::to_string(header.fileSize) + " bytes) to " + indexPath);
+    return true;
+}
+
+IndexFile::IndexFile() {
+    reset();
+}
+
+bool IndexFile::open(const std::string& indexPath, const std::string& rootPath,
+                     const std::string& fingerprint, bool verifyContents) {
+    reset();
+    file_.close();
+
+    if (!file_.open(indexPath, MappedFile::Access::Random)) {
+        return false;
+    }
+
+    auto reject = [this, &indexPath](utils::LogLevel level, const std::string& reason) {
+        utils::Logger::log(level, "IndexFile: " + reason + ", ignoring index: " + indexPath);
+        reset();
+        file_.close();
+        return false;
+    };
+
+    std::string_view data = file_.view();
+    if (data.size() < sizeof(Header) + kSectionCount * sizeof(Section) ||
+        reinterpret_cast<uintptr_t>(data.data()) % kAlignment != 0) {
+        return reject(utils::LogLevel::WARNING, "Truncated index");
+    }
+
+    Header header;
+    std::memcpy(&header, data.data(), sizeof(header));
+    if (std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0 || header.byteOrder != kByteOrderMark) {
+        return reject(utils::LogLevel::INFO, "Unknown index format");
+    }
+    if (header.version != kVersion) {
+        return reject(utils::LogLevel::INFO, "Index format version " + std::to_string(header.version) +
+                                             " is not " + std::to_string(kVersion));
+    }
+    if (header.fileSize != data.size() || header.sectionCount != kSectionCount) {
+        return reject(utils::LogLevel::WARNING, "Truncated index");
+    }
+
+    const Section* sections = reinterpret_cast<const Section*>(data.data() + sizeof(Header));
+    if (checksumHeader(header, sections, kSectionCount) != header.checksum) {
+        return reject(utils::LogLevel::WARNING, "Corrupt index header");
+    }
+
+    // Hashing the sections would page in the whole file, which is what
+    // mapping it avoids; every lookup checks its own bounds, so damage there
+    // gives wrong answers rather than stray reads, and is looked for only
+    // when asked
+    std::string_view sectionData[kSectionCount];
+    for (uint32_t id = 0; id < kSectionCount; id++) {
+        const Section& section = sections[id];
+        if (section.id != id || section.offset % kAlignment != 0 ||
+            section.offset > data.size() || section.size > data.size() - section.offset) {
+            return reject(utils::LogLevel::WARNING, "Corrupt section table");
+        }
+        sectionData[id] = data.substr(section.offset, section.size);
+        if (verifyContents && hashContent(sectionData[id]) != section.checksum) {
+            return reject(utils::LogLevel::WARNING, "Checksum mismatch in section " + std::to_string(id));
+        }
+    }
+
+    if (sectionData[kFiles].size() % sizeof(FileEntry) != 0 ||
+        sectionData[kSymbols].size() % sizeof(SymbolEntry) != 0 ||
+        sectionData[kNames].size() % sizeof(NameEntry) != 0 ||
+        sectionData[kPostings].size() % sizeof(uint32_t) != 0 ||
+        sectionData[kDirectories].size() % sizeof(StringRef) != 0 ||
+        sectionData[kExtensions].size() % sizeof(StringRef) != 0) {
+        return reject(utils::LogLevel::WARNING, "Corrupt section sizes");
+    }
+
+    strings_ = sectionData[kStrings];
+    files_ = reinterpret_cast<const FileEntry*>(sectionData[kFiles].data());
+    fileCount_ = sectionData[kFiles].size() / sizeof(FileEntry);
+    symbols_ = reinterpret_cast<const SymbolEntry*>(sectionData[kSymbols].data());
+    symbolCount_ = sectionData[kSymbols].size() / sizeof(SymbolEntry);
+    names_ = reinterpret_cast<const NameEntry*>(sectionData[kNames].data());
+    nameCount_ = sectionData[kNames].size() / sizeof(NameEntry);
+    postings_ = reinterpret_cast<const uint32_t*>(sectionData[kPostings].data());
+    postingCount_ = sectionData[kPostings].size() / sizeof(uint32_t);
+    directories_ = reinterpret_cast<const StringRef*>(sectionData[kDirectories].data());
+    directoryCount_ = sectionData[kDirectories].size() / sizeof(StringRef);
+    extensions_ = reinterpret_cast<const StringRef*>(sectionData[kExtensions].data());
+    extensionCount_ = sectionData[kExtensions].size() / sizeof(StringRef);
+    totalSize_ = header.totalSize;
+
+    StringRef rootRef = {header.rootPathOffset, header.rootPathLength};
+    StringRef fingerprintRef = {header.fingerprintOffset, header.fingerprintLength};
+    rootPath_ = resolve(rootRef);
+    if (rootPath_ != rootPath || resolve(fingerprintRef) != fingerprint) {
+        return reject(utils::LogLevel::INFO, "Scanner settings changed");
+    }
+
+    if (verifyContents) {
+        for (uint32_t i = 0; i < fileCount_; i++) {
+            if (!loadFileContent(i)) {
+                return reject(utils::LogLevel::INFO, "Changed since it was indexed: " + std::string(getFilePath(i)));
+            }
+        }
+    }
+
+    utils::Logger::log(utils::LogLevel::INFO, "IndexFile: Opened " + std::to_string(fileCount_) + " files and " +
+                                               std::to_string(symbolCount_) + " symbols from " + indexPath);
+    return true;
+}
+
+std::string_view IndexFile::getRootPath() const {
+    return rootPath_;
+}
+
+uint64_t IndexFile::getTotalSize() const {
+    return totalSize_;
+}
+
+size_t IndexFile::getFileCount() const {
+    return fileCount_;
+}
+
+std::string_view IndexFile::getFilePath(uint32_t file) const {
+    return file < fileCount_ ? resolve(files_[file].path) : std::string_view();
+}
+
+std::shared_ptr<const FileBody> IndexFile::loadFileContent(uint32_t file) const {
+    if (file >= fileCount_) {
+        return nullptr;
+    }
+    FileBlob blob;
+    blob.hash = files_[file].contentHash;
+    blob.size = files_[file].contentLength;
+    return ContentStore::load(std::string(resolve(files_[file].path)), blob);
+}
+
+bool IndexFile::findFile(std::string_view path, uint32_t& file) const {
+    const FileEntry* end = files_ + fileCount_;
+    const FileEntry* it = std::lower_bound(files_, end, path, [this](const FileEntry& entry, std::string_view value) {
+        return resolve(entry.path) < value;
+    });
+    if (it == end || resolve(it->path) != path) {
+        return false;
+    }
+    file = static_cast<uint32_t>(it - files_);
+    return true;
+}
+
+size_t IndexFile::getSymbolCount() const {
+    return symbolCount_;
+}
+
+IndexFile::Symbol IndexFile::getSymbol(uint32_t symbol) const {
+    Symbol result;
+    if (symbol >= symbolCount_) {
+        result.file = 0;
+        result.lineNumber = 0;
+        return result;
+    }
+    const SymbolEntry& entry = symbols_[symbol];
+    result.name = resolve(entry.name);
+    result.type = resolve(entry.type);
+    result.signature = resolve(entry.signature);
+    result.documentation = resolve(entry.documentation);
+    result.file = entry.file;
+    result.lineNumber = entry.lineNumber;
+    return result;
+}
+
+size_t IndexFile::getNameCount() const {
+    return nameCount_;
+}
+
+std::string_view IndexFile::getName(uint32_t name) const {
+    return name < nameCount_ ? resolve(names_[name].name) : std::string_view();
+}
+
+bool IndexFile::findName(std::string_view name, uint32_t& nameId) const {
+    const NameEntry* end = names_ + nameCount_;
+    const NameEntry* it = std::lower_bound(names_, end, name, [this](const NameEntry& entry, std::string_view value) {
+        return resolve(entry.name) < value;
+    });
+    if (it == end || resolve(it->name) != name) {
+        return false;
+    }
+    nameId = static_cast<uint32_t>(it - names_);
+    return true;
+}
+
+const uint32_t* IndexFile::getNameFiles(uint32_t nameId, size_t& count) const {
+    count = 0;
+    if (nameId >= nameCount_) {
+        return postings_;
+    }
+    const NameEntry& entry = names_[nameId];
+    if (entry.postingOffset > postingCount_ || entry.postingCount > postingCount_ - entry.postingOffset) {
+        return postings_;
+    }
+    count = entry.postingCount;
+    return postings_ + entry.postingOffset;
+}
+
+size_t IndexFile::getDirectoryCount() const {
+    return directoryCount_;
+}
+
+std::string_view IndexFile::getDirectory(uint32_t directory) const {
+    return directory < directoryCount_ ? resolve(directories_[directory]) : std::string_view();
+}
+
+size_t IndexFile::getExtensionCount() const {
+    return extensionCount_;
+}
+
+std::string_view IndexFile::getExtension(uint32_t extension) const {
+    return extension < extensionCount_ ? resolve(extensions_[extension]) : std::string_view();
+}
+
+size_t IndexFile::getByteSize() const {
+    return file_.view().size();
+}
+
+std::string_view IndexFile::resolve(const StringRef& ref) const {
+    if (ref.offset > strings_.size() || ref.length > strings_.size() - ref.offset) {
+        return std::string_view();
+    }
+    return strings_.substr(ref.offset, ref.length);
+}
+
+void IndexFile::reset() {
+    strings_ = std::string_view();
+    files_ = nullptr;
+    fileCount_ = 0;
+    symbols_ = nullptr;
+    symbolCount_ = 0;
+    names_ = nullptr;
+    nameCount_ = 0;
+    postings_ = nullptr;
+    postingCount_ = 0;
+    directories_ = nullptr;
+    directoryCount_ = 0;
+    extensions_ = nullptr;
+    extensionCount_ = 0;
+    rootPath_ = std::string_view();
+    totalSize_ = 0;
+}
+
+}} // namespace codelve::scanner
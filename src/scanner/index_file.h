@@ -0,0 +1,174 @@
+// File: codelve/src/scanner/index_file.h
+#pragma once
+#include "scanner.h"
+#include "file_system.h"
+#include <string>
+#include <string_view>
+#include <memory>
+#include <cstdint>
+
+namespace codelve {
+namespace scanner {
+
+class ScanManifest;
+
+/**
+ * An IndexedCode saved to disk in a form that is queried where it lies.
+ *
+ * The file is a header, a section table and a set of 8-byte aligned
+ * sections: a string pool, a file table sorted by path, a symbol table, a
+ * name table sorted by name and the posting lists mapping each name to its
+ * files. Opening one maps it and checks the format version and the
+ * checksum of the header and section table; nothing is deserialized, so
+ * lookups page in only what they touch. The sections' own checksums are
+ * checked only on request.
+ *
+ * File bodies are not copied in: they are read from the source files when
+ * asked for, and served only if they still match the size and hash the
+ * index recorded. Saving an index therefore reads no file, and an edit to
+ * one file costs no copy of the others.
+ */
+class IndexFile {
+public:
+    // Bumped whenever the layout changes; files of other versions are rejected
+    static const uint32_t kVersion = 2;
+
+    /**
+     * A symbol as stored in the index. Views point into the mapping.
+     */
+    struct Symbol {
+        std::string_view name;
+        std::string_view type;
+        std::string_view signature;
+        std::string_view documentation;
+        uint32_t file;
+        int lineNumber;
+    };
+
+    /**
+     * Write an index file, replacing any existing one atomically.
+     * @param indexedCode The index to save
+     * @param manifest The manifest of the scan that built it, for the
+     *                 signature text of the symbols
+     * @param fingerprint Scanner settings the index was built with
+     * @param indexPath Path of the index file
+     * @return true if saved
+     */
+    static bool write(const IndexedCode& indexedCode, const ScanManifest& manifest,
+                      const std::string& fingerprint, const std::string& indexPath);
+
+    /**
+     * Constructor. Creates a closed index.
+     */
+    IndexFile();
+
+    IndexFile(const IndexFile&) = delete;
+    IndexFile& operator=(const IndexFile&) = delete;
+
+    /**
+     * Map an index file and validate it.
+     * @param indexPath Path of the index file
+     * @param rootPath Directory the index must have been built from
+     * @param fingerprint Scanner settings the index must have been built with
+     * @param verifyContents Also check the checksum of every section and
+     *                       that every source file still has the recorded
+     *                       hash, which reads all of them
+     * @return true if the index is usable; false if it is missing, stale,
+     *         of another version or corrupt
+     */
+    bool open(const std::string& indexPath, const std::string& rootPath,
+              const std::string& fingerprint, bool verifyContents);
+
+    std::string_view getRootPath() const;
+    uint64_t getTotalSize() const;
+
+    /**
+     * Get the number of files. File ids run from 0 in path order.
+     * @return File count
+     */
+    size_t getFileCount() const;
+    std::string_view getFilePath(uint32_t file) const;
+
+    /**
+     * Read a file's body from the source file.
+     * @param file The file id
+     * @return The body, or null if the file cannot be read or has changed
+     *         since it was indexed
+     */
+    std::shared_ptr<const FileBody> loadFileContent(uint32_t file) const;
+
+    /**
+     * Look up a file by path.
+     * @param path Path of the file
+     * @param file Receives the file id
+     * @return true if found
+     */
+    bool findFile(std::string_view path, uint32_t& file) const;
+
+    size_t getSymbolCount() const;
+    Symbol getSymbol(uint32_t symbol) const;
+
+    /**
+     * Get the number of distinct symbol names. Name ids run from 0 in name order.
+     * @return Name count
+     */
+    size_t getNameCount() const;
+    std::string_view getName(uint32_t name) const;
+
+    /**
+     * Look up a symbol name.
+     * @param name The symbol name
+     * @param nameId Receives the name id
+     * @return true if found
+     */
+    bool findName(std::string_view name, uint32_t& nameId) const;
+
+    /**
+     * Get the files a symbol name maps to, in the order IndexedCode::symbols had them.
+     * @param nameId The name id
+     * @param count Receives the number of files
+     * @return Pointer to the file ids
+     */
+    const uint32_t* getNameFiles(uint32_t nameId, size_t& count) const;
+
+    size_t getDirectoryCount() const;
+    std::string_view getDirectory(uint32_t directory) const;
+
+    size_t getExtensionCount() const;
+    std::string_view getExtension(uint32_t extension) const;
+
+    /**
+     * Get the size of the mapped file.
+     * @return Bytes
+     */
+    size_t getByteSize() const;
+
+private:
+    struct StringRef;
+    struct FileEntry;
+    struct SymbolEntry;
+    struct NameEntry;
+
+    MappedFile file_;
+
+    std::string_view strings_;
+    const FileEntry* files_;
+    size_t fileCount_;
+    const SymbolEntry* symbols_;
+    size_t symbolCount_;
+    const NameEntry* names_;
+    size_t nameCount_;
+    const uint32_t* postings_;
+    size_t postingCount_;
+    const StringRef* directories_;
+    size_t directoryCount_;
+    const StringRef* extensions_;
+    size_t extensionCount_;
+    std::string_view rootPath_;
+    uint64_t totalSize_;
+
+    std::string_view resolve(const StringRef& ref) const;
+    void reset();
+};
+
+}} // namespace codelve::scanner
@@ -0,0 +1,835 @@
+// File: codelve/src/scanner/js_lexer.cpp
+#include "js_lexer.h"
+#include <algorithm>
+#include <limits>
+
+namespace codelve {
+namespace scanner {
+
+namespace {
+    const size_t kNoStatement = std::numeric_limits<size_t>::max();
+
+    bool isJsIdentStart(unsigned char c) {
+        return isIdentStart(c) || c == '$';
+    }
+
+    bool isJsIdentChar(unsigned char c) {
+        return isIdentChar(c) || c == '$';
+    }
+
+    // Keywords after which a '/' starts a regex literal rather than a division
+    bool isRegexPrefixWord(std::string_view word) {
+        static const std::string_view words[] = {
+            "return", "typeof", "instanceof", "in", "of", "new", "delete", "void",
+            "throw", "case", "do", "else", "yield", "await"
+        };
+        return std::find(std::begin(words), std::end(words), word) != std::end(words);
+    }
+
+    // Class member modifiers that may precede a member name
+    bool isMemberModifier(std::string_view word) {
+        static const std::string_view words[] = {
+            "static", "async", "get", "set", "public", "private", "protected",
+            "readonly", "abstract", "override", "declare", "accessor"
+        };
+        return std::find(std::begin(words), std::end(words), word) != std::end(words);
+    }
+
+    // Words that look like "name(" but never name a function or method
+    bool isControlWord(std::string_view word) {
+        static const std::string_view words[] = {
+            "if", "for", "while", "switch", "catch", "function", "return", "typeof",
+            "await", "yield", "new", "super", "import", "require", "with"
+        };
+        return std::find(std::begin(words), std::end(words), word) != std::end(words);
+    }
+}
+
+JsLexer::JsLexer(std::string_view source)
+    : source_(source),
+      pos_(0),
+      sawNewline_(false),
+      pending_(Pending::None),
+      pendingStart_(0),
+      pendingDepth_(0),
+      pendingFlag_(false),
+      statementStart_(kNoStatement),
+      statementIsExport_(false),
+      exportDefault_(false),
+      expectDeclName_(false) {
+    prev_[0] = prev_[1] = prev_[2] = Token{TokenKind::None, 0, 0, false};
+    scopes_.push_back(Scope{false, std::string(), 0, 0});
+
+    // Skip a hashbang line
+    if (source_.size() >= 2 && source_[0] == '#' && source_[1] == '!') {
+        size_t newline = source_.find('\n');
+        pos_ = newline == std::string_view::npos ? source_.size() : newline;
+    }
+}
+
+std::vector<LexedSymbol> JsLexer::extractSymbols() {
+    while (true) {
+        Token token = nextToken();
+        if (token.kind == TokenKind::End) {
+            break;
+        }
+        consume(token);
+    }
+    return std::move(symbols_);
+}
+
+// ---------------------------------------------------------------------------
+// Lexing
+// ---------------------------------------------------------------------------
+
+JsLexer::Token JsLexer::nextToken() {
+    const size_t size = source_.size();
+    sawNewline_ = false;
+
+    while (pos_ < size) {
+        unsigned char c = source_[pos_];
+        unsigned char next = pos_ + 1 < size ? source_[pos_ + 1] : 0;
+
+        if (c == '\n') {
+            sawNewline_ = true;
+            pos_++;
+            continue;
+        }
+        if (isBlank(c)) {
+            pos_++;
+            continue;
+        }
+        if (c == '/' && next == '/') {
+            size_t newline = source_.find('\n', pos_);
+            pos_ = newline == std::string_view::npos ? size : newline;
+            continue;
+        }
+        if (c == '/' && next == '*') {
+            size_t end = source_.find("*/", pos_ + 2);
+            size_t stop = end == std::string_view::npos ? size : end + 2;
+            if (source_.substr(pos_, stop - pos_).find('\n') != std::string_view::npos) {
+                sawNewline_ = true;
+            }
+            pos_ = stop;
+            continue;
+        }
+
+        size_t start = pos_;
+        bool newline = sawNewline_;
+
+        if (isJsIdentStart(c) || (c == '#' && isJsIdentStart(next))) {
+            pos_++;
+            while (pos_ < size && isJsIdentChar(source_[pos_])) {
+                pos_++;
+            }
+            return Token{TokenKind::Identifier, start, pos_ - start, newline};
+        }
+
+        if (isDigit(c) || (c == '.' && isDigit(next))) {
+            pos_++;
+            while (pos_ < size) {
+                char d = source_[pos_];
+                char prev = source_[pos_ - 1];
+                if (isJsIdentChar(d) || d == '.' ||
+                    ((d == '+' || d == '-') && (prev == 'e' || prev == 'E'))) {
+                    pos_++;
+                } else {
+                    break;
+                }
+            }
+            return Token{TokenKind::Literal, start, pos_ - start, newline};
+        }
+
+        if (c == '"' || c == '\'') {
+            skipQuoted(static_cast<char>(c));
+            return Token{TokenKind::String, start, pos_ - start, newline};
+        }
+
+        if (c == '`') {
+            pos_++;
+            Token token = scanTemplate(start);
+            token.newlineBefore = newline;
+            return token;
+        }
+
+        if (c == '/' && regexAllowed()) {
+            if (skipRegex()) {
+                return Token{TokenKind::Literal, start, pos_ - start, newline};
+            }
+            pos_ = start;
+        }
+
+        if (c == '{') {
+            braceIsTemplate_.push_back(false);
+        } else if (c == '}') {
+            if (!braceIsTemplate_.empty() && braceIsTemplate_.back()) {
+                // End of a ${...} substitution: resume the template literal
+                braceIsTemplate_.pop_back();
+                pos_++;
+                Token token = scanTemplate(start);
+                token.newlineBefore = newline;
+                return token;
+            }
+            if (!braceIsTemplate_.empty()) {
+                braceIsTemplate_.pop_back();
+            }
+        }
+
+        // Merge "=>" and comparison/compound-assignment operators so a lone
+        // '=' always means assignment
+        size_t length = 1;
+        if ((c == '=' && next == '>') ||
+            (c == '?' && next == '.' && !(pos_ + 2 < size && isDigit(source_[pos_ + 2])))) {
+            length = 2;
+        } else if (c == '=' && next == '=') {
+            length = pos_ + 2 < size && source_[pos_ + 2] == '=' ? 3 : 2;
+        } else if (next == '=' && std::string_view("!<>+-*/%&|^?").find(static_cast<char>(c)) != std::string_view::npos) {
+            length = (c == '!' && pos_ + 2 < size && source_[pos_ + 2] == '=') ? 3 : 2;
+        }
+        pos_ += length;
+        return Token{TokenKind::Punct, start, length, newline};
+    }
+
+    return Token{TokenKind::End, size, 0, sawNewline_};
+}
+
+JsLexer::Token JsLexer::scanTemplate(size_t start) {
+    // pos_ is just past the opening backtick or the closing '}' of a substitution
+    const size_t size = source_.size();
+    while (pos_ < size) {
+        char c = source_[pos_];
+        if (c == '\\') {
+            pos_ = std::min(pos_ + 2, size);
+            continue;
+        }
+        if (c == '`') {
+            pos_++;
+            break;
+        }
+        if (c == '$' && pos_ + 1 < size && source_[pos_ + 1] == '{') {
+            pos_ += 2;
+            braceIsTemplate_.push_back(true);
+            break;
+        }
+        pos_++;
+    }
+    return Token{TokenKind::Template, start, pos_ - start, false};
+}
+
+void JsLexer::skipQuoted(char quote) {
+    const size_t size = source_.size();
+    pos_++;
+    while (pos_ < size) {
+        char c = source_[pos_];
+        if (c == '\\') {
+            pos_ = std::min(pos_ + 2, size);
+            continue;
+        }
+        if (c == quote) {
+            pos_++;
+            return;
+        }
+        if (c == '\n') {
+            return;
+        }
+        pos_++;
+    }
+}
+
+bool JsLexer::skipRegex() {
+    const size_t size = source_.size();
+    size_t p = pos_ + 1;
+    bool inClass = false;
+    while (p < size) {
+        char c = source_[p];
+        if (c == '\\') {
+            p += 2;
+            continue;
+        }
+        if (c == '\n') {
+            return false;
+        }
+        if (c == '[') {
+            inClass = true;
+        } else if (c == ']') {
+            inClass = false;
+        } else if (c == '/' && !inClass) {
+            p++;
+            while (p < size && isJsIdentChar(source_[p])) {
+                p++;
+            }
+            pos_ = p;
+            return true;
+        }
+        p++;
+    }
+    return false;
+}
+
+bool JsLexer::regexAllowed() const {
+    const Token& prev = prev_[0];
+    switch (prev.kind) {
+    case TokenKind::None:
+        return true;
+    case TokenKind::Punct:
+        return !isPunct(prev, ")") && !isPunct(prev, "]") && !isPunct(prev, "}");
+    case TokenKind::Identifier:
+        return isRegexPrefixWord(text(prev));
+    default:
+        return false;
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Parsing
+// ---------------------------------------------------------------------------
+
+void JsLexer::consume(const Token& token) {
+    Scope& scope = scopes_.back();
+    bool statementLevel = scope.parens == 0 && scope.brackets == 0;
+
+    // Automatic semicolon insertion, approximately: a name on a new line after
+    // a complete expression starts a new statement
+    if (pending_ == Pending::None && statementLevel && token.newlineBefore &&
+        token.kind == TokenKind::Identifier &&
+        (prev_[0].kind == TokenKind::Identifier || prev_[0].kind == TokenKind::String ||
+         prev_[0].kind == TokenKind::Literal || prev_[0].kind == TokenKind::Template ||
+         isPunct(prev_[0], ")") || isPunct(prev_[0], "]") || isPunct(prev_[0], "}"))) {
+        resetStatement();
+    }
+    if (statementStart_ == kNoStatement) {
+        statementStart_ = token.offset;
+    }
+
+    if (pending_ != Pending::None && consumePending(token)) {
+        pushHistory(token);
+        return;
+    }
+
+    if (token.kind == TokenKind::Identifier) {
+        std::string_view word = text(token);
+        bool afterDot = isPunct(prev_[0], ".") || isPunct(prev_[0], "?.");
+
+        if (statementLevel) {
+            if (word == "const" || word == "let" || word == "var") {
+                expectDeclName_ = true;
+            } else if (expectDeclName_) {
+                declName_ = std::string(word);
+                expectDeclName_ = false;
+            } else if (scope.isClass && declName_.empty() && !isMemberModifier(word)) {
+                declName_ = std::string(word);
+            }
+        }
+
+        if (afterDot) {
+            // Property access, never a keyword
+        } else if (word == "import" && statementLevel) {
+            pending_ = Pending::Import;
+            pendingStart_ = token.offset;
+        } else if (word == "require") {
+            pending_ = Pending::CallImport;
+            pendingStart_ = token.offset;
+            pendingFlag_ = false;
+        } else if (word == "export" && statementLevel) {
+            statementIsExport_ = true;
+        } else if (word == "from" && statementIsExport_) {
+            pending_ = Pending::FromClause;
+        } else if (word == "default" && isWord(prev_[0], "export")) {
+            pending_ = Pending::ExportDefault;
+        } else if (word == "class") {
+            pending_ = Pending::ClassHead;
+            pendingName_.clear();
+            pendingStart_ = statementLevel ? statementStart_ : token.offset;
+            pendingDepth_ = 0;
+        } else if ((word == "interface" || word == "enum") && isStatementStart(token)) {
+            pending_ = Pending::NamedDecl;
+            pendingType_ = std::string(word);
+        } else if ((word == "namespace" || word == "module") && isStatementStart(token)) {
+            pending_ = Pending::NamespaceDecl;
+            pendingName_.clear();
+        } else if (word == "type" && isStatementStart(token)) {
+            pending_ = Pending::TypeAlias;
+            pendingName_.clear();
+            pendingDepth_ = 0;
+        } else if (word == "function") {
+            pending_ = Pending::FunctionName;
+            pendingType_ = "function";
+            pendingStart_ = statementLevel ? statementStart_ : token.offset;
+            pendingDepth_ = 0;
+            pendingName_.clear();
+
+            // Anonymous function bound to a name: x = function, x: function
+            const Token& binder = isWord(prev_[0], "async") ? prev_[1] : prev_[0];
+            const Token& bound = isWord(prev_[0], "async") ? prev_[2] : prev_[1];
+            if ((isPunct(binder, "=") || isPunct(binder, ":")) && bound.kind == TokenKind::Identifier) {
+                pendingName_ = std::string(text(bound));
+                if (isPunct(binder, ":")) {
+                    pendingStart_ = bound.offset;
+                }
+            }
+            if (exportDefault_) {
+                pendingName_ = "default";
+            }
+        }
+    } else if (token.kind == TokenKind::Punct) {
+        if (isPunct(token, "(")) {
+            if (scope.isClass && statementLevel && isMemberStart(prev_[1], prev_[0])) {
+                pending_ = Pending::FunctionArgs;
+                pendingName_ = qualify(std::string(text(prev_[0])));
+                pendingType_ = "method";
+                pendingStart_ = statementStart_;
+                pendingDepth_ = 1;
+            } else {
+                scope.parens++;
+            }
+        } else if (isPunct(token, ")")) {
+            if (scope.parens > 0) {
+                scope.parens--;
+            }
+        } else if (isPunct(token, "[")) {
+            scope.brackets++;
+        } else if (isPunct(token, "]")) {
+            if (scope.brackets > 0) {
+                scope.brackets--;
+            }
+        } else if (isPunct(token, "{") && isWord(prev_[0], "export")) {
+            pending_ = Pending::ExportList;
+            pendingFlag_ = false;
+        } else if (isPunct(token, "{")) {
+            scopes_.push_back(Scope{false, std::string(), 0, 0});
+            resetStatement();
+        } else if (isPunct(token, "}")) {
+            if (scopes_.size() > 1) {
+                scopes_.pop_back();
+            }
+            resetStatement();
+        } else if (isPunct(token, ";")) {
+            if (statementLevel) {
+                resetStatement();
+            }
+        } else if (isPunct(token, "=") && statementLevel) {
+            // name = (args) => ..., name = async x => ...
+            std::string name = declName_;
+            if (name.empty() && prev_[0].kind == TokenKind::Identifier) {
+                name = std::string(text(prev_[0]));
+            }
+            if (!name.empty()) {
+                pending_ = Pending::ArrowStart;
+                pendingName_ = scope.isClass ? qualify(name) : name;
+                pendingType_ = scope.isClass ? "method" : "function";
+                pendingStart_ = statementStart_;
+                pendingDepth_ = 0;
+            }
+        } else if (isPunct(token, ":") && !scope.isClass && scopes_.size() > 1 &&
+                   statementLevel && prev_[0].kind == TokenKind::Identifier) {
+            // Object literal property: name: (args) => ...
+            pending_ = Pending::ArrowStart;
+            pendingName_ = std::string(text(prev_[0]));
+            pendingType_ = "function";
+            pendingStart_ = prev_[0].offset;
+            pendingDepth_ = 0;
+        }
+    }
+
+    pushHistory(token);
+}
+
+bool JsLexer::consumePending(const Token& token) {
+    const bool isIdent = token.kind == TokenKind::Identifier;
+
+    switch (pending_) {
+    case Pending::Import:
+        if (isPunct(token, "(") && prev_[0].offset == pendingStart_) {
+            // Dynamic import(): the string follows directly
+            pending_ = Pending::CallImport;
+            pendingFlag_ = true;
+            return true;
+        }
+        if (isPunct(token, ".") && prev_[0].offset == pendingStart_) {
+            // import.meta
+            cancelPending();
+            return false;
+        }
+        if (token.kind == TokenKind::String) {
+            emitModule(token, pendingStart_);
+            pending_ = Pending::None;
+            return true;
+        }
+        if (isPunct(token, ";")) {
+            cancelPending();
+            return false;
+        }
+        return true;
+
+    case Pending::FromClause:
+        if (token.kind == TokenKind::String) {
+            emitModule(token, statementStart_);
+        }
+        pending_ = Pending::None;
+        return token.kind == TokenKind::String;
+
+    case Pending::ExportList:
+        if (!pendingFlag_) {
+            pendingFlag_ = isPunct(token, "}");
+            return true;
+        }
+        cancelPending();
+        if (isWord(token, "from")) {
+            pending_ = Pending::FromClause;
+            return true;
+        }
+        return false;
+
+    case Pending::CallImport:
+        if (!pendingFlag_ && isPunct(token, "(")) {
+            pendingFlag_ = true;
+            return true;
+        }
+        if (!pendingFlag_) {
+            cancelPending();
+            return false;
+        }
+        // The '(' was consumed here; keep the scope's paren count balanced
+        // for the ')' that follows
+        scopes_.back().parens++;
+        cancelPending();
+        if (token.kind == TokenKind::String) {
+            emitModule(token, pendingStart_);
+            return true;
+        }
+        return false;
+
+    case Pending::ExportDefault:
+        pending_ = Pending::None;
+        if (isIdent) {
+            std::string_view word = text(token);
+            if (word == "class" || word == "function" || word == "async" ||
+                word == "abstract" || word == "interface") {
+                exportDefault_ = true;
+                return false;
+            }
+            emit(std::string(word), "export", statementStart_, token.offset + token.length);
+            return true;
+        }
+        emit("default", "export", statementStart_, prev_[0].offset + prev_[0].length);
+        return false;
+
+    case Pending::ClassHead:
+    case Pending::ClassHeritage:
+        if (isPunct(token, "(") || isPunct(token, "<")) {
+            pendingDepth_++;
+            return true;
+        }
+        if (isPunct(token, ")") || isPunct(token, ">")) {
+            if (pendingDepth_ > 0) {
+                pendingDepth_--;
+            }
+            return true;
+        }
+        if (pendingDepth_ > 0) {
+            return true;
+        }
+        if (isIdent) {
+            std::string_view word = text(token);
+            if (word == "extends" || word == "implements") {
+                pending_ = Pending::ClassHeritage;
+            } else if (pending_ == Pending::ClassHead && pendingName_.empty()) {
+                pendingName_ = std::string(word);
+            }
+            return true;
+        }
+        if (isPunct(token, "{")) {
+            std::string name = pendingName_;
+            if (name.empty()) {
+                name = exportDefault_ ? "default" : declName_;
+            }
+            if (!name.empty()) {
+                emit(name, "class", pendingStart_, token.offset);
+            }
+            pending_ = Pending::None;
+            scopes_.push_back(Scope{true, name, 0, 0});
+            resetStatement();
+            return true;
+        }
+        if (pending_ == Pending::ClassHeritage && !isPunct(token, ";")) {
+            return true;
+        }
+        cancelPending();
+        return false;
+
+    case Pending::NamedDecl:
+        pending_ = Pending::None;
+        if (isIdent) {
+            emit(std::string(text(token)), pendingType_, statementStart_, token.offset + token.length);
+            return true;
+        }
+        return false;
+
+    case Pending::NamespaceDecl:
+        if (isIdent || isPunct(token, ".")) {
+            pendingName_.append(text(token));
+            return true;
+        }
+        if (isPunct(token, "{") && !pendingName_.empty()) {
+            emit(pendingName_, "namespace", statementStart_, token.offset);
+        }
+        cancelPending();
+        return false;
+
+    case Pending::TypeAlias:
+        if (isIdent && pendingName_.empty()) {
+            pendingName_ = std::string(text(token));
+            return true;
+        }
+        if (!pendingName_.empty()) {
+            if (isPunct(token, "<")) {
+                pendingDepth_++;
+                return true;
+            }
+            if (isPunct(token, ">") && pendingDepth_ > 0) {
+                pendingDepth_--;
+                return true;
+            }
+            if (pendingDepth_ > 0) {
+                return true;
+            }
+            if (isPunct(token, "=")) {
+                emit(pendingName_, "type", statementStart_, token.offset);
+                pending_ = Pending::None;
+                return true;
+            }
+        }
+        cancelPending();
+        return false;
+
+    case Pending::FunctionName:
+        if (isPunct(token, "*")) {
+            return true;
+        }
+        if (isPunct(token, "<")) {
+            pendingDepth_++;
+            return true;
+        }
+        if (isPunct(token, ">") && pendingDepth_ > 0) {
+            pendingDepth_--;
+            return true;
+        }
+        if (pendingDepth_ > 0) {
+            return true;
+        }
+        if (isIdent) {
+            pendingName_ = std::string(text(token));
+            return true;
+        }
+        if (isPunct(token, "(") && !pendingName_.empty()) {
+            pending_ = Pending::FunctionArgs;
+            pendingDepth_ = 1;
+            return true;
+        }
+        cancelPending();
+        return false;
+
+    case Pending::FunctionArgs:
+        if (isPunct(token, "(")) {
+            pendingDepth_++;
+        } else if (isPunct(token, ")")) {
+            pendingDepth_--;
+            if (pendingDepth_ == 0) {
+                pending_ = Pending::FunctionTail;
+                pendingFlag_ = false;
+                // Remember where the parameter list ends for the signature
+                pendingDepth_ = token.offset + token.length;
+            }
+        }
+        return true;
+
+    case Pending::FunctionTail: {
+        size_t signatureEnd = pendingDepth_;
+        if (isPunct(token, "{") && !pendingFlag_) {
+            emit(pendingName_, pendingType_, pendingStart_, signatureEnd);
+            cancelPending();
+            return false;
+        }
+        if (isPunct(token, ";") || (token.newlineBefore && !pendingFlag_ && isIdent)) {
+            // Overload signature or abstract/interface member
+            emit(pendingName_, pendingType_, pendingStart_, signatureEnd);
+            cancelPending();
+            return false;
+        }
+        if (isPunct(token, ":")) {
+            // Return type annotation; an object type may contain braces
+            pendingFlag_ = true;
+            return true;
+        }
+        if (pendingFlag_) {
+            if (isPunct(token, "{")) {
+                // Either an object return type or the body: the body follows
+                // a complete type, i.e. an identifier, '>' or ']'
+                if (prev_[0].kind == TokenKind::Identifier || isPunct(prev_[0], ">") ||
+                    isPunct(prev_[0], "]") || isPunct(prev_[0], ")") || isPunct(prev_[0], "}")) {
+                    emit(pendingName_, pendingType_, pendingStart_, signatureEnd);
+                    cancelPending();
+                    return false;
+                }
+            }
+            return true;
+        }
+        cancelPending();
+        return false;
+    }
+
+    case Pending::ArrowStart:
+        if (isWord(token, "async")) {
+            return true;
+        }
+        if (isWord(token, "require") || isWord(token, "import")) {
+            // x = require(...): let the module call be picked up
+            cancelPending();
+            return false;
+        }
+        if (isIdent && !isWord(token, "function") && !isWord(token, "class")) {
+            pending_ = Pending::ArrowIdent;
+            return true;
+        }
+        if (isPunct(token, "(")) {
+            pending_ = Pending::ArrowParams;
+            pendingDepth_ = 1;
+            return true;
+        }
+        cancelPending();
+        return false;
+
+    case Pending::ArrowIdent:
+        if (isPunct(token, "=>")) {
+            emit(pendingName_, pendingType_, pendingStart_, token.offset + token.length);
+            pending_ = Pending::None;
+            return true;
+        }
+        cancelPending();
+        return false;
+
+    case Pending::ArrowParams:
+        if (isPunct(token, "(")) {
+            pendingDepth_++;
+        } else if (isPunct(token, ")")) {
+            pendingDepth_--;
+            if (pendingDepth_ == 0) {
+                pending_ = Pending::ArrowTail;
+                pendingFlag_ = false;
+            }
+        }
+        return true;
+
+    case Pending::ArrowTail:
+        if (isPunct(token, "=>")) {
+            emit(pendingName_, pendingType_, pendingStart_, token.offset + token.length);
+            pending_ = Pending::None;
+            return true;
+        }
+        if (isPunct(token, ":") && !pendingFlag_) {
+            pendingFlag_ = true;
+            return true;
+        }
+        if (pendingFlag_ && !isPunct(token, ";") && !isPunct(token, ",") &&
+            !isPunct(token, ")") && !isPunct(token, "}") && !isPunct(token, "{")) {
+            return true;
+        }
+        // "(a) + b" and the like: not an arrow function
+        cancelPending();
+        return false;
+
+    case Pending::None:
+        break;
+    }
+
+    return false;
+}
+
+void JsLexer::resetStatement() {
+    statementStart_ = kNoStatement;
+    statementIsExport_ = false;
+    exportDefault_ = false;
+    expectDeclName_ = false;
+    declName_.clear();
+}
+
+void JsLexer::pushHistory(const Token& token) {
+    prev_[2] = prev_[1];
+    prev_[1] = prev_[0];
+    prev_[0] = token;
+}
+
+void JsLexer::cancelPending() {
+    pending_ = Pending::None;
+    pendingName_.clear();
+    pendingDepth_ = 0;
+    pendingFlag_ = false;
+}
+
+void JsLexer::emit(const std::string& name, const std::string& type, size_t begin, size_t end) {
+    if (begin == kNoStatement || begin > end || name.empty()) {
+        return;
+    }
+    while (end > begin && (isBlank(source_[end - 1]) || source_[end - 1] == '\n')) {
+        end--;
+    }
+    symbols_.push_back(LexedSymbol{name, type, begin, end - begin});
+}
+
+void JsLexer::emitModule(const Token& stringToken, size_t begin) {
+    if (stringToken.length < 2) {
+        return;
+    }
+    std::string module(source_.substr(stringToken.offset + 1, stringToken.length - 2));
+    emit(module, "import", begin, stringToken.offset + stringToken.length);
+}
+
+bool JsLexer::isMemberStart(const Token& before, const Token& name) const {
+    if (name.kind != TokenKind::Identifier || isControlWord(text(name))) {
+        return false;
+    }
+    if (name.newlineBefore || name.offset == statementStart_) {
+        return true;
+    }
+    switch (before.kind) {
+    case TokenKind::None:
+        return true;
+    case TokenKind::Identifier:
+        return isMemberModifier(text(before));
+    case TokenKind::Punct:
+        return isPunct(before, "{") || isPunct(before, "}") || isPunct(before, ";") || isPunct(before, "*");
+    default:
+        return false;
+    }
+}
+
+bool JsLexer::isStatementStart(const Token& token) const {
+    if (token.offset == statementStart_) {
+        return true;
+    }
+    return isWord(prev_[0], "export") || isWord(prev_[0], "declare") ||
+           isWord(prev_[0], "default") || isWord(prev_[0], "const");
+}
+
+std::string JsLexer::qualify(const std::string& name) const {
+    for (auto it = scopes_.rbegin(); it != scopes_.rend(); ++it) {
+        if (it->isClass) {
+            return it->name.empty() ? name : it->name + "." + name;
+        }
+    }
+    return name;
+}
+
+std::string_view JsLexer::text(const Token& token) const {
+    return source_.substr(token.offset, token.length);
+}
+
+bool JsLexer::isPunct(const Token& token, std::string_view punct) const {
+    return token.kind == TokenKind::Punct && text(token) == punct;
+}
+
+bool JsLexer::isWord(const Token& token, std::string_view word) const {
+    return token.kind == TokenKind::Identifier && text(token) == word;
+}
+
+}} // namespace codelve::scanner
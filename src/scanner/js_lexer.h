@@ -0,0 +1,125 @@
+// File: codelve/src/scanner/js_lexer.h
+#pragma once
+#include "lexer_common.h"
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace codelve {
+namespace scanner {
+
+/**
+ * Single-pass lexer for JavaScript and TypeScript sources.
+ *
+ * Handles comments, string, template (with nested ${...} expressions) and
+ * regex literals, and feeds the tokens into a state machine that extracts
+ * ES module imports/re-exports, require() and dynamic import() calls,
+ * classes and their methods (as Class.method), functions, arrow functions
+ * bound to names, TypeScript interfaces, type aliases, enums and
+ * namespaces, and export default declarations.
+ */
+class JsLexer {
+public:
+    /**
+     * Constructor.
+     * @param source The source text; must outlive the lexer
+     */
+    explicit JsLexer(std::string_view source);
+
+    /**
+     * Scan the whole source once and return the symbols found, in source order.
+     * @return Extracted symbols
+     */
+    std::vector<LexedSymbol> extractSymbols();
+
+private:
+    enum class TokenKind {
+        None,
+        Identifier,
+        Punct,
+        String,
+        Template,
+        Literal,
+        End
+    };
+
+    struct Token {
+        TokenKind kind;
+        size_t offset;
+        size_t length;
+        bool newlineBefore;
+    };
+
+    struct Scope {
+        bool isClass;
+        std::string name;
+        size_t parens;
+        size_t brackets;
+    };
+
+    enum class Pending {
+        None,
+        Import,          // import ...: waiting for the module string
+        FromClause,      // export ... from: waiting for the module string
+        ExportList,      // export { ... }: skipping to '}', then an optional from
+        CallImport,      // require / import(: waiting for '(' then a string
+        ExportDefault,   // export default: deciding what is exported
+        ClassHead,       // class: collecting the name
+        ClassHeritage,   // extends / implements clause, waiting for '{'
+        NamedDecl,       // interface / enum: waiting for the name
+        NamespaceDecl,   // namespace A.B: collecting the name, waiting for '{'
+        TypeAlias,       // type Name<...> =
+        FunctionName,    // function [*] name
+        FunctionArgs,    // inside a parameter list
+        FunctionTail,    // after ')': return type, then '{' or ';'
+        ArrowStart,      // after '=' or ':': async, identifier or '('
+        ArrowIdent,      // single-parameter arrow: waiting for '=>'
+        ArrowParams,     // inside an arrow parameter list
+        ArrowTail        // after ')': optional return type, then '=>'
+    };
+
+    std::string_view source_;
+    size_t pos_;
+    bool sawNewline_;
+    std::vector<bool> braceIsTemplate_;
+    std::vector<LexedSymbol> symbols_;
+
+    std::vector<Scope> scopes_;
+    Pending pending_;
+    std::string pendingName_;
+    std::string pendingType_;
+    size_t pendingStart_;
+    size_t pendingDepth_;
+    bool pendingFlag_;
+    size_t statementStart_;
+    bool statementIsExport_;
+    bool exportDefault_;
+    bool expectDeclName_;
+    std::string declName_;
+    Token prev_[3];
+
+    // Lexing
+    Token nextToken();
+    Token scanTemplate(size_t start);
+    void skipQuoted(char quote);
+    bool skipRegex();
+    bool regexAllowed() const;
+
+    // Parsing
+    void consume(const Token& token);
+    bool consumePending(const Token& token);
+    void resetStatement();
+    void pushHistory(const Token& token);
+    void cancelPending();
+    void emit(const std::string& name, const std::string& type, size_t begin, size_t end);
+    void emitModule(const Token& stringToken, size_t begin);
+    bool isMemberStart(const Token& before, const Token& name) const;
+    bool isStatementStart(const Token& token) const;
+    std::string qualify(const std::string& name) const;
+
+    std::string_view text(const Token& token) const;
+    bool isPunct(const Token& token, std::string_view punct) const;
+    bool isWord(const Token& token, std::string_view word) const;
+};
+
+}} // namespace codelve::scanner
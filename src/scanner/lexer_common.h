@@ -0,0 +1,41 @@
+// File: codelve/src/scanner/lexer_common.h
+#pragma once
+#include <string>
+#include <string_view>
+#include <cstddef>
+
+namespace codelve {
+namespace scanner {
+
+/**
+ * A symbol found by one of the language lexers.
+ * The signature is not copied; it is the byte range
+ * [offset, offset + length) of the scanned source.
+ */
+struct LexedSymbol {
+    std::string name;
+    std::string type;
+    size_t offset;
+    size_t length;
+};
+
+// Character classes shared by the hand-written lexers. These deliberately
+// ignore the locale: identifiers are ASCII plus any byte >= 0x80 so UTF-8
+// names pass through intact.
+inline bool isIdentStart(unsigned char c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_' || c >= 0x80;
+}
+
+inline bool isIdentChar(unsigned char c) {
+    return isIdentStart(c) || (c >= '0' && c <= '9');
+}
+
+inline bool isDigit(unsigned char c) {
+    return c >= '0' && c <= '9';
+}
+
+inline bool isBlank(unsigned char c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\f' || c == '\v';
+}
+
+}} // namespace codelve::scanner
@@ -0,0 +1,47 @@
+// File: codelve/src/scanner/line_index.cpp
+#include "line_index.h"
+#include "file_analyzer.h"
+#include <algorithm>
+#include <utility>
+
+namespace codelve {
+namespace scanner {
+
+LineIndex::LineIndex()
+    : lineStarts_(1, 0),
+      size_(0) {
+}
+
+LineIndex::LineIndex(std::string_view content)
+    : LineIndex() {
+    // The lines-only pass of an analyzer without matchers, so the scan's
+    // fused pass and this one find newlines the same way
+    static const FileAnalyzer lineScanner;
+    FileAnalysis analysis;
+    lineScanner.analyze(content, false, analysis);
+    *this = std::move(analysis.lines);
+}
+
+LineIndex::LineIndex(std::vector<uint32_t> lineStarts, size_t size)
+    : lineStarts_(std::move(lineStarts)),
+      size_(size) {
+}
+
+size_t LineIndex::lineCount() const {
+    return lineStarts_.size();
+}
+
+int LineIndex::lineOf(size_t offset) const {
+    auto it = std::upper_bound(lineStarts_.begin(), lineStarts_.end(), offset);
+    return static_cast<int>(it - lineStarts_.begin());
+}
+
+size_t LineIndex::lineStart(size_t line) const {
+    return lineStarts_[line];
+}
+
+size_t LineIndex::lineEnd(size_t line) const {
+    return line + 1 < lineStarts_.size() ? lineStarts_[line + 1] - 1 : size_;
+}
+
+}} // namespace codelve::scanner
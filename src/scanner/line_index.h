@@ -0,0 +1,74 @@
+// File: codelve/src/scanner/line_index.h
+#pragma once
+#include <string_view>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+namespace codelve {
+namespace scanner {
+
+/**
+ * Compact table of line start offsets for one file.
+ *
+ * Built with a single vectorized newline scan: the lines-only pass of a
+ * FileAnalyzer, whose fused pass indexes lines the same way. Byte offsets
+ * map to line numbers by binary search, and lines can be sliced out of
+ * the original content without re-splitting it.
+ */
+class LineIndex {
+public:
+    /**
+     * Constructor. Creates an index for empty content (one empty line).
+     */
+    LineIndex();
+
+    /**
+     * Constructor.
+     * @param content The content to index; only read during construction
+     */
+    explicit LineIndex(std::string_view content);
+
+    /**
+     * Constructor, from line starts already found.
+     * @param lineStarts Offset of the first byte of every line, 0 first
+     * @param size Size of the indexed content
+     */
+    LineIndex(std::vector<uint32_t> lineStarts, size_t size);
+
+    /**
+     * Get the number of lines, counting a final line without a trailing newline.
+     * @return Line count (at least 1)
+     */
+    size_t lineCount() const;
+
+    /**
+     * Map a byte offset to its line number.
+     * @param offset Byte offset into the indexed content
+     * @return 1-based line number
+     */
+    int lineOf(size_t offset) const;
+
+    /**
+     * Get the byte offset at which a line starts.
+     * @param line 0-based line index, must be less than lineCount()
+     * @return Offset of the first byte of the line
+     */
+    size_t lineStart(size_t line) const;
+
+    /**
+     * Get the byte offset just past the end of a line, excluding its newline.
+     * @param line 0-based line index, must be less than lineCount()
+     * @return Offset of the line's newline, or the content size for the last line
+     */
+    size_t lineEnd(size_t line) const;
+
+private:
+    // Offsets of the first byte of every line; lineStarts_[0] is always 0
+    std::vector<uint32_t> lineStarts_;
+
+    // Size of the indexed content
+    size_t size_;
+};
+
+}} // namespace codelve::scanner
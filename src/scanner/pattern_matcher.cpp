@@ -0,0 +1,215 @@
+// File: codelve/src/scanner/pattern_matcher.cpp
+#include "pattern_matcher.h"
+#include "lexer_common.h"
+#include <algorithm>
+#include <limits>
+
+namespace codelve {
+namespace scanner {
+
+namespace {
+    const std::string_view kNameCapture = "{name}";
+    const std::string_view kTextCapture = "{text}";
+
+    inline bool isPatternBlank(unsigned char c) {
+        return c == ' ' || c == '\t';
+    }
+
+    inline bool endsWith(std::string_view text, std::string_view suffix) {
+        return text.size() >= suffix.size() && text.substr(text.size() - suffix.size()) == suffix;
+    }
+
+    inline size_t skipPatternBlanks(std::string_view content, size_t pos) {
+        while (pos < content.size() && isPatternBlank(static_cast<unsigned char>(content[pos]))) {
+            pos++;
+        }
+        return pos;
+    }
+}
+
+const uint16_t PatternMatcher::kDead;
+
+PatternMatcher::PatternMatcher()
+    : columnOf_(),
+      columnCount_(1) {
+    compile();
+}
+
+bool PatternMatcher::addPattern(SymbolKind kind, const std::string& pattern) {
+    std::string_view text = pattern;
+    Capture capture = Capture::None;
+    if (endsWith(text, kNameCapture)) {
+        capture = Capture::Name;
+        text.remove_suffix(kNameCapture.size());
+    } else if (endsWith(text, kTextCapture)) {
+        capture = Capture::Text;
+        text.remove_suffix(kTextCapture.size());
+    }
+    if (text.find(kNameCapture) != std::string_view::npos || text.find(kTextCapture) != std::string_view::npos) {
+        return false;
+    }
+
+    // Runs of blanks become one space, which matches a run of them
+    Pattern added;
+    for (char c : text) {
+        if (!isPatternBlank(static_cast<unsigned char>(c))) {
+            added.literal += c;
+        } else if (!added.literal.empty() && added.literal.back() != ' ') {
+            added.literal += ' ';
+        }
+    }
+    if (capture != Capture::Name && !added.literal.empty() && added.literal.back() == ' ') {
+        added.literal.pop_back();
+    }
+    if (added.literal.empty()) {
+        return false;
+    }
+
+    size_t states = 1;
+    for (const Pattern& existing : patterns_) {
+        if (existing.literal == added.literal) {
+            return false;
+        }
+        states += existing.literal.size();
+    }
+    if (states + added.literal.size() > std::numeric_limits<uint16_t>::max()) {
+        return false;
+    }
+
+    added.capture = capture;
+    added.kind = kind;
+    added.name = added.literal;
+    while (added.name.size() > 1 && (added.name.back() == ':' || added.name.back() == ' ')) {
+        added.name.pop_back();
+    }
+    patterns_.push_back(std::move(added));
+    compile();
+    return true;
+}
+
+size_t PatternMatcher::getPatternCount() const {
+    return patterns_.size();
+}
+
+std::string_view PatternMatcher::getTriggers() const {
+    return triggers_;
+}
+
+size_t PatternMatcher::match(std::string_view content, size_t offset, MatchedSymbol& symbol) const {
+    // A pattern starting within a word only matches at the word's start
+    if (offset > 0 && isIdentChar(static_cast<unsigned char>(content[offset])) &&
+        isIdentChar(static_cast<unsigned char>(content[offset - 1]))) {
+        return 0;
+    }
+
+    size_t state = 0;
+    size_t length = 0;
+    for (size_t pos = offset; pos < content.size(); ) {
+        size_t column = columnOf_[static_cast<unsigned char>(content[pos])];
+        state = transitions_[state * columnCount_ + column];
+        if (state == kDead) {
+            break;
+        }
+        pos++;
+
+        // A longer pattern that matches replaces a shorter one
+        uint32_t accepted = accepting_[state];
+        if (accepted < patterns_.size()) {
+            MatchedSymbol candidate;
+            size_t candidateLength = finish(patterns_[accepted], content, offset, pos, candidate);
+            if (candidateLength > 0) {
+                length = candidateLength;
+                symbol = std::move(candidate);
+            }
+        }
+    }
+    return length;
+}
+
+void PatternMatcher::compile() {
+    columnOf_.fill(0);
+    columnCount_ = 1;
+    triggers_.clear();
+    for (const Pattern& pattern : patterns_) {
+        for (char c : pattern.literal) {
+            unsigned char byte = static_cast<unsigned char>(c);
+            if (columnOf_[byte] != 0) {
+                continue;
+            }
+            columnOf_[byte] = static_cast<uint8_t>(columnCount_);
+            if (byte == ' ') {
+                columnOf_[static_cast<unsigned char>('\t')] = static_cast<uint8_t>(columnCount_);
+            }
+            columnCount_++;
+        }
+        if (triggers_.find(pattern.literal[0]) == std::string::npos) {
+            triggers_ += pattern.literal[0];
+        }
+    }
+
+    // A trie over the columns, with a loop on every state reached by a space
+    transitions_.assign(columnCount_, kDead);
+    accepting_.assign(1, static_cast<uint32_t>(patterns_.size()));
+    for (size_t index = 0; index < patterns_.size(); index++) {
+        size_t state = 0;
+        for (char c : patterns_[index].literal) {
+            size_t column = columnOf_[static_cast<unsigned char>(c)];
+            uint16_t next = transitions_[state * columnCount_ + column];
+            if (next == kDead) {
+                next = static_cast<uint16_t>(accepting_.size());
+                transitions_.resize(transitions_.size() + columnCount_, kDead);
+                accepting_.push_back(static_cast<uint32_t>(patterns_.size()));
+                transitions_[state * columnCount_ + column] = next;
+                if (c == ' ') {
+                    transitions_[next * columnCount_ + column] = next;
+                }
+            }
+            state = next;
+        }
+        accepting_[state] = static_cast<uint32_t>(index);
+    }
+}
+
+size_t PatternMatcher::finish(const Pattern& pattern, std::string_view content, size_t offset, size_t end,
+                              MatchedSymbol& symbol) const {
+    if (pattern.capture == Capture::Name) {
+        if (end >= content.size() || !isIdentStart(static_cast<unsigned char>(content[end]))) {
+            return 0;
+        }
+        size_t nameEnd = end + 1;
+        while (nameEnd < content.size() && isIdentChar(static_cast<unsigned char>(content[nameEnd]))) {
+            nameEnd++;
+        }
+        symbol.name.assign(content.data() + end, nameEnd - end);
+        symbol.kind = pattern.kind;
+        return nameEnd - offset;
+    }
+
+    // A pattern ending within a word only matches at the word's end
+    if (isIdentChar(static_cast<unsigned char>(pattern.literal.back())) && end < content.size() &&
+        isIdentChar(static_cast<unsigned char>(content[end]))) {
+        return 0;
+    }
+    symbol.name = pattern.name;
+    symbol.kind = pattern.kind;
+    if (pattern.capture == Capture::None) {
+        return end - offset;
+    }
+
+    size_t pos = skipPatternBlanks(content, end);
+    if (pos < content.size() && content[pos] == ':') {
+        pos = skipPatternBlanks(content, pos + 1);
+    }
+    size_t textBegin = pos;
+    while (pos < content.size() && content[pos] != '\n' && content[pos] != '\r') {
+        pos++;
+    }
+    size_t textEnd = pos;
+    while (textEnd > textBegin && isPatternBlank(static_cast<unsigned char>(content[textEnd - 1]))) {
+        textEnd--;
+    }
+    symbol.documentation.assign(content.data() + textBegin, textEnd - textBegin);
+    return pos - offset;
+}
+
+}} // namespace codelve::scanner
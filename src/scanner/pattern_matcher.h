@@ -0,0 +1,95 @@
+// File: codelve/src/scanner/pattern_matcher.h
+#pragma once
+#include "file_analyzer.h"
+#include "symbol_table.h"
+#include <array>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+namespace codelve {
+namespace scanner {
+
+/**
+ * Any number of simple patterns, compiled into one DFA and run as a single
+ * FileAnalyzer matcher, so adding a pattern adds no pass over the files.
+ *
+ * The analysis pass stops at the first bytes of the patterns only; from
+ * there the DFA follows every pattern at once, one table lookup per byte,
+ * and the longest pattern that matches wins. Bytes no pattern uses share
+ * one column of the table, which keeps it small enough to stay cached.
+ *
+ * Pattern syntax:
+ *   - any character other than a space matches itself
+ *   - a space matches one or more spaces or tabs
+ *   - a final {name} matches an identifier, which becomes the symbol name
+ *   - a final {text} skips spaces, an optional colon and more spaces, and
+ *     matches the rest of the line, which becomes the documentation
+ * Without {name}, the symbol is named after the pattern's literal text. A
+ * pattern that starts or ends with a letter, digit or underscore matches
+ * whole words only, so FIXME does not match inside FIXMES. As for any
+ * matcher, matches do not overlap, whichever patterns they are of.
+ */
+class PatternMatcher : public FileAnalyzer::Matcher {
+public:
+    PatternMatcher();
+
+    /**
+     * Add a pattern and recompile the DFA. Not safe while a pass runs.
+     * @param kind Kind of the symbols the pattern finds
+     * @param pattern The pattern
+     * @return false if the pattern has no literal text, has a misplaced or
+     *         unknown {capture}, or was added already
+     */
+    bool addPattern(SymbolKind kind, const std::string& pattern);
+
+    /**
+     * Get the number of patterns added.
+     * @return Pattern count
+     */
+    size_t getPatternCount() const;
+
+    std::string_view getTriggers() const override;
+    size_t match(std::string_view content, size_t offset, MatchedSymbol& symbol) const override;
+
+private:
+    enum class Capture : uint8_t {
+        None,
+        Name,
+        Text
+    };
+
+    struct Pattern {
+        std::string literal;
+        Capture capture;
+        SymbolKind kind;
+        std::string name;
+    };
+
+    // No transition; state 0 is the root, which no transition leads back to
+    static const uint16_t kDead = 0;
+
+    std::vector<Pattern> patterns_;
+
+    // Column of each byte in the transition table; 0 for bytes no pattern uses
+    std::array<uint8_t, 256> columnOf_;
+    size_t columnCount_;
+
+    // Next state by state and column, and the pattern accepted in each state
+    // (patterns_.size() for none)
+    std::vector<uint16_t> transitions_;
+    std::vector<uint32_t> accepting_;
+
+    std::string triggers_;
+
+    // Rebuild the columns, the transition table and the triggers from patterns_
+    void compile();
+
+    // Check what follows the literal of a pattern and fill in the symbol
+    size_t finish(const Pattern& pattern, std::string_view content, size_t offset, size_t end,
+                  MatchedSymbol& symbol) const;
+};
+
+}} // namespace codelve::scanner
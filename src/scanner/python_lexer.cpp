@@ -0,0 +1,332 @@
+// File: codelve/src/scanner/python_lexer.cpp
+#include "python_lexer.h"
+
+namespace codelve {
+namespace scanner {
+
+PythonLexer::PythonLexer(std::string_view source)
+    : source_(source),
+      pos_(0) {
+}
+
+std::vector<LexedSymbol> PythonLexer::extractSymbols() {
+    const size_t size = source_.size();
+
+    while (pos_ < size) {
+        // Measure the indentation of the physical line
+        size_t indent = 0;
+        size_t p = pos_;
+        while (p < size) {
+            char c = source_[p];
+            if (c == ' ') {
+                indent++;
+            } else if (c == '\t') {
+                indent = (indent / 8 + 1) * 8;
+            } else if (c == '\f') {
+                indent = 0;
+            } else {
+                break;
+            }
+            p++;
+        }
+        if (p >= size) {
+            break;
+        }
+
+        // Blank and comment-only lines do not open or close scopes
+        char first = source_[p];
+        if (first == '\n' || first == '\r' || first == '#') {
+            size_t newline = source_.find('\n', p);
+            pos_ = newline == std::string_view::npos ? size : newline + 1;
+            continue;
+        }
+
+        while (!scopes_.empty() && scopes_.back().indent >= indent) {
+            scopes_.pop_back();
+        }
+
+        size_t statementStart = p;
+        std::string_view word;
+        size_t afterWord = readWord(p, word);
+
+        pos_ = p;
+        size_t headerColon = std::string_view::npos;
+        size_t lineEnd = skipLogicalLine(headerColon);
+
+        if (first == '@') {
+            handleDecorator(statementStart, lineEnd);
+        } else if (word == "def" || word == "class") {
+            handleDefinition(statementStart, skipSpaces(afterWord, lineEnd), indent,
+                             word == "class", headerColon, lineEnd);
+        } else if (word == "async") {
+            std::string_view next;
+            size_t afterNext = readWord(skipSpaces(afterWord, lineEnd), next);
+            if (next == "def") {
+                handleDefinition(statementStart, skipSpaces(afterNext, lineEnd), indent,
+                                 false, headerColon, lineEnd);
+            }
+        } else if (word == "import") {
+            handleImport(statementStart, lineEnd);
+        } else if (word == "from") {
+            handleFromImport(statementStart, lineEnd);
+        }
+    }
+
+    return std::move(symbols_);
+}
+
+size_t PythonLexer::skipLogicalLine(size_t& headerColon) {
+    const size_t size = source_.size();
+    size_t depth = 0;
+    size_t lastSignificant = pos_;
+
+    while (pos_ < size) {
+        char c = source_[pos_];
+        switch (c) {
+        case '\n':
+            pos_++;
+            if (depth == 0) {
+                return lastSignificant;
+            }
+            continue;
+        case '#': {
+            size_t newline = source_.find('\n', pos_);
+            pos_ = newline == std::string_view::npos ? size : newline;
+            continue;
+        }
+        case '\\':
+            if (pos_ + 1 < size && (source_[pos_ + 1] == '\n' || source_[pos_ + 1] == '\r')) {
+                pos_ += source_[pos_ + 1] == '\r' && pos_ + 2 < size && source_[pos_ + 2] == '\n' ? 3 : 2;
+                continue;
+            }
+            break;
+        case '"':
+        case '\'':
+            skipString(pos_);
+            lastSignificant = pos_;
+            continue;
+        case '(':
+        case '[':
+        case '{':
+            depth++;
+            break;
+        case ')':
+        case ']':
+        case '}':
+            if (depth > 0) {
+                depth--;
+            }
+            break;
+        case ':':
+            if (depth == 0 && headerColon == std::string_view::npos) {
+                headerColon = pos_;
+            }
+            break;
+        default:
+            break;
+        }
+
+        if (!isBlank(c)) {
+            lastSignificant = pos_ + 1;
+        }
+        pos_++;
+    }
+
+    return lastSignificant;
+}
+
+void PythonLexer::skipString(size_t& p) const {
+    const size_t size = source_.size();
+    const char quote = source_[p];
+    const char stops[] = {quote, '\\', '\n', '\0'};
+
+    if (p + 2 < size && source_[p + 1] == quote && source_[p + 2] == quote) {
+        // Triple-quoted: may span lines, ends at the first unescaped triple quote
+        size_t i = p + 3;
+        while (true) {
+            i = source_.find_first_of(std::string_view(stops, 2), i);
+            if (i == std::string_view::npos) {
+                p = size;
+                return;
+            }
+            if (source_[i] == '\\') {
+                i += 2;
+                continue;
+            }
+            if (i + 2 < size && source_[i + 1] == quote && source_[i + 2] == quote) {
+                p = i + 3;
+                return;
+            }
+            i++;
+        }
+    }
+
+    size_t i = p + 1;
+    while (true) {
+        i = source_.find_first_of(std::string_view(stops, 3), i);
+        if (i == std::string_view::npos) {
+            p = size;
+            return;
+        }
+        if (source_[i] == '\\') {
+            i += 2;
+            continue;
+        }
+        if (source_[i] == '\n') {
+            // Unterminated literal: stop at the end of the line
+            p = i;
+            return;
+        }
+        p = i + 1;
+        return;
+    }
+}
+
+size_t PythonLexer::readWord(size_t p, std::string_view& word) const {
+    size_t end = p;
+    while (end < source_.size() && isIdentChar(source_[end])) {
+        end++;
+    }
+    word = source_.substr(p, end - p);
+    return end;
+}
+
+size_t PythonLexer::readDottedName(size_t p, std::string_view& name) const {
+    size_t end = p;
+    while (end < source_.size() && (isIdentChar(source_[end]) || source_[end] == '.')) {
+        end++;
+    }
+    name = source_.substr(p, end - p);
+    return end;
+}
+
+size_t PythonLexer::skipSpaces(size_t p, size_t end) const {
+    while (p < end) {
+        char c = source_[p];
+        if (isBlank(c) || c == '\n' || c == '\\') {
+            p++;
+        } else if (c == '#') {
+            size_t newline = source_.find('\n', p);
+            p = newline == std::string_view::npos ? end : newline;
+        } else {
+            break;
+        }
+    }
+    return p;
+}
+
+void PythonLexer::handleDefinition(size_t statementStart, size_t nameStart, size_t indent,
+                                   bool isClass, size_t headerColon, size_t lineEnd) {
+    std::string_view name;
+    readWord(nameStart, name);
+    if (name.empty()) {
+        return;
+    }
+
+    std::string type = isClass ? "class"
+                               : (!scopes_.empty() && scopes_.back().isClass ? "method" : "function");
+    std::string qualifiedName = qualify(name);
+
+    size_t signatureEnd = headerColon != std::string_view::npos && headerColon < lineEnd ? headerColon + 1 : lineEnd;
+    symbols_.push_back(LexedSymbol{qualifiedName, type, statementStart, signatureEnd - statementStart});
+
+    scopes_.push_back(Scope{indent, isClass, std::move(qualifiedName)});
+}
+
+void PythonLexer::handleImport(size_t statementStart, size_t lineEnd) {
+    // import a.b.c [as d], e [as f]
+    size_t p = statementStart + 6;
+    while (p < lineEnd) {
+        p = skipSpaces(p, lineEnd);
+        std::string_view module;
+        p = readDottedName(p, module);
+        if (module.empty()) {
+            break;
+        }
+        symbols_.push_back(LexedSymbol{std::string(module), "import", statementStart, lineEnd - statementStart});
+
+        p = skipSpaces(p, lineEnd);
+        std::string_view word;
+        size_t afterWord = readWord(p, word);
+        if (word == "as") {
+            p = readWord(skipSpaces(afterWord, lineEnd), word);
+            p = skipSpaces(p, lineEnd);
+        }
+        if (p >= lineEnd || source_[p] != ',') {
+            break;
+        }
+        p++;
+    }
+}
+
+void PythonLexer::handleFromImport(size_t statementStart, size_t lineEnd) {
+    // from [.]x.y import a [as b], c  |  from x import (a, b)  |  from x import *
+    size_t p = skipSpaces(statementStart + 4, lineEnd);
+    std::string_view module;
+    p = readDottedName(p, module);
+    if (module.empty()) {
+        return;
+    }
+
+    std::string_view word;
+    p = readWord(skipSpaces(p, lineEnd), word);
+    if (word != "import") {
+        return;
+    }
+
+    p = skipSpaces(p, lineEnd);
+    if (p < lineEnd && source_[p] == '(') {
+        p++;
+    }
+
+    std::string prefix(module);
+    if (prefix.back() != '.') {
+        prefix.push_back('.');
+    }
+
+    while (p < lineEnd) {
+        p = skipSpaces(p, lineEnd);
+        if (p < lineEnd && source_[p] == '*') {
+            symbols_.push_back(LexedSymbol{std::string(module), "import", statementStart, lineEnd - statementStart});
+            break;
+        }
+
+        std::string_view name;
+        p = readWord(p, name);
+        if (name.empty()) {
+            break;
+        }
+        symbols_.push_back(LexedSymbol{prefix + std::string(name), "import", statementStart, lineEnd - statementStart});
+
+        p = skipSpaces(p, lineEnd);
+        size_t afterWord = readWord(p, word);
+        if (word == "as") {
+            p = readWord(skipSpaces(afterWord, lineEnd), word);
+            p = skipSpaces(p, lineEnd);
+        }
+        if (p >= lineEnd || source_[p] != ',') {
+            break;
+        }
+        p++;
+    }
+}
+
+void PythonLexer::handleDecorator(size_t statementStart, size_t lineEnd) {
+    std::string_view name;
+    readDottedName(skipSpaces(statementStart + 1, lineEnd), name);
+    if (!name.empty()) {
+        symbols_.push_back(LexedSymbol{std::string(name), "decorator", statementStart, lineEnd - statementStart});
+    }
+}
+
+std::string PythonLexer::qualify(std::string_view name) const {
+    if (scopes_.empty()) {
+        return std::string(name);
+    }
+    std::string qualified = scopes_.back().qualifiedName;
+    qualified.push_back('.');
+    qualified.append(name);
+    return qualified;
+}
+
+}} // namespace codelve::scanner
@@ -0,0 +1,65 @@
+// File: codelve/src/scanner/python_lexer.h
+#pragma once
+#include "lexer_common.h"
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace codelve {
+namespace scanner {
+
+/**
+ * Single-pass, line-oriented symbol extractor for Python sources.
+ *
+ * Walks logical lines (joining bracketed and backslash-continued lines and
+ * skipping strings, including triple-quoted docstrings, and comments) and
+ * tracks an indentation stack of enclosing class/def scopes. Emits classes
+ * and functions with dotted qualified names (methods as Class.method),
+ * imports (one symbol per imported module or name) and decorators.
+ */
+class PythonLexer {
+public:
+    /**
+     * Constructor.
+     * @param source The source text; must outlive the lexer
+     */
+    explicit PythonLexer(std::string_view source);
+
+    /**
+     * Scan the whole source once and return the symbols found, in source order.
+     * @return Extracted symbols
+     */
+    std::vector<LexedSymbol> extractSymbols();
+
+private:
+    struct Scope {
+        size_t indent;
+        bool isClass;
+        std::string qualifiedName;
+    };
+
+    std::string_view source_;
+    size_t pos_;
+    std::vector<Scope> scopes_;
+    std::vector<LexedSymbol> symbols_;
+
+    // Skip to the end of the logical line starting at pos_. Returns the
+    // offset just past its last significant character and records the first
+    // ':' outside brackets in headerColon (npos if none).
+    size_t skipLogicalLine(size_t& headerColon);
+
+    void skipString(size_t& p) const;
+    size_t readWord(size_t p, std::string_view& word) const;
+    size_t readDottedName(size_t p, std::string_view& name) const;
+    size_t skipSpaces(size_t p, size_t end) const;
+
+    void handleDefinition(size_t statementStart, size_t nameStart, size_t indent,
+                          bool isClass, size_t headerColon, size_t lineEnd);
+    void handleImport(size_t statementStart, size_t lineEnd);
+    void handleFromImport(size_t statementStart, size_t lineEnd);
+    void handleDecorator(size_t statementStart, size_t lineEnd);
+
+    std::string qualify(std::string_view name) const;
+};
+
+}} // namespace codelve::scanner
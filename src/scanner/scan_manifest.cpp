@@ -0,0 +1,325 @@
+// File: codelve/src/scanner/scan_manifest.cpp
+#include "scan_manifest.h"
+#include "file_system.h"
+#include "../utils/logger.h"
+#include <filesystem>
+#include <fstream>
+#include <algorithm>
+#include <cstring>
+
+namespace fs = std::filesystem;
+
+namespace codelve {
+namespace scanner {
+
+namespace {
+    // Native byte order; the manifest is a local cache, not an exchange format
+    const char kMagic[8] = {'C', 'L', 'V', 'M', 'A', 'N', 'I', 'F'};
+    const uint32_t kVersion = 4;
+
+    const uint8_t kFlagIngested = 1;
+    const uint8_t kFlagRacy = 2;
+
+    // Fewest bytes a stored symbol takes: empty name, signature and
+    // documentation, the kind, the line and the signature span
+    const size_t kMinSymbolSize = 3 * sizeof(uint32_t) + sizeof(uint8_t) + 3 * sizeof(uint32_t);
+
+    class Writer {
+    public:
+        template <typename T>
+        void put(T value) {
+            buffer_.append(reinterpret_cast<const char*>(&value), sizeof(value));
+        }
+
+        void putString(std::string_view value) {
+            put<uint32_t>(static_cast<uint32_t>(value.size()));
+            buffer_.append(value.data(), value.size());
+        }
+
+        void putRaw(const char* data, size_t size) {
+            buffer_.append(data, size);
+        }
+
+        const std::string& data() const {
+            return buffer_;
+        }
+
+    private:
+        std::string buffer_;
+    };
+
+    class Reader {
+    public:
+        explicit Reader(std::string_view data)
+            : data_(data), pos_(0), ok_(true) {
+        }
+
+        template <typename T>
+        T get() {
+            T value = T();
+            if (pos_ + sizeof(T) > data_.size()) {
+                ok_ = false;
+                return value;
+            }
+            std::memcpy(&value, data_.data() + pos_, sizeof(T));
+            pos_ += sizeof(T);
+            return value;
+        }
+
+        std::string getString() {
+            uint32_t length = get<uint32_t>();
+            if (!ok_ || pos_ + length > data_.size()) {
+                ok_ = false;
+                return std::string();
+            }
+            std::string value(data_.substr(pos_, length));
+            pos_ += length;
+            return value;
+        }
+
+        bool expectRaw(const char* data, size_t size) {
+            if (pos_ + size > data_.size() || std::memcmp(data_.data() + pos_, data, size) != 0) {
+                ok_ = false;
+                return false;
+            }
+            pos_ += size;
+            return true;
+        }
+
+        bool ok() const {
+            return ok_;
+        }
+
+        size_t remaining() const {
+            return data_.size() - pos_;
+        }
+
+        void fail() {
+            ok_ = false;
+        }
+
+    private:
+        std::string_view data_;
+        size_t pos_;
+        bool ok_;
+    };
+}
+
+ScanManifest::ScanManifest(std::string rootPath, std::string fingerprint)
+    : rootPath_(std::move(rootPath)),
+      fingerprint_(std::move(fingerprint)),
+      symbolCount_(0) {
+}
+
+bool ScanManifest::load(const std::string& manifestPath) {
+    MappedFile file;
+    if (!file.open(manifestPath)) {
+        return false;
+    }
+
+    Reader reader(file.view());
+    if (!reader.expectRaw(kMagic, sizeof(kMagic)) || reader.get<uint32_t>() != kVersion) {
+        utils::Logger::log(utils::LogLevel::INFO, "ScanManifest: Ignoring manifest with unknown format: " + manifestPath);
+        return false;
+    }
+    if (reader.getString() != rootPath_ || reader.getString() != fingerprint_) {
+        utils::Logger::log(utils::LogLevel::INFO, "ScanManifest: Scanner settings changed, ignoring manifest: " + manifestPath);
+        return false;
+    }
+
+    std::unordered_map<std::string, FileRecord> files;
+    size_t totalSymbols = 0;
+    uint64_t fileCount = reader.get<uint64_t>();
+    for (uint64_t i = 0; i < fileCount && reader.ok(); i++) {
+        std::string path = reader.getString();
+        FileRecord record;
+        record.size = reader.get<uint64_t>();
+        record.mtime = reader.get<int64_t>();
+        record.inode = reader.get<uint64_t>();
+        record.hash = reader.get<uint64_t>();
+        uint8_t flags = reader.get<uint8_t>();
+        record.ingested = (flags & kFlagIngested) != 0;
+        record.racy = (flags & kFlagRacy) != 0;
+        uint8_t contentClass = reader.get<uint8_t>();
+        record.contentClass = contentClass < static_cast<uint8_t>(ContentClass::Count)
+                                  ? static_cast<ContentClass>(contentClass) : ContentClass::Source;
+        record.generalBegin = reader.get<uint32_t>();
+
+        // A count the rest of the file cannot hold is corruption, not a
+        // reason to reserve gigabytes
+        uint32_t symbolCount = reader.get<uint32_t>();
+        if (symbolCount > reader.remaining() / kMinSymbolSize) {
+            reader.fail();
+        }
+        auto symbols = std::make_shared<FileSymbols>();
+        symbols->entries.reserve(reader.ok() ? symbolCount : 0);
+        for (uint32_t j = 0; j < symbolCount && reader.ok(); j++) {
+            std::string name = reader.getString();
+            uint8_t kind = reader.get<uint8_t>();
+            uint32_t lineNumber = reader.get<uint32_t>();
+            uint32_t signatureOffset = reader.get<uint32_t>();
+            uint32_t signatureLength = reader.get<uint32_t>();
+            std::string signature = reader.getString();
+            std::string documentation = reader.getString();
+            symbols->add(name, static_cast<SymbolKind>(std::min<uint8_t>(kind, static_cast<uint8_t>(SymbolKind::Other))),
+                         lineNumber, signatureOffset, signatureLength, signature, documentation);
+        }
+        totalSymbols += symbols->entries.size();
+        record.symbols = std::move(symbols);
+        files.emplace(std::move(path), std::move(record));
+    }
+
+    DirectoryWalker::ListingCache directories;
+    uint64_t directoryCount = reader.get<uint64_t>();
+    for (uint64_t i = 0; i < directoryCount && reader.ok(); i++) {
+        std::string path = reader.getString();
+        DirectoryWalker::Listing listing;
+        listing.mtime = reader.get<int64_t>();
+        listing.pruned = static_cast<size_t>(reader.get<uint64_t>());
+        uint32_t fileNames = reader.get<uint32_t>();
+        for (uint32_t j = 0; j < fileNames && reader.ok(); j++) {
+            listing.files.push_back(reader.getString());
+        }
+        uint32_t directoryNames = reader.get<uint32_t>();
+        for (uint32_t j = 0; j < directoryNames && reader.ok(); j++) {
+            listing.directories.push_back(reader.getString());
+        }
+        directories.emplace(std::move(path), std::move(listing));
+    }
+
+    if (!reader.ok()) {
+        utils::Logger::log(utils::LogLevel::WARNING, "ScanManifest: Truncated manifest ignored: " + manifestPath);
+        return false;
+    }
+
+    files_ = std::move(files);
+    symbolCount_ = totalSymbols;
+    directories_ = std::move(directories);
+    utils::Logger::log(utils::LogLevel::INFO, "ScanManifest: Loaded " + std::to_string(files_.size()) +
+                                               " files from " + manifestPath);
+    return true;
+}
+
+bool ScanManifest::save(const std::string& manifestPath) const {
+    Writer writer;
+    writer.putRaw(kMagic, sizeof(kMagic));
+    writer.put<uint32_t>(kVersion);
+    writer.putString(rootPath_);
+    writer.putString(fingerprint_);
+
+    writer.put<uint64_t>(files_.size());
+    for (const auto& filePair : files_) {
+        const FileRecord& record = filePair.second;
+        writer.putString(filePair.first);
+        writer.put<uint64_t>(record.size);
+        writer.put<int64_t>(record.mtime);
+        writer.put<uint64_t>(record.inode);
+        writer.put<uint64_t>(record.hash);
+        writer.put<uint8_t>((record.ingested ? kFlagIngested : 0) | (record.racy ? kFlagRacy : 0));
+        writer.put<uint8_t>(static_cast<uint8_t>(record.contentClass));
+        writer.put<uint32_t>(record.generalBegin);
+
+        uint32_t symbolCount = record.symbols ? static_cast<uint32_t>(record.symbols->entries.size()) : 0;
+        writer.put<uint32_t>(symbolCount);
+        for (uint32_t i = 0; i < symbolCount; i++) {
+            const FileSymbols::Entry& entry = record.symbols->entries[i];
+            writer.putString(record.symbols->getName(entry));
+            writer.put<uint8_t>(static_cast<uint8_t>(entry.kind));
+            writer.put<uint32_t>(entry.lineNumber);
+            writer.put<uint32_t>(entry.signatureOffset);
+            writer.put<uint32_t>(entry.signatureLength);
+            writer.putString(record.symbols->getSignature(entry));
+            writer.putString(record.symbols->getDocumentation(entry));
+        }
+    }
+
+    writer.put<uint64_t>(directories_.size());
+    for (const auto& directoryPair : directories_) {
+        const DirectoryWalker::Listing& listing = directoryPair.second;
+        writer.putString(directoryPair.first);
+        writer.put<int64_t>(listing.mtime);
+        writer.put<uint64_t>(listing.pruned);
+        writer.put<uint32_t>(static_cast<uint32_t>(listing.files.size()));
+        for (const auto& name : listing.files) {
+            writer.putString(name);
+        }
+        writer.put<uint32_t>(static_cast<uint32_t>(listing.directories.size()));
+        for (const auto& name : listing.directories) {
+            writer.putString(name);
+        }
+    }
+
+    try {
+        fs::path target(manifestPath);
+        if (target.has_parent_path()) {
+            fs::create_directories(target.parent_path());
+        }
+
+        // Write beside the target and rename, so readers never see half a file
+        std::string temporaryPath = manifestPath + ".tmp";
+        {
+            std::ofstream stream(temporaryPath, std::ios::out | std::ios::binary | std::ios::trunc);
+            if (!stream) {
+                utils::Logger::log(utils::LogLevel::WARNING, "ScanManifest: Cannot write manifest: " + temporaryPath);
+                return false;
+            }
+            stream.write(writer.data().data(), static_cast<std::streamsize>(writer.data().size()));
+            if (!stream) {
+                utils::Logger::log(utils::LogLevel::WARNING, "ScanManifest: Failed writing manifest: " + temporaryPath);
+                return false;
+            }
+        }
+        fs::rename(temporaryPath, target);
+    } catch (const std::exception& e) {
+        utils::Logger::log(utils::LogLevel::WARNING, "ScanManifest: Failed to save manifest: " + std::string(e.what()));
+        return false;
+    }
+
+    return true;
+}
+
+const ScanManifest::FileRecord* ScanManifest::findFile(const std::string& path) const {
+    auto it = files_.find(path);
+    return it != files_.end() ? &it->second : nullptr;
+}
+
+void ScanManifest::setFile(const std::string& path, FileRecord record) {
+    FileRecord& slot = files_[path];
+    symbolCount_ -= slot.symbols ? slot.symbols->entries.size() : 0;
+    symbolCount_ += record.symbols ? record.symbols->entries.size() : 0;
+    slot = std::move(record);
+}
+
+void ScanManifest::removeFile(const std::string& path) {
+    auto it = files_.find(path);
+    if (it != files_.end()) {
+        symbolCount_ -= it->second.symbols ? it->second.symbols->entries.size() : 0;
+        files_.erase(it);
+    }
+}
+
+size_t ScanManifest::getFileCount() const {
+    return files_.size();
+}
+
+size_t ScanManifest::getSymbolCount() const {
+    return symbolCount_;
+}
+
+DirectoryWalker::ListingCache& ScanManifest::getDirectories() {
+    return directories_;
+}
+
+const DirectoryWalker::ListingCache& ScanManifest::getDirectories() const {
+    return directories_;
+}
+
+const std::string& ScanManifest::getRootPath() const {
+    return rootPath_;
+}
+
+const std::string& ScanManifest::getFingerprint() const {
+    return fingerprint_;
+}
+
+}} // namespace codelve::scanner
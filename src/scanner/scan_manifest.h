@@ -0,0 +1,119 @@
+// File: codelve/src/scanner/scan_manifest.h
+#pragma once
+#include "scanner.h"
+#include "directory_walker.h"
+#include "content_sniffer.h"
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <memory>
+#include <cstdint>
+
+namespace codelve {
+namespace scanner {
+
+/**
+ * What a scan knew about a codebase: the stamp and content hash of every
+ * file it considered, the symbols parsed from each ingested file, and the
+ * directory listings of the walk. Persisted between runs so a rescan only
+ * reads and parses files that changed.
+ */
+class ScanManifest {
+public:
+    /**
+     * A file seen by a scan.
+     */
+    struct FileRecord {
+        uint64_t size = 0;
+        int64_t mtime = 0;
+        uint64_t inode = 0;
+        uint64_t hash = 0;
+
+        // false if the scan rejected the file (e.g. too many lines)
+        bool ingested = false;
+
+        // Modified too close to the scan to trust the stamp; rehash next time
+        bool racy = false;
+
+        // What the file's first bytes showed it to be
+        ContentClass contentClass = ContentClass::Source;
+
+        // Symbols parsed from the file, shared between manifests; those from
+        // generalBegin on also go into IndexedCode::symbols
+        std::shared_ptr<const FileSymbols> symbols;
+        uint32_t generalBegin = 0;
+    };
+
+    /**
+     * Constructor.
+     * @param rootPath The scanned directory
+     * @param fingerprint Scanner settings that affect parse results
+     */
+    ScanManifest(std::string rootPath, std::string fingerprint);
+
+    /**
+     * Load a manifest from disk. Fails if the file is missing, corrupt, or
+     * was written for another root or with other settings.
+     * @param manifestPath Path of the manifest file
+     * @return true if loaded
+     */
+    bool load(const std::string& manifestPath);
+
+    /**
+     * Write the manifest to disk, replacing any existing file atomically.
+     * @param manifestPath Path of the manifest file
+     * @return true if saved
+     */
+    bool save(const std::string& manifestPath) const;
+
+    /**
+     * Look up a file record.
+     * @param path Path of the file
+     * @return The record, or nullptr if the file is not in the manifest
+     */
+    const FileRecord* findFile(const std::string& path) const;
+
+    /**
+     * Add or replace a file record.
+     * @param path Path of the file
+     * @param record The record
+     */
+    void setFile(const std::string& path, FileRecord record);
+
+    /**
+     * Remove a file record, if present.
+     * @param path Path of the file
+     */
+    void removeFile(const std::string& path);
+
+    /**
+     * Get the number of file records.
+     * @return File count
+     */
+    size_t getFileCount() const;
+
+    /**
+     * Get the number of symbols recorded across all files.
+     * @return Symbol count
+     */
+    size_t getSymbolCount() const;
+
+    /**
+     * Get the directory listings, for DirectoryWalker::setListingCache().
+     * @return Listings keyed by directory path
+     */
+    DirectoryWalker::ListingCache& getDirectories();
+    const DirectoryWalker::ListingCache& getDirectories() const;
+
+    const std::string& getRootPath() const;
+    const std::string& getFingerprint() const;
+
+private:
+    std::string rootPath_;
+    std::string fingerprint_;
+    std::unordered_map<std::string, FileRecord> files_;
+    size_t symbolCount_;
+    DirectoryWalker::ListingCache directories_;
+};
+
+}} // namespace codelve::scanner
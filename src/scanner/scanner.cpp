@@ -1,23 +1,346 @@
 // E:\codelve\src\scanner\scanner.cpp
 #include "scanner.h"
+#include "directory_walker.h"
+#include "ignore_rules.h"
+#include "git_index.h"
+#include "file_system.h"
+#include "file_reader.h"
+#include "pattern_matcher.h"
+#include "scan_manifest.h"
+#include "index_file.h"
+#include "cpp_lexer.h"
+#include "python_lexer.h"
+#include "js_lexer.h"
 #include "../utils/config.h"
 #include "../utils/logger.h"
+#include "../utils/thread_pool.h"
 #include <filesystem>
-#include <fstream>
 #include <sstream>
 #include <algorithm>
 #include <regex>
+#include <atomic>
+#include <deque>
+#include <condition_variable>
+#include <unordered_set>
+#include <chrono>
+#include <iomanip>
 
 namespace fs = std::filesystem;
 
 namespace codelve {
 namespace scanner {
 
+namespace {
+    // Files and directories modified this close to a scan may change again
+    // within the same mtime tick, so their stamps are not trusted next time
+    const int64_t kRacyWindowNs = 2000000000LL;
+    
+    // Whether a file is as the previous scan recorded it, going by its stamp
+    bool matchesRecord(const ScanManifest::FileRecord* known, const FileStamp& stamp) {
+        return known && !known->racy &&
+               known->size == stamp.size &&
+               known->mtime == stamp.mtime &&
+               known->inode == stamp.inode;
+    }
+}
+
+// A file found by the directory walk, and where its parse results ended
+// up when it was ingested on a worker thread
+struct Scanner::PendingFile {
+    std::string path;
+    FileStamp stamp;
+    
+    // What the previous scan recorded for this path, if anything
+    const ScanManifest::FileRecord* previous;
+    
+    size_t shard;
+    size_t symbolBegin;
+    size_t symbolEnd;
+    bool ingested;
+    
+    // Its read ahead, or FileReader::kNone if it is read when ingested
+    size_t readId;
+    
+    // Filled in by ingestFile for the next manifest
+    bool recorded;
+    bool unchanged;
+    bool reparsed;
+    bool duplicate;
+    ScanManifest::FileRecord record;
+};
+
+// Blobs in the index a scan is building by content hash, with the parse
+// results of the first file that had them and that file's path, to load its
+// body from. Each scan has its own; the index holds the blobs themselves.
+struct Scanner::BlobTable {
+    struct Entry {
+        std::weak_ptr<const FileBlob> blob;
+        std::string path;
+        std::shared_ptr<const FileSymbols> symbols;
+        uint32_t generalBegin = 0;
+    };
+    
+    std::mutex mutex;
+    std::unordered_multimap<uint64_t, Entry> entries;
+    
+    // Find a blob with exactly these bytes; the hash only narrows the search.
+    // Candidates' bodies are compared outside the lock, since they may have
+    // to be loaded.
+    bool find(uint64_t hash, 
+              std::string_view content, 
+              ContentStore& contents, 
+              std::shared_ptr<const FileBlob>& blob, 
+              std::shared_ptr<const FileBody>& body, 
+              Entry& found) {
+        std::vector<Entry> candidates;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            auto range = entries.equal_range(hash);
+            for (auto it = range.first; it != range.second; ++it) {
+                candidates.push_back(it->second);
+            }
+        }
+        for (auto& candidate : candidates) {
+            auto candidateBlob = candidate.blob.lock();
+            if (!candidateBlob || candidateBlob->size != content.size()) {
+                continue;
+            }
+            auto candidateBody = contents.get(candidate.path, candidateBlob);
+            if (candidateBody && candidateBody->content == content) {
+                blob = std::move(candidateBlob);
+                body = std::move(candidateBody);
+                found = std::move(candidate);
+                return true;
+            }
+        }
+        return false;
+    }
+    
+    void add(const std::shared_ptr<const FileBlob>& blob, 
+             const std::string& path, 
+             std::shared_ptr<const FileSymbols> symbols, 
+             uint32_t generalBegin) {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto range = entries.equal_range(blob->hash);
+        for (auto it = range.first; it != range.second; ++it) {
+            auto candidate = it->second.blob.lock();
+            if (!candidate || candidate == blob) {
+                it->second.blob = blob;
+                it->second.path = path;
+                it->second.symbols = std::move(symbols);
+                it->second.generalBegin = generalBegin;
+                return;
+            }
+        }
+        Entry entry;
+        entry.blob = blob;
+        entry.path = path;
+        entry.symbols = std::move(symbols);
+        entry.generalBegin = generalBegin;
+        entries.emplace(blob->hash, std::move(entry));
+    }
+};
+
+// The files of a two-phase scan, handed out for parsing in the order they
+// are read (see orderForReading) except where requests put files or whole
+// directories first. Each file is claimed
+// once, by a worker or by a thread that needs it parsed right away.
+struct Scanner::ParseQueue {
+    static const size_t kNone = SIZE_MAX;
+    
+    // Older requests beyond this many are forgotten
+    static const size_t kMaxRequests = 32;
+    
+    // Parses a claimed file into a shard; returns its blob, or null if rejected
+    using Ingest = std::function<std::shared_ptr<const FileBlob>(PendingFile& file, size_t shard)>;
+    
+    // A requested file or directory, as a range of byPath still to hand out
+    struct Request {
+        size_t cursor;
+        size_t end;
+    };
+    
+    std::deque<PendingFile>& files;
+    const size_t demandShard;
+    const Ingest ingest;
+    
+    std::unique_ptr<std::atomic<bool>[]> claimed;
+    const std::vector<size_t> order;
+    std::atomic<size_t> nextInOrder;
+    
+    // Indices of files sorted by path, so a directory is one range
+    std::vector<size_t> byPath;
+    
+    // Newest first
+    std::deque<Request> requests;
+    std::atomic<bool> requested;
+    
+    // Results of parsed files, for threads waiting on them
+    std::vector<char> done;
+    std::vector<std::shared_ptr<const FileBlob>> blobs;
+    std::mutex mutex;
+    std::condition_variable parsed;
+    
+    // Serializes parses on demand, which share one shard
+    std::mutex demandMutex;
+    
+    ParseQueue(std::deque<PendingFile>& files, std::vector<size_t> order, size_t demandShard, Ingest ingest)
+        : files(files),
+          demandShard(demandShard),
+          ingest(std::move(ingest)),
+          claimed(new std::atomic<bool>[files.size()]),
+          order(std::move(order)),
+          nextInOrder(0),
+          requested(false),
+          done(files.size(), 0),
+          blobs(files.size()) {
+        byPath.resize(files.size());
+        for (size_t i = 0; i < files.size(); i++) {
+            claimed[i] = false;
+            byPath[i] = i;
+        }
+        std::sort(byPath.begin(), byPath.end(), [&files](size_t a, size_t b) {
+            return files[a].path < files[b].path;
+        });
+    }
+    
+    bool claim(size_t index) {
+        return !claimed[index].exchange(true);
+    }
+    
+    // Claim the next file to parse, or get kNone when all are claimed
+    size_t next() {
+        if (requested.load()) {
+            std::lock_guard<std::mutex> lock(mutex);
+            while (!requests.empty()) {
+                Request& request = requests.front();
+                while (request.cursor < request.end) {
+                    size_t index = byPath[request.cursor++];
+                    if (claim(index)) {
+                        return index;
+                    }
+                }
+                requests.pop_front();
+            }
+            requested = false;
+        }
+        for (;;) {
+            size_t position = nextInOrder++;
+            if (position >= order.size()) {
+                return kNone;
+            }
+            if (claim(order[position])) {
+                return order[position];
+            }
+        }
+    }
+    
+    // Parse a claimed file and wake the threads waiting for it
+    void parse(size_t index, size_t shard) {
+        std::shared_ptr<const FileBlob> blob = ingest(files[index], shard);
+        std::lock_guard<std::mutex> lock(mutex);
+        done[index] = 1;
+        blobs[index] = std::move(blob);
+        parsed.notify_all();
+    }
+    
+    // Range of byPath holding a file, or everything below a directory
+    void findRange(const std::string& path, size_t& begin, size_t& end) const {
+        auto pathOf = [this](size_t index, const std::string& value) {
+            return files[index].path < value;
+        };
+        begin = std::lower_bound(byPath.begin(), byPath.end(), path, pathOf) - byPath.begin();
+        if (begin < byPath.size() && files[byPath[begin]].path == path) {
+            end = begin + 1;
+            return;
+        }
+        std::string prefix = path;
+        if (prefix.empty() || prefix.back() != fs::path::preferred_separator) {
+            prefix += static_cast<char>(fs::path::preferred_separator);
+        }
+        begin = std::lower_bound(byPath.begin(), byPath.end(), prefix, pathOf) - byPath.begin();
+        end = begin;
+        while (end < byPath.size() && files[byPath[end]].path.compare(0, prefix.size(), prefix) == 0) {
+            end++;
+        }
+    }
+    
+    // Put files or directories first, the first path before the others
+    void request(const std::vector<std::string>& paths) {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (auto path = paths.rbegin(); path != paths.rend(); ++path) {
+            Request added;
+            findRange(*path, added.cursor, added.end);
+            if (added.cursor < added.end) {
+                requests.push_front(added);
+            }
+        }
+        while (requests.size() > kMaxRequests) {
+            requests.pop_back();
+        }
+        requested = !requests.empty();
+    }
+    
+    // Parse a file on the calling thread, or wait for the thread parsing it
+    std::shared_ptr<const FileBlob> parseNow(const std::string& path) {
+        size_t begin = 0;
+        size_t end = 0;
+        findRange(path, begin, end);
+        if (begin == end || files[byPath[begin]].path != path) {
+            return nullptr;
+        }
+        size_t index = byPath[begin];
+        if (claim(index)) {
+            std::lock_guard<std::mutex> lock(demandMutex);
+            parse(index, demandShard);
+        }
+        std::unique_lock<std::mutex> lock(mutex);
+        parsed.wait(lock, [this, index]() { return done[index] != 0; });
+        return blobs[index];
+    }
+};
+
+const size_t Scanner::ParseQueue::kNone;
+
+ScanSession::ScanSession()
+    : queue_(nullptr) {
+}
+
+void ScanSession::prioritize(const std::vector<std::string>& paths) {
+    std::shared_lock<std::shared_mutex> lock(queueMutex_);
+    if (queue_) {
+        queue_->request(paths);
+    }
+}
+
+std::shared_ptr<const FileBlob> ScanSession::parseNow(const std::string& filePath) {
+    std::shared_lock<std::shared_mutex> lock(queueMutex_);
+    if (!queue_) {
+        return nullptr;
+    }
+    return queue_->parseNow(filePath);
+}
+
 Scanner::Scanner(std::shared_ptr<utils::Config> config)
     : config_(config),
       maxFileSize_(10 * 1024 * 1024),  // 10MB
       maxFileCount_(10000), 
-	    maxLineCount_(10000) {  // Default to 10,000 lines
+	    maxLineCount_(10000),  // Default to 10,000 lines
+      threadCount_(1),
+      twoPhase_(true),
+      incremental_(true),
+      cacheDirectory_("cache"),
+      deduplicateFiles_(true),
+      readAheadFiles_(32),
+      useIoUring_(true),
+      readOrder_(ReadOrder::Inode),
+      dropReadPages_(true),
+      persistentIndex_(true),
+      verifyIndexContents_(false),
+      useRegexParsers_(false),
+      sniffContent_(true),
+      useIgnoreFiles_(true),
+      useGitIndex_(false) {
     
  
     
@@ -37,6 +360,62 @@ Scanner::Scanner(std::shared_ptr<utils::Config> config)
     maxFileSize_ = config_->getInt("scanner.max_file_size_bytes", 10 * 1024 * 1024);
     maxFileCount_ = config_->getInt("scanner.max_file_count", 10000);
     maxLineCount_ = config_->getInt("scanner.max_line_count", 10000);
+    threadCount_ = utils::WorkStealingPool::resolveThreadCount(config_->getInt("scanner.thread_count", 0));
+    useRegexParsers_ = config_->getBool("scanner.use_regex_parsers", false);
+    incremental_ = config_->getBool("scanner.incremental", true);
+    cacheDirectory_ = config_->getString("scanner.cache_directory", "cache");
+    persistentIndex_ = config_->getBool("scanner.persistent_index", true);
+    verifyIndexContents_ = config_->getBool("scanner.verify_index_contents", false);
+    deduplicateFiles_ = config_->getBool("scanner.deduplicate_files", true);
+    sniffContent_ = config_->getBool("scanner.sniff_content", true);
+    useIgnoreFiles_ = config_->getBool("scanner.use_ignore_files", true);
+    useGitIndex_ = config_->getBool("scanner.use_git_index", false);
+    batchFiles_ = static_cast<size_t>(std::max(config_->getInt("scanner.publish_batch_files", 1000), 1));
+    twoPhase_ = config_->getBool("scanner.two_phase_scan", true);
+    readAheadFiles_ = static_cast<size_t>(std::max(config_->getInt("scanner.read_ahead_files", 32), 0));
+    useIoUring_ = config_->getBool("scanner.use_io_uring", true);
+    dropReadPages_ = config_->getBool("scanner.drop_read_pages", true);
+    std::string readOrder = config_->getString("scanner.read_order", "inode");
+    if (readOrder == "found") {
+        readOrder_ = ReadOrder::Found;
+    } else if (readOrder == "extent") {
+        readOrder_ = ReadOrder::Extent;
+    } else if (readOrder != "inode") {
+        utils::Logger::log(utils::LogLevel::WARNING, "Scanner: Unknown read order '" + readOrder + "', reading by inode");
+    }
+    
+    // Language-independent extractors, all run by the one pass over each file
+    analyzer_.addMatcher(std::make_unique<TodoMatcher>());
+    analyzer_.addMatcher(std::make_unique<ConstantMatcher>());
+    
+    // Configured patterns, as kind:pattern entries, compiled into one more matcher
+    symbolPatterns_ = config_->getString("scanner.symbol_patterns", "");
+    auto patterns = std::make_unique<PatternMatcher>();
+    std::istringstream patternList(symbolPatterns_);
+    std::string entry;
+    while (std::getline(patternList, entry, ',')) {
+        entry.erase(0, entry.find_first_not_of(" \t\n\r\f\v"));
+        entry.erase(entry.find_last_not_of(" \t\n\r\f\v") + 1);
+        if (entry.empty()) {
+            continue;
+        }
+        size_t colon = entry.find(':');
+        std::string kindName = colon == std::string::npos ? std::string() : entry.substr(0, colon);
+        SymbolKind kind = symbolKindFromName(kindName);
+        if ((kind == SymbolKind::Other && kindName != "other") || !patterns->addPattern(kind, entry.substr(colon + 1))) {
+            utils::Logger::log(utils::LogLevel::WARNING, "Scanner: Ignoring symbol pattern '" + entry + "'");
+        }
+    }
+    if (patterns->getPatternCount() > 0) {
+        utils::Logger::log(utils::LogLevel::INFO, "Scanner: Matching " + std::to_string(patterns->getPatternCount()) + 
+                                                   " configured symbol patterns");
+        analyzer_.addMatcher(std::move(patterns));
+    }
+    
+    // File bodies beyond the budget are dropped and read again when needed
+    size_t contentCacheMb = static_cast<size_t>(std::max(config_->getInt("scanner.content_cache_mb", 512), 0));
+    bool compressContents = config_->getBool("scanner.compress_contents", false);
+    contents_ = std::make_shared<ContentStore>(contentCacheMb * 1024 * 1024, compressContents);
     
     // Load custom supported extensions if configured
     std::string customExtensions = config_->getString("scanner.supported_extensions", "");
@@ -76,7 +455,8 @@ Scanner::Scanner(std::shared_ptr<utils::Config> config)
     
     utils::Logger::log(utils::LogLevel::INFO, "Scanner: Initialized with " + 
                                                std::to_string(supportedExtensions_.size()) + 
-                                               " supported extensions");
+                                               " supported extensions and " +
+                                               std::to_string(threadCount_) + " scan threads");
 }
 
 Scanner::~Scanner() {
@@ -87,8 +467,16 @@ void Scanner::setProgressCallback(ScanProgressCallback callback) {
     progressCallback_ = callback;
 }
 
-IndexedCode Scanner::scanDirectory(const std::string& directoryPath) {
+void Scanner::setBatchCallback(ScanBatchCallback callback) {
+    batchCallback_ = callback;
+}
+
+IndexedCode Scanner::scanDirectory(const std::string& directoryPath, 
+                                   const IndexedCode* previous, 
+                                   ScanSession* session) {
     IndexedCode indexedCode;
+    indexedCode.rootPath = directoryPath;
+    indexedCode.contents = contents_;
     indexedCode.totalSize = 0;
     indexedCode.fileCount = 0;
     
@@ -99,121 +487,416 @@ IndexedCode Scanner::scanDirectory(const std::string& directoryPath) {
     
     utils::Logger::log(utils::LogLevel::INFO, "Scanner: Starting scan of directory: " + directoryPath);
     
+    resetParserTimings();
+    resetContentTallies();
+    
     try {
-        // First pass: count files to scan
-        size_t totalFiles = 0;
-        for (const auto& entry : fs::recursive_directory_iterator(directoryPath)) {
-            if (entry.is_regular_file() && isRelevantFile(entry.path().string())) {
-                totalFiles++;
+        // The previous scan's manifest, and the one this scan builds; a saved
+        // index takes its symbols from the new one even when it is not kept
+        std::unique_ptr<ScanManifest> oldManifest;
+        std::unique_ptr<ScanManifest> newManifest;
+        if (incremental_) {
+            oldManifest = takeManifest(directoryPath);
+        }
+        if (incremental_ || persistentIndex_) {
+            newManifest = std::make_unique<ScanManifest>(directoryPath, getManifestFingerprint());
+        }
+        
+        // Contents are shared only within the index this scan builds
+        std::unique_ptr<BlobTable> blobs = deduplicateFiles_ ? std::make_unique<BlobTable>() : nullptr;
+        
+        // Files that have to be read are read ahead, keeping the disk busy
+        // while the parsers work
+        std::unique_ptr<FileReader> reader = readAheadFiles_ > 0 ? std::make_unique<FileReader>(readAheadFiles_, useIoUring_, dropReadPages_) : nullptr;
+        
+        // Bodies of indexes that are gone no longer count against the budget
+        contents_->purge();
+        
+        // File contents of an earlier index are only reused alongside its manifest
+        if (previous && (!oldManifest || previous->rootPath != directoryPath)) {
+            previous = nullptr;
+        }
+        
+        int64_t trustBefore = currentFileTime() - kRacyWindowNs;
+        
+        // The tracked files of a git checkout, when its index can stand in for the walk
+        std::unique_ptr<GitIndex> gitIndex;
+        if (useGitIndex_) {
+            gitIndex = std::make_unique<GitIndex>();
+            if (!gitIndex->load(directoryPath)) {
+                gitIndex.reset();
             }
-            
-            // Limit scan to max file count
-            if (totalFiles > maxFileCount_) {
-                break;
+        }
+        
+        // Single pass over the tree: files are handed to the parser as soon as
+        // they are found, and excluded directories are never opened
+        DirectoryWalker walker(excludeDirectories_);
+        walker.setIgnoreFiles(useIgnoreFiles_);
+        walker.setThreadCount(threadCount_);
+        if (newManifest) {
+            walker.setListingCache(oldManifest ? &oldManifest->getDirectories() : nullptr,
+                                   &newManifest->getDirectories(), trustBefore);
+        }
+        
+        // A deque keeps element addresses stable while the walk appends to it
+        std::deque<PendingFile> pendingFiles;
+        std::atomic<size_t> foundFiles(0);
+        std::atomic<size_t> processedFiles(0);
+        std::atomic<size_t> trackedFilesSeen(0);
+        
+        auto estimateFiles = [&walker, &gitIndex, &foundFiles, &trackedFilesSeen](size_t done, bool& finished) {
+            if (gitIndex) {
+                // Assume the tracked files still to come are kept as often as those seen so far
+                size_t seen = std::max<size_t>(trackedFilesSeen.load(), 1);
+                size_t tracked = gitIndex->getFiles().size();
+                finished = seen >= tracked;
+                return std::max(foundFiles.load() * tracked / seen, done);
             }
-            
-            // Check if the current directory should be excluded
-            fs::path currentPath = entry.path();
-            std::string dirName = currentPath.filename().string();
-            if (entry.is_directory() && 
-                std::find(excludeDirectories_.begin(), excludeDirectories_.end(), dirName) != excludeDirectories_.end()) {
-                utils::Logger::log(utils::LogLevel::DEBUG, "Scanner: Skipping excluded directory: " + currentPath.string());
-                continue;
+            finished = walker.isFinished();
+            return std::max(walker.estimateTotal(foundFiles.load()), done);
+        };
+        
+        auto onFileProcessed = [this, &estimateFiles, &processedFiles]() {
+            size_t done = processedFiles.fetch_add(1) + 1;
+            bool finished = false;
+            size_t estimate = estimateFiles(done, finished);
+            std::string total = finished ? std::to_string(estimate) : "~" + std::to_string(estimate);
+            reportProgress("Scanning files", 
+                           static_cast<float>(done) / static_cast<float>(estimate),
+                           "Processed " + std::to_string(done) + " of " + total + " files");
+        };
+        
+        // Indexed files are also handed out in batches as they come, so they
+        // can be queried before the scan ends. Each file is added by the
+        // thread that ingested it, from the index or shard it went into.
+        std::mutex batchMutex;
+        ScanBatch batch;
+        auto publishBatch = [this, &directoryPath, &estimateFiles, &processedFiles](ScanBatch& full) {
+            bool finished = false;
+            full.rootPath = directoryPath;
+            full.contents = contents_;
+            full.filesProcessed = processedFiles.load();
+            full.filesEstimated = estimateFiles(full.filesProcessed, finished);
+            batchCallback_(std::move(full));
+        };
+        auto onFileIndexed = [this, &batchMutex, &batch, &publishBatch](const PendingFile& file, const IndexedCode& source) {
+            ScanBatch full;
+            {
+                std::lock_guard<std::mutex> lock(batchMutex);
+                batch.files.emplace_back(file.path, source.files.at(file.path));
+                for (size_t i = file.symbolBegin + file.record.generalBegin; i < file.symbolEnd; i++) {
+                    batch.symbols.add(source.symbolDetails.getName(i), file.path);
+                }
+                if (batch.files.size() < batchFiles_) {
+                    return;
+                }
+                full = std::move(batch);
+                batch = ScanBatch();
+            }
+            publishBatch(full);
+        };
+        
+        // A first scan whose results are being published to queries, which
+        // reach it through its session, lists the whole tree before parsing
+        // any of it, so every file is known by name at once; parsing then
+        // follows what queries ask for (see ParseQueue)
+        bool twoPhase = twoPhase_ && batchCallback_ && session;
+        
+        // With more than one thread, files are read and parsed on a pool while
+        // the walk continues; each worker fills its own shard. A two-phase
+        // scan has one more shard for files parsed on demand. The pool is
+        // declared last so it drains before the state its tasks use goes away.
+        std::vector<IndexedCode> shards;
+        std::unique_ptr<utils::WorkStealingPool> pool;
+        if (threadCount_ > 1 || twoPhase) {
+            shards.resize(threadCount_ + (twoPhase ? 1 : 0));
+            for (auto& shard : shards) {
+                shard.totalSize = 0;
+                shard.fileCount = 0;
             }
         }
+        if (threadCount_ > 1) {
+            pool = std::make_unique<utils::WorkStealingPool>(threadCount_);
+        }
         
-        // Report initial progress
-        if (progressCallback_) {
-            progressCallback_("Counting files", 0.0f, "Found " + std::to_string(totalFiles) + " relevant files");
+        // A rescan will end up with about as many symbols as the last scan
+        if (oldManifest) {
+            indexedCode.symbolDetails.reserve(oldManifest->getSymbolCount());
+            for (auto& shard : shards) {
+                shard.symbolDetails.reserve(oldManifest->getSymbolCount() / shards.size());
+            }
         }
         
-        // Second pass: scan files
-        size_t processedFiles = 0;
-        for (const auto& entry : fs::recursive_directory_iterator(directoryPath)) {
-            // Check if the current directory should be excluded
-            fs::path currentPath = entry.path();
-            std::string dirName = currentPath.filename().string();
-            if (entry.is_directory()) {
-                // Add to directory list
-                indexedCode.directories.push_back(currentPath.string());
-                
-                // Skip excluded directories
-                if (std::find(excludeDirectories_.begin(), excludeDirectories_.end(), dirName) != excludeDirectories_.end()) {
-                    utils::Logger::log(utils::LogLevel::DEBUG, "Scanner: Skipping excluded directory: " + currentPath.string());
-                    continue;
-                }
-                continue;
+        // Ingest a file into a shard, on the thread that owns the shard
+        auto ingestInShard = [this, previous, &blobs, &reader, &shards, &onFileProcessed, &onFileIndexed](PendingFile& file, size_t shardIndex) {
+            IndexedCode& shard = shards[shardIndex];
+            file.shard = shardIndex;
+            file.symbolBegin = shard.symbolDetails.size();
+            file.ingested = ingestFile(file, previous, shard, blobs.get(), reader.get());
+            file.symbolEnd = shard.symbolDetails.size();
+            onFileProcessed();
+            if (file.ingested && batchCallback_) {
+                onFileIndexed(file, shard);
             }
-            
-            if (!entry.is_regular_file() || !isRelevantFile(entry.path().string())) {
-                continue;
+        };
+        
+        // Ingest a file into the index itself, on the scan thread
+        auto ingestHere = [this, previous, &blobs, &reader, &indexedCode, &onFileProcessed, &onFileIndexed](PendingFile& file) {
+            file.symbolBegin = indexedCode.symbolDetails.size();
+            file.ingested = ingestFile(file, previous, indexedCode, blobs.get(), reader.get());
+            file.symbolEnd = indexedCode.symbolDetails.size();
+            onFileProcessed();
+            if (file.ingested && batchCallback_) {
+                onFileIndexed(file, indexedCode);
+            }
+        };
+        
+        // Files found and not yet handed to ingestion
+        std::deque<PendingFile*> ingestOrder;
+        std::mutex ingestOrderMutex;
+        
+        auto onDirectory = [&indexedCode](const std::string& path) {
+            indexedCode.directories.push_back(path);
+        };
+        auto onFile = [&](const std::string& path, const FileStamp& stamp) {
+            if (!isRelevantFile(path)) {
+                return true;
             }
             
             // Check file size
-            auto fileSize = entry.file_size();
-            if (fileSize > maxFileSize_) {
-                utils::Logger::log(utils::LogLevel::DEBUG, "Scanner: Skipping large file: " + entry.path().string());
-                continue;
+            if (stamp.size > maxFileSize_) {
+                utils::Logger::log(utils::LogLevel::DEBUG, "Scanner: Skipping large file: " + path);
+                return true;
             }
             
-            // Read file content
-            std::ifstream file(entry.path(), std::ios::in);
-            if (!file) {
-                utils::Logger::log(utils::LogLevel::WARNING, "Scanner: Failed to open file: " + entry.path().string());
-                continue;
+            PendingFile pending;
+            pending.path = path;
+            pending.stamp = stamp;
+            pending.previous = oldManifest ? oldManifest->findFile(path) : nullptr;
+            pending.shard = 0;
+            pending.symbolBegin = 0;
+            pending.symbolEnd = 0;
+            pending.ingested = false;
+            pending.readId = FileReader::kNone;
+            if (reader && !twoPhase && !matchesRecord(pending.previous, stamp)) {
+                pending.readId = reader->add(path, stamp.size);
             }
+            pending.recorded = false;
+            pending.unchanged = false;
+            pending.reparsed = false;
+            pending.duplicate = false;
+            pendingFiles.push_back(std::move(pending));
+            foundFiles++;
+            PendingFile* file = &pendingFiles.back();
             
-            std::stringstream buffer;
-            buffer << file.rdbuf();
-            std::string content = buffer.str();
-			// Count the number of lines in the file
-size_t lineCount = std::count(content.begin(), content.end(), '\n') + 1;
-if (lineCount > maxLineCount_) {
-    utils::Logger::log(utils::LogLevel::DEBUG, 
-        "Scanner: Skipping file with excessive line count (" + 
-        std::to_string(lineCount) + " lines): " + entry.path().string());
-    continue;
-}
+            if (twoPhase) {
+                // Parsed once the walk is done
+            } else if (pool) {
+                // Each task takes the oldest file waiting, the order they are read ahead in
+                std::lock_guard<std::mutex> lock(ingestOrderMutex);
+                ingestOrder.push_back(file);
+                pool->submit([&ingestOrder, &ingestOrderMutex, &ingestInShard](size_t worker) {
+                    PendingFile* next;
+                    {
+                        std::lock_guard<std::mutex> lock(ingestOrderMutex);
+                        next = ingestOrder.front();
+                        ingestOrder.pop_front();
+                    }
+                    ingestInShard(*next, worker);
+                });
+            } else {
+                // Parsing trails the walk by the files being read ahead
+                ingestOrder.push_back(file);
+                while (ingestOrder.size() > (reader ? readAheadFiles_ : 0)) {
+                    ingestHere(*ingestOrder.front());
+                    ingestOrder.pop_front();
+                }
+            }
             
-            // Add file to indexed code
-            std::string filePath = entry.path().string();
-            indexedCode.files[filePath] = content;
+            // Limit scan to max file count
+            if (pendingFiles.size() >= maxFileCount_) {
+                utils::Logger::log(utils::LogLevel::WARNING, "Scanner: Reached maximum file count limit");
+                return false;
+            }
+            return true;
+        };
+        
+        // In a git checkout the index already lists the files, so no directory is read
+        if (gitIndex) {
+            walkTrackedFiles(*gitIndex, directoryPath, onDirectory, onFile, trackedFilesSeen);
+        } else {
+            auto walkStarted = std::chrono::steady_clock::now();
+            walker.walk(directoryPath, onDirectory, onFile);
+            auto walkTime = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - walkStarted);
+            utils::Logger::log(utils::LogLevel::INFO, "Scanner: Walked the tree in " + std::to_string(walkTime.count()) +
+                                                       " ms, reading directories on " +
+                                                       std::to_string(threadCount_) + " threads");
+        }
+        
+        // A serial scan still has the files it trailed the walk by
+        if (!pool) {
+            for (PendingFile* file : ingestOrder) {
+                ingestHere(*file);
+            }
+            ingestOrder.clear();
+        }
+        
+        if (twoPhase) {
+            // The whole list is known, so the reads can go in disk order
+            std::vector<size_t> order = orderForReading(pendingFiles);
+            if (reader) {
+                for (size_t index : order) {
+                    PendingFile& file = pendingFiles[index];
+                    if (!matchesRecord(file.previous, file.stamp)) {
+                        file.readId = reader->add(file.path, file.stamp.size);
+                    }
+                }
+            }
             
-            // Add file extension to list if not already present
-            std::string ext = fs::path(filePath).extension().string();
-            if (!ext.empty() && 
-                std::find(indexedCode.fileExtensions.begin(), indexedCode.fileExtensions.end(), ext) == indexedCode.fileExtensions.end()) {
-                indexedCode.fileExtensions.push_back(ext);
+            // The queue goes in before the files are published, so a query
+            // for any of them can have it parsed at once
+            ParseQueue queue(pendingFiles, std::move(order), threadCount_, [&ingestInShard, &shards](PendingFile& file, size_t shardIndex) {
+                ingestInShard(file, shardIndex);
+                return file.ingested ? shards[shardIndex].files.at(file.path) : nullptr;
+            });
+            {
+                std::unique_lock<std::shared_mutex> lock(session->queueMutex_);
+                session->queue_ = &queue;
             }
             
-            // Parse file to extract symbols
-            parseFile(filePath, content, indexedCode);
+            // Phase one: publish every file by name, with no blob yet
+            ScanBatch listing;
+            for (const auto& file : pendingFiles) {
+                listing.files.emplace_back(file.path, nullptr);
+            }
+            publishBatch(listing);
             
-            // Update statistics
-            indexedCode.totalSize += fileSize;
-            indexedCode.fileCount++;
-            processedFiles++;
+            // Phase two: parse, with each worker claiming files from the queue
+            auto work = [&queue](size_t shardIndex) {
+                for (size_t index = queue.next(); index != ParseQueue::kNone; index = queue.next()) {
+                    queue.parse(index, shardIndex);
+                }
+            };
+            if (pool) {
+                for (size_t i = 0; i < pool->size(); i++) {
+                    pool->submit(work);
+                }
+                pool->wait();
+            } else {
+                work(0);
+            }
             
-            // Report progress
-            if (progressCallback_) {
-                float progress = static_cast<float>(processedFiles) / static_cast<float>(totalFiles);
-                progressCallback_("Scanning files", progress, "Processed " + std::to_string(processedFiles) + " of " + std::to_string(totalFiles) + " files");
+            // Parses on demand still running hold the lock
+            std::unique_lock<std::shared_mutex> lock(session->queueMutex_);
+            session->queue_ = nullptr;
+        }
+        
+        if (pool) {
+            pool->wait();
+        }
+        if (reader) {
+            utils::Logger::log(utils::LogLevel::INFO, "Scanner: Read ahead " + reader->getReport());
+            reader.reset();
+        }
+        if (batchCallback_ && !batch.files.empty()) {
+            publishBatch(batch);
+        }
+        if (!shards.empty()) {
+            mergeShards(pendingFiles, shards, indexedCode);
+        }
+        indexedCode.symbols.build();
+        
+        if (blobs) {
+            size_t duplicateFiles = 0;
+            uint64_t duplicateBytes = 0;
+            for (const auto& file : pendingFiles) {
+                if (file.ingested && file.duplicate) {
+                    duplicateFiles++;
+                    duplicateBytes += file.stamp.size;
+                }
+            }
+            utils::Logger::log(utils::LogLevel::INFO, "Scanner: " + std::to_string(duplicateFiles) + 
+                                                       " files duplicate others; " + std::to_string(duplicateBytes) + 
+                                                       " bytes stored and parsed once");
+        }
+        
+        // The manifest and the cache files are shared with live updates and
+        // with any other scan of this scanner
+        std::unique_lock<std::mutex> manifestLock(manifestMutex_);
+        
+        // Without a manifest to compare against, assume everything changed
+        bool treeChanged = true;
+        if (newManifest) {
+            // Record every file for the next scan; files that vanished since the
+            // last one are simply not carried over
+            size_t unchangedFiles = 0;
+            size_t reparsedFiles = 0;
+            size_t knownFiles = 0;
+            for (auto& file : pendingFiles) {
+                knownFiles += file.previous ? 1 : 0;
+                unchangedFiles += file.unchanged ? 1 : 0;
+                reparsedFiles += file.reparsed ? 1 : 0;
+                if (file.recorded) {
+                    file.record.racy = file.record.mtime >= trustBefore;
+                    newManifest->setFile(file.path, std::move(file.record));
+                }
             }
             
-            // Limit scan to max file count
-            if (processedFiles >= maxFileCount_) {
-                utils::Logger::log(utils::LogLevel::WARNING, "Scanner: Reached maximum file count limit");
-                break;
+            size_t oldFileCount = oldManifest ? oldManifest->getFileCount() : 0;
+            size_t removedFiles = oldFileCount - knownFiles;
+            bool changed = !oldManifest || unchangedFiles != newManifest->getFileCount() ||
+                           newManifest->getFileCount() != oldFileCount ||
+                           walker.getReusedCount() != newManifest->getDirectories().size();
+            
+            if (incremental_) {
+                utils::Logger::log(utils::LogLevel::INFO, "Scanner: Incremental scan kept " + std::to_string(unchangedFiles) +
+                                                           " unchanged files, parsed " + std::to_string(reparsedFiles) +
+                                                           ", dropped " + std::to_string(removedFiles) +
+                                                           "; reused " + std::to_string(walker.getReusedCount()) +
+                                                           " directory listings");
+                
+                // Nothing to write when the tree is exactly as recorded
+                if (changed) {
+                    newManifest->save(getManifestPath(directoryPath));
+                }
             }
+            treeChanged = changed;
+            manifest_ = std::move(newManifest);
         }
         
-        // Report completion
-        if (progressCallback_) {
-            progressCallback_("Scan complete", 1.0f, "Scanned " + std::to_string(processedFiles) + " files");
+        if (persistentIndex_) {
+            std::string indexPath = getIndexPath(directoryPath);
+            if (treeChanged || !fs::exists(indexPath)) {
+                // Never leave an older index behind to be mistaken for this scan
+                if (!IndexFile::write(indexedCode, *manifest_, getManifestFingerprint(), indexPath)) {
+                    std::error_code ec;
+                    fs::remove(indexPath, ec);
+                }
+            }
         }
+        manifestLock.unlock();
+        
+        // Report completion
+        reportProgress("Scan complete", 1.0f, "Scanned " + std::to_string(indexedCode.fileCount) + " files");
         
         utils::Logger::log(utils::LogLevel::INFO, "Scanner: Completed scan of directory: " + directoryPath);
         utils::Logger::log(utils::LogLevel::INFO, "Scanner: Found " + std::to_string(indexedCode.fileCount) + " files with total size " + std::to_string(indexedCode.totalSize) + " bytes");
+        if (gitIndex) {
+            utils::Logger::log(utils::LogLevel::INFO, "Scanner: Listed " + std::to_string(gitIndex->getFiles().size()) + 
+                                                       " tracked files from the git index (version " + 
+                                                       std::to_string(gitIndex->getVersion()) + ") instead of walking");
+        } else {
+            utils::Logger::log(utils::LogLevel::INFO, "Scanner: Pruned " + std::to_string(walker.getPrunedCount()) + " excluded directories");
+        }
+        if (useIgnoreFiles_ && !gitIndex) {
+            utils::Logger::log(utils::LogLevel::INFO, "Scanner: Ignore files excluded " + 
+                                                       std::to_string(walker.getIgnoredDirectoryCount()) + " directories and " + 
+                                                       std::to_string(walker.getIgnoredFileCount()) + " files");
+        }
+        utils::Logger::log(utils::LogLevel::INFO, "Scanner: Symbol table holds " + indexedCode.symbolDetails.getSizeReport());
+        utils::Logger::log(utils::LogLevel::INFO, "Scanner: Content cache holds " + contents_->getReport());
+        logParserTimings();
+        logContentTallies();
         
     } catch (const std::exception& e) {
         utils::Logger::log(utils::LogLevel::ERROR, "Scanner: Error scanning directory: " + std::string(e.what()));
@@ -222,9 +905,666 @@ if (lineCount > maxLineCount_) {
     return indexedCode;
 }
 
+std::vector<std::string> Scanner::updateFiles(IndexedCode& indexedCode, const std::vector<std::string>& paths) {
+    // The manifest only follows along if it describes this index
+    std::lock_guard<std::mutex> manifestLock(manifestMutex_);
+    ScanManifest* manifest = manifest_ && manifest_->getRootPath() == indexedCode.rootPath ? manifest_.get() : nullptr;
+    
+    // Sort the reported paths into files to (re)ingest and files to drop
+    std::unordered_set<std::string> affected;
+    std::vector<PendingFile> pendingFiles;
+    std::unordered_map<std::string, std::shared_ptr<const IgnoreScope>> ignoreScopes;
+    
+    // Indexed paths in order, sorted the first time a directory goes away
+    std::vector<std::string> sortedFiles;
+    for (const auto& path : paths) {
+        FileStamp stamp;
+        bool exists = statPath(path, stamp);
+        
+        // An ignored path is treated like a deleted one, so nothing below it stays indexed
+        if (exists && useIgnoreFiles_ && isIgnoredPath(indexedCode.rootPath, path, stamp.isDirectory, ignoreScopes)) {
+            exists = false;
+        }
+        
+        if (exists && stamp.isDirectory) {
+            // Its files are reported on their own
+            if (path != indexedCode.rootPath &&
+                std::find(indexedCode.directories.begin(), indexedCode.directories.end(), path) == indexedCode.directories.end()) {
+                indexedCode.directories.push_back(path);
+            }
+            continue;
+        }
+        
+        bool indexable = exists && stamp.isRegular && isRelevantFile(path) && stamp.size <= maxFileSize_;
+        bool known = indexedCode.files.count(path) != 0;
+        if (indexable && (known || indexedCode.fileCount < maxFileCount_)) {
+            affected.insert(path);
+            
+            PendingFile pending;
+            pending.path = path;
+            pending.stamp = stamp;
+            pending.previous = manifest ? manifest->findFile(path) : nullptr;
+            pending.shard = 0;
+            pending.symbolBegin = 0;
+            pending.symbolEnd = 0;
+            pending.ingested = false;
+            pending.readId = FileReader::kNone;
+            pending.recorded = false;
+            pending.unchanged = false;
+            pending.reparsed = false;
+            pending.duplicate = false;
+            pendingFiles.push_back(std::move(pending));
+            continue;
+        }
+        
+        // Gone, or no longer indexable: drop it and, for a directory the
+        // index knew, everything that was below it
+        if (known) {
+            affected.insert(path);
+        }
+        if (manifest) {
+            manifest->removeFile(path);
+        }
+        if (std::find(indexedCode.directories.begin(), indexedCode.directories.end(), path) == indexedCode.directories.end()) {
+            continue;
+        }
+        
+        // Files below the directory sort right after its prefix
+        if (sortedFiles.empty()) {
+            sortedFiles.reserve(indexedCode.files.size());
+            for (const auto& filePair : indexedCode.files) {
+                sortedFiles.push_back(filePair.first);
+            }
+            std::sort(sortedFiles.begin(), sortedFiles.end());
+        }
+        std::string prefix = (fs::path(path) / "").string();
+        for (auto it = std::lower_bound(sortedFiles.begin(), sortedFiles.end(), prefix);
+             it != sortedFiles.end() && it->compare(0, prefix.size(), prefix) == 0; ++it) {
+            affected.insert(*it);
+            if (manifest) {
+                manifest->removeFile(*it);
+            }
+        }
+        indexedCode.directories.erase(
+            std::remove_if(indexedCode.directories.begin(), indexedCode.directories.end(),
+                [&path, &prefix](const std::string& directory) {
+                    return directory == path || directory.compare(0, prefix.size(), prefix) == 0;
+                }),
+            indexedCode.directories.end());
+    }
+    
+    if (affected.empty()) {
+        return std::vector<std::string>();
+    }
+    
+    // Take out everything the affected files contributed. A file's symbols
+    // are contiguous, so the set is consulted once per run, not per symbol.
+    indexedCode.symbolDetails.removeFiles([&affected](std::string_view filePath) {
+        return affected.count(std::string(filePath)) != 0;
+    });
+    
+    indexedCode.symbols.removeFiles([&affected](std::string_view filePath) {
+        return affected.count(std::string(filePath)) != 0;
+    });
+    
+    for (const auto& path : affected) {
+        auto file = indexedCode.files.find(path);
+        if (file != indexedCode.files.end()) {
+            indexedCode.totalSize -= std::min<size_t>(indexedCode.totalSize, file->second->size);
+            indexedCode.fileCount--;
+            indexedCode.files.erase(file);
+        }
+    }
+    
+    // Parse the current contents
+    int64_t trustBefore = currentFileTime() - kRacyWindowNs;
+    size_t reparsedFiles = 0;
+    for (auto& file : pendingFiles) {
+        file.ingested = ingestFile(file, nullptr, indexedCode, nullptr, nullptr);
+        reparsedFiles += file.ingested ? 1 : 0;
+        if (manifest) {
+            if (file.recorded) {
+                file.record.racy = file.record.mtime >= trustBefore;
+                manifest->setFile(file.path, std::move(file.record));
+            } else {
+                manifest->removeFile(file.path);
+            }
+        }
+    }
+    
+    indexedCode.symbols.build();
+    contents_->purge();
+    
+    std::vector<std::string> changedFiles(affected.begin(), affected.end());
+    std::sort(changedFiles.begin(), changedFiles.end());
+    
+    utils::Logger::log(utils::LogLevel::INFO, "Scanner: Live update reparsed " + std::to_string(reparsedFiles) +
+                                               " files, dropped " + std::to_string(changedFiles.size() - reparsedFiles));
+    return changedFiles;
+}
+
+bool Scanner::ingestFile(PendingFile& file, const IndexedCode* previous, IndexedCode& indexedCode, 
+                         BlobTable* blobs, FileReader* reader) {
+    const ScanManifest::FileRecord* known = file.previous;
+    bool stampMatches = matchesRecord(known, file.stamp);
+    
+    ScanManifest::FileRecord& record = file.record;
+    record.size = file.stamp.size;
+    record.mtime = file.stamp.mtime;
+    record.inode = file.stamp.inode;
+    record.hash = 0;
+    record.ingested = false;
+    record.racy = false;
+    record.contentClass = stampMatches ? known->contentClass : ContentClass::Source;
+    record.generalBegin = 0;
+    
+    // Unchanged and rejected by the last scan: still rejected
+    if (stampMatches && !known->ingested) {
+        record.hash = known->hash;
+        file.recorded = true;
+        file.unchanged = true;
+        tallyContent(record.contentClass, file.stamp.size);
+        return false;
+    }
+    
+    // Unchanged files share their blob with the previous index if it has them
+    std::shared_ptr<const FileBlob> blob;
+    if (stampMatches && previous) {
+        auto previousFile = previous->files.find(file.path);
+        if (previousFile != previous->files.end()) {
+            blob = previousFile->second;
+        }
+    }
+    
+    // Unchanged files with recorded parse results are neither read nor
+    // parsed; without a previous index their blob is rebuilt from the
+    // manifest, and the body is loaded only when something asks for it
+    bool reuse = stampMatches && known->symbols;
+    if (reuse && !blob) {
+        auto newBlob = std::make_shared<FileBlob>();
+        newBlob->hash = known->hash;
+        newBlob->size = file.stamp.size;
+        blob = std::move(newBlob);
+    }
+    
+    // Read the file; parsers read straight from the buffer, which the body
+    // takes over without copying
+    MappedFile source;
+    std::string_view content;
+    std::shared_ptr<const FileBody> body;
+    BlobTable::Entry duplicate;
+    if (reuse) {
+        record.hash = blob->hash;
+        tallyContent(record.contentClass, file.stamp.size);
+    } else {
+        if (blob) {
+            body = contents_->get(file.path, blob);
+            if (body) {
+                content = body->content;
+                record.hash = blob->hash;
+            } else {
+                blob.reset();
+            }
+        }
+        if (!blob) {
+            std::string readAhead;
+            if (file.readId != FileReader::kNone && reader && reader->take(file.readId, readAhead)) {
+                source.assign(std::move(readAhead));
+            } else if (!source.open(file.path)) {
+                utils::Logger::log(utils::LogLevel::WARNING, "Scanner: Failed to open file: " + file.path);
+                return false;
+            }
+            content = source.view();
+            
+            // Only the first page is touched to reject a file, and nothing is hashed
+            if (sniffContent_ && !stampMatches) {
+                record.contentClass = ContentSniffer::classify(content);
+            }
+            if (record.contentClass == ContentClass::Binary || record.contentClass == ContentClass::Minified) {
+                utils::Logger::log(utils::LogLevel::DEBUG, std::string("Scanner: Skipping ") + 
+                    ContentSniffer::getName(record.contentClass) + " file: " + file.path);
+                file.recorded = true;
+                file.unchanged = stampMatches;
+                tallyContent(record.contentClass, file.stamp.size);
+                return false;
+            }
+            record.hash = stampMatches ? known->hash : hashContent(content);
+        }
+        tallyContent(record.contentClass, file.stamp.size);
+        
+        // A copy of a file already in the index takes its blob and parse results
+        if (!blob && blobs && blobs->find(record.hash, content, *contents_, blob, body, duplicate)) {
+            content = body->content;
+            source.close();
+            file.duplicate = true;
+        }
+        
+        // A touched but byte-identical file keeps its parse results too
+        reuse = known && known->ingested && known->symbols && known->hash == record.hash;
+        if (reuse && !blob) {
+            auto newBlob = std::make_shared<FileBlob>();
+            newBlob->hash = record.hash;
+            newBlob->size = content.size();
+            blob = std::move(newBlob);
+        }
+    }
+    file.recorded = true;
+    file.unchanged = stampMatches;
+    
+    // Index line starts; this also gives the line count. Reused files
+    // passed this check when they were parsed, under the same limit. The
+    // same pass finds the language-independent symbols of files to parse.
+    FileAnalysis analysis;
+    bool analyzed = false;
+    if (!reuse || body) {
+        if (!body) {
+            analyze(content, record.contentClass != ContentClass::Generated, analysis);
+            analyzed = true;
+        }
+        size_t lineCount = body ? body->lines.lineCount() : analysis.lines.lineCount();
+        if (lineCount > maxLineCount_) {
+            utils::Logger::log(utils::LogLevel::DEBUG, 
+                "Scanner: Skipping file with excessive line count (" + 
+                std::to_string(lineCount) + " lines): " + file.path);
+            return false;
+        }
+        
+        if (!body) {
+            auto newBody = std::make_shared<FileBody>();
+            newBody->content = source.takeContent();
+            newBody->lines = std::move(analysis.lines);
+            auto newBlob = std::make_shared<FileBlob>();
+            newBlob->hash = record.hash;
+            newBlob->size = newBody->content.size();
+            blob = std::move(newBlob);
+            body = std::move(newBody);
+            content = body->content;
+            contents_->put(blob, body);
+        }
+    }
+    
+    // Add file extension to list if not already present
+    std::string ext(getExtension(file.path));
+    if (!ext.empty() && 
+        std::find(indexedCode.fileExtensions.begin(), indexedCode.fileExtensions.end(), ext) == indexedCode.fileExtensions.end()) {
+        indexedCode.fileExtensions.push_back(ext);
+    }
+    
+    if (reuse) {
+        addRecordedSymbols(file.path, *known->symbols, known->generalBegin, indexedCode);
+        record.symbols = known->symbols;
+        record.generalBegin = known->generalBegin;
+    } else if (duplicate.symbols) {
+        addRecordedSymbols(file.path, *duplicate.symbols, duplicate.generalBegin, indexedCode);
+        record.symbols = duplicate.symbols;
+        record.generalBegin = duplicate.generalBegin;
+    } else if (record.contentClass == ContentClass::Generated) {
+        // Kept for context, but its symbols would only crowd out hand-written ones
+        utils::Logger::log(utils::LogLevel::DEBUG, "Scanner: Indexing generated file without symbols: " + file.path);
+        if (incremental_ || persistentIndex_ || blobs) {
+            record.symbols = std::make_shared<const FileSymbols>();
+        }
+    } else {
+        // Parse file to extract symbols
+        if (!analyzed) {
+            analyze(content, true, analysis);
+        }
+        size_t symbolBegin = indexedCode.symbolDetails.size();
+        size_t generalBegin = parseFile(file.path, content, body->lines, analysis, indexedCode);
+        file.reparsed = true;
+        
+        record.generalBegin = static_cast<uint32_t>(generalBegin - symbolBegin);
+        if (incremental_ || persistentIndex_ || blobs) {
+            record.symbols = std::make_shared<const FileSymbols>(
+                indexedCode.symbolDetails.extractFile(symbolBegin, indexedCode.symbolDetails.size(), content));
+        }
+    }
+    record.ingested = true;
+    
+    if (blobs && !file.duplicate) {
+        blobs->add(blob, file.path, record.symbols, record.generalBegin);
+    }
+    
+    // Add file to indexed code
+    indexedCode.files[file.path] = std::move(blob);
+    
+    // Update statistics
+    indexedCode.totalSize += file.stamp.size;
+    indexedCode.fileCount++;
+    return true;
+}
+
+void Scanner::addRecordedSymbols(const std::string& filePath, 
+                                 const FileSymbols& symbols, 
+                                 size_t generalBegin, 
+                                 IndexedCode& indexedCode) {
+    // The symbols may come from another file with the same contents
+    for (size_t i = generalBegin; i < symbols.entries.size(); i++) {
+        indexSymbolName(symbols.getName(symbols.entries[i]), filePath, indexedCode);
+    }
+    indexedCode.symbolDetails.append(symbols, filePath);
+}
+
+std::vector<size_t> Scanner::orderForReading(const std::deque<PendingFile>& files) const {
+    std::vector<size_t> order;
+    std::vector<size_t> reads;
+    order.reserve(files.size());
+    for (size_t i = 0; i < files.size(); i++) {
+        (matchesRecord(files[i].previous, files[i].stamp) ? order : reads).push_back(i);
+    }
+    if (readOrder_ == ReadOrder::Found) {
+        order.insert(order.end(), reads.begin(), reads.end());
+        return order;
+    }
+    
+    // File systems allocate inodes near their data, so inode order is close
+    // to disk order and costs nothing to get
+    std::stable_sort(reads.begin(), reads.end(), [&files](size_t a, size_t b) {
+        return files[a].stamp.inode < files[b].stamp.inode;
+    });
+    
+    // Extents are looked up in inode order, which keeps those lookups local
+    // too; files without a known extent go last
+    if (readOrder_ == ReadOrder::Extent) {
+        auto started = std::chrono::steady_clock::now();
+        std::vector<uint64_t> offsets(files.size(), UINT64_MAX);
+        size_t mapped = 0;
+        for (size_t index : reads) {
+            mapped += getPhysicalOffset(files[index].path, offsets[index]) ? 1 : 0;
+        }
+        std::stable_sort(reads.begin(), reads.end(), [&offsets](size_t a, size_t b) {
+            return offsets[a] < offsets[b];
+        });
+        auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - started);
+        utils::Logger::log(utils::LogLevel::INFO, "Scanner: Found the disk offsets of " + std::to_string(mapped) + " of " +
+                                                   std::to_string(reads.size()) + " files in " +
+                                                   std::to_string(elapsed.count()) + " ms");
+    }
+    order.insert(order.end(), reads.begin(), reads.end());
+    return order;
+}
+
+void Scanner::walkTrackedFiles(const GitIndex& gitIndex, 
+                               const std::string& rootPath, 
+                               const DirectoryWalker::DirectoryCallback& onDirectory, 
+                               const DirectoryWalker::FileCallback& onFile, 
+                               std::atomic<size_t>& filesSeen) {
+    std::unordered_set<std::string> directories;
+    std::string lastDirectory;
+    bool haveDirectory = false;
+    bool lastExcluded = false;
+    
+    for (const auto& relativePath : gitIndex.getFiles()) {
+        filesSeen++;
+        
+        // Files come sorted, so a directory is checked once for its whole run of files
+        size_t slash = relativePath.rfind('/');
+        std::string_view directory = slash == std::string::npos ? std::string_view() : std::string_view(relativePath).substr(0, slash);
+        if (!haveDirectory || directory != lastDirectory) {
+            lastDirectory = std::string(directory);
+            haveDirectory = true;
+            lastExcluded = false;
+            for (size_t start = 0; start < directory.size(); ) {
+                size_t end = std::min(directory.find('/', start), directory.size());
+                std::string name(directory.substr(start, end - start));
+                if (std::find(excludeDirectories_.begin(), excludeDirectories_.end(), name) != excludeDirectories_.end()) {
+                    lastExcluded = true;
+                    break;
+                }
+                std::string prefix(directory.substr(0, end));
+                if (directories.insert(prefix).second && onDirectory) {
+                    onDirectory((fs::path(rootPath) / prefix).make_preferred().string());
+                }
+                start = end + 1;
+            }
+        }
+        if (lastExcluded) {
+            continue;
+        }
+        
+        // The index only knows the files as of git's last look, so each is
+        // still stat'ed; deleted and sparse (skip-worktree) files fail here
+        std::string path = (fs::path(rootPath) / relativePath).make_preferred().string();
+        FileStamp stamp;
+        if (!statPath(path, stamp) || !stamp.isRegular) {
+            continue;
+        }
+        if (!onFile(path, stamp)) {
+            return;
+        }
+    }
+}
+
+bool Scanner::changesIgnoreRules(const std::vector<std::string>& paths) const {
+    if (!useIgnoreFiles_) {
+        return false;
+    }
+    return std::any_of(paths.begin(), paths.end(), [](const std::string& path) {
+        return IgnoreScope::isIgnoreFile(fs::path(path).filename().string());
+    });
+}
+
+bool Scanner::isIgnoredPath(const std::string& rootPath, 
+                            const std::string& path, 
+                            bool isDirectory, 
+                            std::unordered_map<std::string, std::shared_ptr<const IgnoreScope>>& scopes) const {
+    std::string relativePath = fs::path(path).lexically_relative(rootPath).generic_string();
+    if (relativePath.empty() || relativePath == "." || relativePath.compare(0, 2, "..") == 0) {
+        return false;
+    }
+    
+    // Descend from the root as the walk would: a directory's ignore files
+    // only count if the directory itself is not ignored
+    std::shared_ptr<const IgnoreScope> scope;
+    std::string base;
+    for (size_t next = 0; ; ) {
+        auto found = scopes.find(base);
+        if (found == scopes.end()) {
+            std::string directoryPath = base.empty() ? rootPath : (fs::path(rootPath) / base).string();
+            found = scopes.emplace(base, IgnoreScope::enter(scope, directoryPath, base)).first;
+        }
+        scope = found->second;
+        
+        size_t slash = relativePath.find('/', next);
+        if (slash == std::string::npos) {
+            break;
+        }
+        base = relativePath.substr(0, slash);
+        next = slash + 1;
+        if (IgnoreScope::isIgnored(scope.get(), base, true)) {
+            return true;
+        }
+    }
+    return IgnoreScope::isIgnored(scope.get(), relativePath, isDirectory);
+}
+
+void Scanner::indexSymbolName(std::string_view name, const std::string& filePath, IndexedCode& indexedCode) {
+    // Duplicates are dropped when the posting lists are built
+    indexedCode.symbols.add(name, filePath);
+}
+
+std::string Scanner::getManifestFingerprint() const {
+    std::stringstream ss;
+    ss << "regex=" << useRegexParsers_
+       << ";sniff=" << sniffContent_
+       << ";max_file_size=" << maxFileSize_
+       << ";max_line_count=" << maxLineCount_
+       << ";patterns=" << symbolPatterns_
+       << ";extensions=";
+    for (const auto& ext : supportedExtensions_) {
+        ss << ext << ",";
+    }
+    ss << ";exclude=";
+    for (const auto& dir : excludeDirectories_) {
+        ss << dir << ",";
+    }
+    return ss.str();
+}
+
+std::string Scanner::getManifestPath(const std::string& directoryPath) const {
+    std::stringstream ss;
+    ss << "manifest_" << std::hex << std::setw(16) << std::setfill('0') << hashContent(directoryPath) << ".bin";
+    return (fs::path(cacheDirectory_) / ss.str()).string();
+}
+
+std::string Scanner::getIndexPath(const std::string& directoryPath) const {
+    std::stringstream ss;
+    ss << "index_" << std::hex << std::setw(16) << std::setfill('0') << hashContent(directoryPath) << ".bin";
+    return (fs::path(cacheDirectory_) / ss.str()).string();
+}
+
+std::shared_ptr<const IndexFile> Scanner::openIndexFile(const std::string& directoryPath) const {
+    if (!persistentIndex_) {
+        return nullptr;
+    }
+    
+    auto indexFile = std::make_shared<IndexFile>();
+    if (!indexFile->open(getIndexPath(directoryPath), directoryPath, getManifestFingerprint(), verifyIndexContents_)) {
+        return nullptr;
+    }
+    return indexFile;
+}
+
+std::unique_ptr<ScanManifest> Scanner::takeManifest(const std::string& directoryPath) {
+    std::string fingerprint = getManifestFingerprint();
+    std::lock_guard<std::mutex> manifestLock(manifestMutex_);
+    if (manifest_ && manifest_->getRootPath() == directoryPath && manifest_->getFingerprint() == fingerprint) {
+        return std::move(manifest_);
+    }
+    
+    // Any failure to load means a fresh manifest and a full scan
+    auto manifest = std::make_unique<ScanManifest>(directoryPath, fingerprint);
+    try {
+        if (!manifest->load(getManifestPath(directoryPath))) {
+            return nullptr;
+        }
+    } catch (const std::exception& e) {
+        utils::Logger::log(utils::LogLevel::WARNING, "Scanner: Ignoring unreadable manifest: " + std::string(e.what()));
+        return nullptr;
+    }
+    return manifest;
+}
+
+void Scanner::mergeShards(std::deque<PendingFile>& files, 
+                          std::vector<IndexedCode>& shards, 
+                          IndexedCode& indexedCode) {
+    // Merge the shards in walk order so the result matches a serial scan
+    for (size_t i = 0; i < files.size(); i++) {
+        const PendingFile& file = files[i];
+        if (!file.ingested) {
+            continue;
+        }
+        
+        IndexedCode& shard = shards[file.shard];
+        indexedCode.symbols.addFile(file.path);
+        
+        auto content = shard.files.find(file.path);
+        indexedCode.files[file.path] = std::move(content->second);
+        
+        indexedCode.symbolDetails.append(shard.symbolDetails, file.symbolBegin, file.symbolEnd);
+        
+        std::string ext(getExtension(file.path));
+        if (!ext.empty() && 
+            std::find(indexedCode.fileExtensions.begin(), indexedCode.fileExtensions.end(), ext) == indexedCode.fileExtensions.end()) {
+            indexedCode.fileExtensions.push_back(ext);
+        }
+        
+        indexedCode.totalSize += file.stamp.size;
+        indexedCode.fileCount++;
+    }
+    
+    // Files already have their ids in walk order, so the lists come out sorted the same way
+    for (auto& shard : shards) {
+        indexedCode.symbols.append(shard.symbols);
+    }
+}
+
+void Scanner::resetParserTimings() {
+    for (auto& timing : parserTimings_) {
+        timing.files = 0;
+        timing.bytes = 0;
+        timing.nanoseconds = 0;
+    }
+    analysisTiming_.files = 0;
+    analysisTiming_.bytes = 0;
+    analysisTiming_.nanoseconds = 0;
+}
+
+void Scanner::logParserTimings() const {
+    static const char* names[] = {"C/C++", "Python", "JavaScript"};
+    const char* mode = useRegexParsers_ ? "regex" : "lexer";
+    
+    for (size_t i = 0; i < static_cast<size_t>(ParserLanguage::Count); i++) {
+        const ParserTiming& timing = parserTimings_[i];
+        if (timing.files == 0) {
+            continue;
+        }
+        
+        double megabytes = static_cast<double>(timing.bytes) / (1024.0 * 1024.0);
+        double seconds = static_cast<double>(timing.nanoseconds) / 1e9;
+        std::stringstream ss;
+        ss << std::fixed << std::setprecision(2)
+           << "Scanner: " << names[i] << " " << mode << " parsed " << timing.files << " files, "
+           << megabytes << " MB in " << (seconds * 1000.0) << " ms";
+        if (seconds > 0) {
+            ss << " (" << (megabytes / seconds) << " MB/s)";
+        }
+        utils::Logger::log(utils::LogLevel::INFO, ss.str());
+    }
+    
+    if (analysisTiming_.files > 0) {
+        double megabytes = static_cast<double>(analysisTiming_.bytes) / (1024.0 * 1024.0);
+        double seconds = static_cast<double>(analysisTiming_.nanoseconds) / 1e9;
+        std::stringstream ss;
+        ss << std::fixed << std::setprecision(2)
+           << "Scanner: Analysis pass with " << analyzer_.getMatcherCount() << " matchers went over " 
+           << analysisTiming_.files << " files, " << megabytes << " MB in " << (seconds * 1000.0) << " ms";
+        if (seconds > 0) {
+            ss << " (" << (megabytes / seconds) << " MB/s)";
+        }
+        utils::Logger::log(utils::LogLevel::INFO, ss.str());
+    }
+}
+
+void Scanner::tallyContent(ContentClass contentClass, uint64_t bytes) {
+    ContentTally& tally = contentTallies_[static_cast<size_t>(contentClass)];
+    tally.files++;
+    tally.bytes += bytes;
+}
+
+void Scanner::resetContentTallies() {
+    for (auto& tally : contentTallies_) {
+        tally.files = 0;
+        tally.bytes = 0;
+    }
+}
+
+void Scanner::logContentTallies() const {
+    if (!sniffContent_) {
+        return;
+    }
+    
+    static const char* actions[] = {"parsed", "indexed without symbols", "skipped", "skipped"};
+    std::stringstream ss;
+    ss << "Scanner: Content sniffing:";
+    for (size_t i = 0; i < static_cast<size_t>(ContentClass::Count); i++) {
+        const ContentTally& tally = contentTallies_[i];
+        ss << (i == 0 ? " " : ", ") << tally.files << " " << ContentSniffer::getName(static_cast<ContentClass>(i))
+           << " (" << tally.bytes << " bytes, " << actions[i] << ")";
+    }
+    utils::Logger::log(utils::LogLevel::INFO, ss.str());
+}
+
+void Scanner::reportProgress(const std::string& stage, float progress, const std::string& message) {
+    if (progressCallback_) {
+        std::lock_guard<std::mutex> lock(progressMutex_);
+        progressCallback_(stage, progress, message);
+    }
+}
+
 bool Scanner::isRelevantFile(const std::string& filePath) const {
     // Get file extension
-    std::string ext = fs::path(filePath).extension().string();
+    std::string ext(getExtension(filePath));
     
     // Convert to lowercase for case-insensitive comparison
     std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
@@ -237,96 +1577,127 @@ std::vector<std::string> Scanner::getSupportedExtensions() const {
     return supportedExtensions_;
 }
 
-void Scanner::parseFile(const std::string& filePath, 
-                      const std::string& content, 
-                      IndexedCode& indexedCode) {
+std::vector<std::string> Scanner::getExcludedDirectories() const {
+    return excludeDirectories_;
+}
+
+size_t Scanner::parseFile(const std::string& filePath, 
+                          std::string_view content, 
+                          const LineIndex& lines, 
+                          const FileAnalysis& analysis, 
+                          IndexedCode& indexedCode) {
     // Determine file type from extension
-    std::string ext = fs::path(filePath).extension().string();
+    std::string ext(getExtension(filePath));
     std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
     
     // Extract symbols based on file type
+    auto parseStart = std::chrono::steady_clock::now();
+    ParserLanguage language = ParserLanguage::Count;
     if (ext == ".cpp" || ext == ".h" || ext == ".hpp" || ext == ".c") {
-        parseCppFile(filePath, content, indexedCode);
+        language = ParserLanguage::Cpp;
+        if (useRegexParsers_) {
+            parseCppFileRegex(filePath, content, lines, indexedCode);
+        } else {
+            parseCppFile(filePath, content, lines, indexedCode);
+        }
     } else if (ext == ".py") {
-        parsePythonFile(filePath, content, indexedCode);
+        language = ParserLanguage::Python;
+        if (useRegexParsers_) {
+            parsePythonFileRegex(filePath, content, lines, indexedCode);
+        } else {
+            parsePythonFile(filePath, content, lines, indexedCode);
+        }
     } else if (ext == ".js" || ext == ".ts") {
-        parseJavaScriptFile(filePath, content, indexedCode);
+        language = ParserLanguage::JavaScript;
+        if (useRegexParsers_) {
+            parseJavaScriptFileRegex(filePath, content, lines, indexedCode);
+        } else {
+            parseJavaScriptFile(filePath, content, lines, indexedCode);
+        }
     }
     // Add more file type parsers as needed
     
-    // Extract general symbols
-    auto symbols = extractSymbols(filePath, content, ext);
+    if (language != ParserLanguage::Count) {
+        auto elapsed = std::chrono::steady_clock::now() - parseStart;
+        ParserTiming& timing = parserTimings_[static_cast<size_t>(language)];
+        timing.files++;
+        timing.bytes += content.size();
+        timing.nanoseconds += std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+    }
     
-    // Add symbols to indexed code
-    for (const auto& symbol : symbols) {
-        // Add symbol to the file -> symbols mapping
-        if (indexedCode.symbols.find(symbol.name) == indexedCode.symbols.end()) {
-            indexedCode.symbols[symbol.name] = std::vector<std::string>();
-        }
-        
-        // Add file to the symbol's file list if not already present
-        auto& symbolFiles = indexedCode.symbols[symbol.name];
-        if (std::find(symbolFiles.begin(), symbolFiles.end(), filePath) == symbolFiles.end()) {
-            symbolFiles.push_back(filePath);
-        }
-        
-        // Add detailed symbol info
-        indexedCode.symbolDetails.push_back(symbol);
+    // Add general symbols
+    size_t generalBegin = indexedCode.symbolDetails.size();
+    extractSymbols(filePath, analysis, indexedCode);
+    
+    // Add them to the file -> symbols mapping
+    for (size_t i = generalBegin; i < indexedCode.symbolDetails.size(); i++) {
+        indexSymbolName(indexedCode.symbolDetails.getName(i), filePath, indexedCode);
     }
+    return generalBegin;
+}
+
+void Scanner::analyze(std::string_view content, bool findSymbols, FileAnalysis& analysis) {
+    auto analysisStart = std::chrono::steady_clock::now();
+    analyzer_.analyze(content, findSymbols, analysis);
+    auto elapsed = std::chrono::steady_clock::now() - analysisStart;
+    analysisTiming_.files++;
+    analysisTiming_.bytes += content.size();
+    analysisTiming_.nanoseconds += std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
 }
 
 void Scanner::parseCppFile(const std::string& filePath, 
-                         const std::string& content, 
+                         std::string_view content, 
+                         const LineIndex& lines, 
                          IndexedCode& indexedCode) {
+    // Single linear scan that understands comments, literals and preprocessor lines
+    CppLexer lexer(content);
+    for (auto& lexed : lexer.extractSymbols()) {
+        indexedCode.symbolDetails.add(lexed.name, symbolKindFromName(lexed.type), filePath, 
+                                      lines.lineOf(lexed.offset), lexed.offset, lexed.length);
+    }
+}
+
+void Scanner::parseCppFileRegex(const std::string& filePath, 
+                              std::string_view content, 
+                              const LineIndex& lines, 
+                              IndexedCode& indexedCode) {
     // This is a simplified implementation
     // A more robust implementation would use a proper C++ parser
     
     // Extract includes
     std::regex includeRegex(R"(#include\s*[<"]([^>"]+)[>"])");
-    auto includeBegin = std::sregex_iterator(content.begin(), content.end(), includeRegex);
-    auto includeEnd = std::sregex_iterator();
+    auto includeBegin = std::cregex_iterator(content.data(), content.data() + content.size(), includeRegex);
+    auto includeEnd = std::cregex_iterator();
     
-    for (std::sregex_iterator i = includeBegin; i != includeEnd; ++i) {
-        std::smatch match = *i;
+    for (std::cregex_iterator i = includeBegin; i != includeEnd; ++i) {
+        std::cmatch match = *i;
         std::string includePath = match[1].str();
         
         // Handle include as a special symbol type
-        SymbolInfo symbol;
-        symbol.name = includePath;
-        symbol.type = "include";
-        symbol.filePath = filePath;
-        symbol.lineNumber = 0;  // We'd need to calculate line number properly
-        symbol.signature = match[0].str();
-        
-        indexedCode.symbolDetails.push_back(symbol);
+        indexedCode.symbolDetails.add(includePath, SymbolKind::Include, filePath, 
+                                      lines.lineOf(match.position(0)), match.position(0), match.length(0));
     }
     
     // Extract class definitions
     std::regex classRegex(R"(class\s+(\w+)(\s*:\s*\w+\s+\w+)?\s*\{)");
-    auto classBegin = std::sregex_iterator(content.begin(), content.end(), classRegex);
-    auto classEnd = std::sregex_iterator();
+    auto classBegin = std::cregex_iterator(content.data(), content.data() + content.size(), classRegex);
+    auto classEnd = std::cregex_iterator();
     
-    for (std::sregex_iterator i = classBegin; i != classEnd; ++i) {
-        std::smatch match = *i;
+    for (std::cregex_iterator i = classBegin; i != classEnd; ++i) {
+        std::cmatch match = *i;
         std::string className = match[1].str();
         
-        SymbolInfo symbol;
-        symbol.name = className;
-        symbol.type = "class";
-        symbol.filePath = filePath;
-        symbol.lineNumber = 0;  // We'd need to calculate line number properly
-        symbol.signature = match[0].str();
-        
-        indexedCode.symbolDetails.push_back(symbol);
+        indexedCode.symbolDetails.add(className, SymbolKind::Class, filePath, 
+                                      lines.lineOf(match.position(0)), match.position(0), match.length(0));
     }
     
     // Extract function definitions
     std::regex functionRegex(R"((\w+)\s+(\w+)\s*\([^)]*\)\s*(\{|;))");
-    auto functionBegin = std::sregex_iterator(content.begin(), content.end(), functionRegex);
-    auto functionEnd = std::sregex_iterator();
+    auto functionBegin = std::cregex_iterator(content.data(), content.data() + content.size(), functionRegex);
+    auto functionEnd = std::cregex_iterator();
     
-    for (std::sregex_iterator i = functionBegin; i != functionEnd; ++i) {
-        std::smatch match = *i;
+    for (std::cregex_iterator i = functionBegin; i != functionEnd; ++i) {
+        std::cmatch match = *i;
         std::string returnType = match[1].str();
         std::string functionName = match[2].str();
         
@@ -335,138 +1706,128 @@ void Scanner::parseCppFile(const std::string& filePath,
             continue;
         }
         
-        SymbolInfo symbol;
-        symbol.name = functionName;
-        symbol.type = "function";
-        symbol.filePath = filePath;
-        symbol.lineNumber = 0;  // We'd need to calculate line number properly
-        symbol.signature = match[0].str();
-        
-        indexedCode.symbolDetails.push_back(symbol);
+        indexedCode.symbolDetails.add(functionName, SymbolKind::Function, filePath, 
+                                      lines.lineOf(match.position(0)), match.position(0), match.length(0));
     }
 }
 
 void Scanner::parsePythonFile(const std::string& filePath, 
-                            const std::string& content, 
+                            std::string_view content, 
+                            const LineIndex& lines, 
                             IndexedCode& indexedCode) {
+    // Single pass over logical lines, tracking class/def scopes by indentation
+    PythonLexer lexer(content);
+    for (auto& lexed : lexer.extractSymbols()) {
+        indexedCode.symbolDetails.add(lexed.name, symbolKindFromName(lexed.type), filePath, 
+                                      lines.lineOf(lexed.offset), lexed.offset, lexed.length);
+    }
+}
+
+void Scanner::parsePythonFileRegex(const std::string& filePath, 
+                                 std::string_view content, 
+                                 const LineIndex& lines, 
+                                 IndexedCode& indexedCode) {
     // This is a simplified implementation
     // A more robust implementation would use a proper Python parser
     
     // Extract imports
     std::regex importRegex(R"(import\s+(\w+)|from\s+(\w+)\s+import)");
-    auto importBegin = std::sregex_iterator(content.begin(), content.end(), importRegex);
-    auto importEnd = std::sregex_iterator();
+    auto importBegin = std::cregex_iterator(content.data(), content.data() + content.size(), importRegex);
+    auto importEnd = std::cregex_iterator();
     
-    for (std::sregex_iterator i = importBegin; i != importEnd; ++i) {
-        std::smatch match = *i;
+    for (std::cregex_iterator i = importBegin; i != importEnd; ++i) {
+        std::cmatch match = *i;
         std::string importName = match[1].str();
         if (importName.empty()) {
             importName = match[2].str();
         }
         
-        SymbolInfo symbol;
-        symbol.name = importName;
-        symbol.type = "import";
-        symbol.filePath = filePath;
-        symbol.lineNumber = 0;  // We'd need to calculate line number properly
-        symbol.signature = match[0].str();
-        
-        indexedCode.symbolDetails.push_back(symbol);
+        indexedCode.symbolDetails.add(importName, SymbolKind::Import, filePath, 
+                                      lines.lineOf(match.position(0)), match.position(0), match.length(0));
     }
     
     // Extract class definitions
     std::regex classRegex(R"(class\s+(\w+)(\([^)]*\))?\s*:)");
-    auto classBegin = std::sregex_iterator(content.begin(), content.end(), classRegex);
-    auto classEnd = std::sregex_iterator();
+    auto classBegin = std::cregex_iterator(content.data(), content.data() + content.size(), classRegex);
+    auto classEnd = std::cregex_iterator();
     
-    for (std::sregex_iterator i = classBegin; i != classEnd; ++i) {
-        std::smatch match = *i;
+    for (std::cregex_iterator i = classBegin; i != classEnd; ++i) {
+        std::cmatch match = *i;
         std::string className = match[1].str();
         
-        SymbolInfo symbol;
-        symbol.name = className;
-        symbol.type = "class";
-        symbol.filePath = filePath;
-        symbol.lineNumber = 0;  // We'd need to calculate line number properly
-        symbol.signature = match[0].str();
-        
-        indexedCode.symbolDetails.push_back(symbol);
+        indexedCode.symbolDetails.add(className, SymbolKind::Class, filePath, 
+                                      lines.lineOf(match.position(0)), match.position(0), match.length(0));
     }
     
     // Extract function definitions
     std::regex functionRegex(R"(def\s+(\w+)\s*\([^)]*\)\s*:)");
-    auto functionBegin = std::sregex_iterator(content.begin(), content.end(), functionRegex);
-    auto functionEnd = std::sregex_iterator();
+    auto functionBegin = std::cregex_iterator(content.data(), content.data() + content.size(), functionRegex);
+    auto functionEnd = std::cregex_iterator();
     
-    for (std::sregex_iterator i = functionBegin; i != functionEnd; ++i) {
-        std::smatch match = *i;
+    for (std::cregex_iterator i = functionBegin; i != functionEnd; ++i) {
+        std::cmatch match = *i;
         std::string functionName = match[1].str();
         
-        SymbolInfo symbol;
-        symbol.name = functionName;
-        symbol.type = "function";
-        symbol.filePath = filePath;
-        symbol.lineNumber = 0;  // We'd need to calculate line number properly
-        symbol.signature = match[0].str();
-        
-        indexedCode.symbolDetails.push_back(symbol);
+        indexedCode.symbolDetails.add(functionName, SymbolKind::Function, filePath, 
+                                      lines.lineOf(match.position(0)), match.position(0), match.length(0));
     }
 }
 
 void Scanner::parseJavaScriptFile(const std::string& filePath, 
-                               const std::string& content, 
+                               std::string_view content, 
+                               const LineIndex& lines, 
                                IndexedCode& indexedCode) {
+    // Single pass that tracks template/regex literals, braces and class bodies
+    JsLexer lexer(content);
+    for (auto& lexed : lexer.extractSymbols()) {
+        indexedCode.symbolDetails.add(lexed.name, symbolKindFromName(lexed.type), filePath, 
+                                      lines.lineOf(lexed.offset), lexed.offset, lexed.length);
+    }
+}
+
+void Scanner::parseJavaScriptFileRegex(const std::string& filePath, 
+                                    std::string_view content, 
+                                    const LineIndex& lines, 
+                                    IndexedCode& indexedCode) {
     // This is a simplified implementation
     // A more robust implementation would use a proper JavaScript parser
     
     // Extract imports/requires
     std::regex importRegex(R"(import\s+.*?from\s+['"]([^'"]+)['"]|require\s*\(\s*['"]([^'"]+)['"]\s*\))");
-    auto importBegin = std::sregex_iterator(content.begin(), content.end(), importRegex);
-    auto importEnd = std::sregex_iterator();
+    auto importBegin = std::cregex_iterator(content.data(), content.data() + content.size(), importRegex);
+    auto importEnd = std::cregex_iterator();
     
-    for (std::sregex_iterator i = importBegin; i != importEnd; ++i) {
-        std::smatch match = *i;
+    for (std::cregex_iterator i = importBegin; i != importEnd; ++i) {
+        std::cmatch match = *i;
         std::string importPath = match[1].str();
         if (importPath.empty()) {
             importPath = match[2].str();
         }
         
-        SymbolInfo symbol;
-        symbol.name = importPath;
-        symbol.type = "import";
-        symbol.filePath = filePath;
-        symbol.lineNumber = 0;  // We'd need to calculate line number properly
-        symbol.signature = match[0].str();
-        
-        indexedCode.symbolDetails.push_back(symbol);
+        indexedCode.symbolDetails.add(importPath, SymbolKind::Import, filePath, 
+                                      lines.lineOf(match.position(0)), match.position(0), match.length(0));
     }
     
     // Extract class definitions
     std::regex classRegex(R"(class\s+(\w+)(\s+extends\s+\w+)?\s*\{)");
-    auto classBegin = std::sregex_iterator(content.begin(), content.end(), classRegex);
-    auto classEnd = std::sregex_iterator();
+    auto classBegin = std::cregex_iterator(content.data(), content.data() + content.size(), classRegex);
+    auto classEnd = std::cregex_iterator();
     
-    for (std::sregex_iterator i = classBegin; i != classEnd; ++i) {
-        std::smatch match = *i;
+    for (std::cregex_iterator i = classBegin; i != classEnd; ++i) {
+        std::cmatch match = *i;
         std::string className = match[1].str();
         
-        SymbolInfo symbol;
-        symbol.name = className;
-        symbol.type = "class";
-        symbol.filePath = filePath;
-        symbol.lineNumber = 0;  // We'd need to calculate line number properly
-        symbol.signature = match[0].str();
-        
-        indexedCode.symbolDetails.push_back(symbol);
+        indexedCode.symbolDetails.add(className, SymbolKind::Class, filePath, 
+                                      lines.lineOf(match.position(0)), match.position(0), match.length(0));
     }
     
     // Extract function definitions
     std::regex functionRegex(R"(function\s+(\w+)\s*\([^)]*\)|(\w+)\s*:\s*function\s*\([^)]*\)|(\w+)\s*=\s*function\s*\([^)]*\))");
-    auto functionBegin = std::sregex_iterator(content.begin(), content.end(), functionRegex);
-    auto functionEnd = std::sregex_iterator();
+    auto functionBegin = std::cregex_iterator(content.data(), content.data() + content.size(), functionRegex);
+    auto functionEnd = std::cregex_iterator();
     
-    for (std::sregex_iterator i = functionBegin; i != functionEnd; ++i) {
-        std::smatch match = *i;
+    for (std::cregex_iterator i = functionBegin; i != functionEnd; ++i) {
+        std::cmatch match = *i;
         std::string functionName;
         if (!match[1].str().empty()) {
             functionName = match[1].str();
@@ -477,24 +1838,18 @@ void Scanner::parseJavaScriptFile(const std::string& filePath,
         }
         
         if (!functionName.empty()) {
-            SymbolInfo symbol;
-            symbol.name = functionName;
-            symbol.type = "function";
-            symbol.filePath = filePath;
-            symbol.lineNumber = 0;  // We'd need to calculate line number properly
-            symbol.signature = match[0].str();
-            
-            indexedCode.symbolDetails.push_back(symbol);
+            indexedCode.symbolDetails.add(functionName, SymbolKind::Function, filePath, 
+                                          lines.lineOf(match.position(0)), match.position(0), match.length(0));
         }
     }
     
     // Extract arrow functions
     std::regex arrowRegex(R"(const\s+(\w+)\s*=\s*\([^)]*\)\s*=>|let\s+(\w+)\s*=\s*\([^)]*\)\s*=>|var\s+(\w+)\s*=\s*\([^)]*\)\s*=>)");
-    auto arrowBegin = std::sregex_iterator(content.begin(), content.end(), arrowRegex);
-    auto arrowEnd = std::sregex_iterator();
+    auto arrowBegin = std::cregex_iterator(content.data(), content.data() + content.size(), arrowRegex);
+    auto arrowEnd = std::cregex_iterator();
     
-    for (std::sregex_iterator i = arrowBegin; i != arrowEnd; ++i) {
-        std::smatch match = *i;
+    for (std::cregex_iterator i = arrowBegin; i != arrowEnd; ++i) {
+        std::cmatch match = *i;
         std::string functionName;
         if (!match[1].str().empty()) {
             functionName = match[1].str();
@@ -505,68 +1860,20 @@ void Scanner::parseJavaScriptFile(const std::string& filePath,
         }
         
         if (!functionName.empty()) {
-            SymbolInfo symbol;
-            symbol.name = functionName;
-            symbol.type = "function";
-            symbol.filePath = filePath;
-            symbol.lineNumber = 0;  // We'd need to calculate line number properly
-            symbol.signature = match[0].str();
-            
-            indexedCode.symbolDetails.push_back(symbol);
+            indexedCode.symbolDetails.add(functionName, SymbolKind::Function, filePath, 
+                                          lines.lineOf(match.position(0)), match.position(0), match.length(0));
         }
     }
 }
 
-std::vector<SymbolInfo> Scanner::extractSymbols(const std::string& filePath, 
-                                             const std::string& content, 
-                                             const std::string& fileType) {
-    // This is a simplified implementation that extracts some common symbols
-    // regardless of language-specific parsing
-    std::vector<SymbolInfo> symbols;
-    
-    // Extract TODOs
-    std::regex todoRegex(R"(TODO\s*:?\s*(.*))");
-    auto todoBegin = std::sregex_iterator(content.begin(), content.end(), todoRegex);
-    auto todoEnd = std::sregex_iterator();
-    
-    for (std::sregex_iterator i = todoBegin; i != todoEnd; ++i) {
-        std::smatch match = *i;
-        std::string todoText = match[1].str();
-        
-        SymbolInfo symbol;
-        symbol.name = "TODO";
-        symbol.type = "comment";
-        symbol.filePath = filePath;
-        symbol.lineNumber = 0;  // We'd need to calculate line number properly
-        symbol.signature = match[0].str();
-        symbol.documentation = todoText;
-        
-        symbols.push_back(symbol);
-    }
-    
-    // Extract constants/uppercase variables
-    std::regex constRegex(R"(const\s+([A-Z][A-Z0-9_]*)\s*=|#define\s+([A-Z][A-Z0-9_]*))");
-    auto constBegin = std::sregex_iterator(content.begin(), content.end(), constRegex);
-    auto constEnd = std::sregex_iterator();
-    
-    for (std::sregex_iterator i = constBegin; i != constEnd; ++i) {
-        std::smatch match = *i;
-        std::string constName = match[1].str();
-        if (constName.empty()) {
-            constName = match[2].str();
-        }
-        
-        SymbolInfo symbol;
-        symbol.name = constName;
-        symbol.type = "constant";
-        symbol.filePath = filePath;
-        symbol.lineNumber = 0;  // We'd need to calculate line number properly
-        symbol.signature = match[0].str();
-        
-        symbols.push_back(symbol);
+void Scanner::extractSymbols(const std::string& filePath, 
+                             const FileAnalysis& analysis, 
+                             IndexedCode& indexedCode) {
+    // Found by the matchers registered with analyzer_, grouped by matcher
+    for (const MatchedSymbol& symbol : analysis.symbols) {
+        indexedCode.symbolDetails.add(symbol.name, symbol.kind, filePath, symbol.line, 
+                                      symbol.offset, symbol.length, symbol.documentation);
     }
-    
-    return symbols;
 }
 
 }} // namespace codelve::scanner
\ No newline at end of file
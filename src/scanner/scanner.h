@@ -1,10 +1,23 @@
 // E:\codelve\src\scanner\scanner.h
 #pragma once
+#include "line_index.h"
+#include "symbol_table.h"
+#include "symbol_index.h"
+#include "content_sniffer.h"
+#include "directory_walker.h"
+#include "content_store.h"
+#include "file_analyzer.h"
 #include <string>
+#include <string_view>
 #include <vector>
 #include <unordered_map>
 #include <memory>
 #include <functional>
+#include <mutex>
+#include <shared_mutex>
+#include <deque>
+#include <atomic>
+#include <cstdint>
 
 namespace codelve {
 namespace utils {
@@ -12,30 +25,24 @@ namespace utils {
 }
 namespace scanner {
 
-/**
- * Stores information about a code symbol (function, class, variable, etc.)
- */
-struct SymbolInfo {
-    std::string name;
-    std::string type;
-    std::string filePath;
-    int lineNumber;
-    std::string signature;
-    std::string documentation;
-};
-
 /**
  * Stores indexed code information for a codebase
  */
 struct IndexedCode {
-    // Map of file paths to file contents
-    std::unordered_map<std::string, std::string> files;
+    // Directory the index was built from
+    std::string rootPath;
+    
+    // Map of file paths to file contents; duplicates share a blob
+    std::unordered_map<std::string, std::shared_ptr<const FileBlob>> files;
+    
+    // Where the bodies of the blobs above are loaded and cached
+    std::shared_ptr<ContentStore> contents;
     
-    // Map of symbol names to files containing them
-    std::unordered_map<std::string, std::vector<std::string>> symbols;
+    // Map of symbol names to files containing them, as sorted posting lists
+    SymbolIndex symbols;
     
-    // Detailed symbol information
-    std::vector<SymbolInfo> symbolDetails;
+    // Detailed symbol information; signatures are ranges of the file contents
+    SymbolTable symbolDetails;
     
     // Directory structure
     std::vector<std::string> directories;
@@ -50,6 +57,36 @@ struct IndexedCode {
     size_t fileCount;
 };
 
+/**
+ * Files a scan has indexed so far, published while the scan goes on so
+ * they can be queried before it completes
+ */
+struct ScanBatch {
+    // Directory being scanned
+    std::string rootPath;
+    
+    // Files indexed since the previous batch, with their blobs; a two-phase
+    // scan first lists all its files with null blobs (see ScanSession::parseNow)
+    std::vector<std::pair<std::string, std::shared_ptr<const FileBlob>>> files;
+    
+    // Symbol names of those files; not yet built
+    SymbolIndex symbols;
+    
+    // Where the bodies of the blobs above are loaded from
+    std::shared_ptr<ContentStore> contents;
+    
+    // Files the scan has processed so far, and about how many it will in all
+    size_t filesProcessed;
+    size_t filesEstimated;
+};
+
+class ScanManifest;
+class IndexFile;
+class IgnoreScope;
+class GitIndex;
+class FileReader;
+class ScanSession;
+
 /**
  * Progress callback for the scanning process
  * @param stage The current scanning stage description
@@ -60,6 +97,12 @@ using ScanProgressCallback = std::function<void(const std::string& stage,
                                               float progress, 
                                               const std::string& message)>;
 
+/**
+ * Receives the batches of a scan in progress; called from worker threads
+ * @param batch Files indexed since the previous batch
+ */
+using ScanBatchCallback = std::function<void(ScanBatch&& batch)>;
+
 /**
  * Scans and indexes codebase for analysis
  */
@@ -82,12 +125,57 @@ public:
      */
     void setProgressCallback(ScanProgressCallback callback);
     
+    /**
+     * Set a callback that receives the files of a scan in batches of
+     * scanner.publish_batch_files as they are indexed. Batches of one scan
+     * do not overlap and together hold every file of its index.
+     * @param callback The callback function, or null to stop publishing
+     */
+    void setBatchCallback(ScanBatchCallback callback);
+    
     /**
      * Scan a directory and build the indexed code structure.
+     * With scanner.incremental enabled, files whose size, mtime and inode
+     * match the manifest of the previous scan are not parsed again.
      * @param directoryPath Path to the directory to scan
+     * @param previous Index from an earlier scan, whose file contents are
+     *        reused for unchanged files instead of reading them (may be null)
+     * @param session Handle through which queries reach this scan while it
+     *        parses; with a batch callback set, a scan given one lists the
+     *        tree before parsing it (may be null)
      * @return The indexed code structure
      */
-    IndexedCode scanDirectory(const std::string& directoryPath);
+    IndexedCode scanDirectory(const std::string& directoryPath, 
+                              const IndexedCode* previous = nullptr, 
+                              ScanSession* session = nullptr);
+    
+    /**
+     * Bring an index up to date with changes to some paths, without a rescan.
+     * Changed and new files are reparsed, deleted ones dropped along with
+     * everything below a deleted directory. The manifest of the last scan is
+     * kept in step so the next scan does not parse these files again.
+     * @param indexedCode Index to update, from scanDirectory()
+     * @param paths Paths reported as changed
+     * @return Files whose entries in the index were replaced or removed
+     */
+    std::vector<std::string> updateFiles(IndexedCode& indexedCode, const std::vector<std::string>& paths);
+    
+    /**
+     * Open the index saved by the last scan of a directory, so it can be
+     * queried before the directory is scanned again.
+     * @param directoryPath Path to the scanned directory
+     * @return The mapped index, or null if there is none usable
+     */
+    std::shared_ptr<const IndexFile> openIndexFile(const std::string& directoryPath) const;
+    
+    /**
+     * Check whether any of some changed paths is an ignore file, whose
+     * edit can include or exclude files anywhere below it. updateFiles()
+     * does not follow such changes; the directory needs a rescan.
+     * @param paths Paths reported as changed
+     * @return true if ignore rules may have changed
+     */
+    bool changesIgnoreRules(const std::vector<std::string>& paths) const;
     
     /**
      * Check if a file is relevant for code analysis.
@@ -102,6 +190,12 @@ public:
      */
     std::vector<std::string> getSupportedExtensions() const;
     
+    /**
+     * Get the names of directories that are never scanned.
+     * @return List of directory names (e.g., "node_modules")
+     */
+    std::vector<std::string> getExcludedDirectories() const;
+    
 private:
     // Configuration
     std::shared_ptr<utils::Config> config_;
@@ -124,27 +218,257 @@ size_t maxLineCount_;
     // Directories to exclude from scanning
     std::vector<std::string> excludeDirectories_;
     
-    // Methods for handling different file types
-    void parseFile(const std::string& filePath, 
-                  const std::string& content, 
-                  IndexedCode& indexedCode);
+    // Number of worker threads used to read and parse files (1 = serial)
+    size_t threadCount_;
+    
+    // Serializes progress callbacks coming from worker threads
+    std::mutex progressMutex_;
+    
+    // Receives files in batches of batchFiles_ while a scan runs, if set
+    ScanBatchCallback batchCallback_;
+    size_t batchFiles_;
+    
+    // With a batch callback and a session, list the tree first and parse it after
+    bool twoPhase_;
+    
+    // Files of a two-phase scan, in the order they are to be parsed
+    // (defined in scanner.cpp); reached from outside through its ScanSession
+    struct ParseQueue;
+    friend class ScanSession;
+    
+    // A file found by the directory walk (defined in scanner.cpp)
+    struct PendingFile;
+    
+    // Reparse only changed files, tracked by a manifest saved in cacheDirectory_
+    bool incremental_;
+    std::string cacheDirectory_;
+    
+    // Manifest written by the most recent scan. The lock also covers the
+    // manifest and index files, so scans and live updates take turns.
+    std::unique_ptr<ScanManifest> manifest_;
+    std::mutex manifestMutex_;
+    
+    // Share one blob, and one parse, between files with identical contents
+    bool deduplicateFiles_;
+    
+    // Blobs of the index a scan builds by content hash (defined in scanner.cpp)
+    struct BlobTable;
+    
+    // Read changed files ahead of the parsers, this many at once (0 = off),
+    // through io_uring where the kernel has it
+    size_t readAheadFiles_;
+    bool useIoUring_;
+    
+    // Order of the reads when the whole list is known up front, as in a
+    // two-phase scan: as found, by inode, or by where the data is on disk
+    enum class ReadOrder {
+        Found,
+        Inode,
+        Extent
+    };
+    ReadOrder readOrder_;
+    
+    // Drop files the scan brought into the page cache once they are read
+    bool dropReadPages_;
+    
+    // File bodies of the indexes this scanner builds, cached under a byte budget
+    std::shared_ptr<ContentStore> contents_;
+    
+    // Save each scan as an index file that the next session can map
+    bool persistentIndex_;
+    
+    // Hash every section and file body when opening a saved index
+    bool verifyIndexContents_;
+    
+    // Use the original std::regex extractors instead of the hand-written lexers
+    bool useRegexParsers_;
+    
+    // Look at the first bytes of each file to skip binary and minified
+    // files and index generated ones without extracting symbols
+    bool sniffContent_;
+    
+    // Honor .gitignore and .ignore files in the scanned tree
+    bool useIgnoreFiles_;
+    
+    // In a git checkout, take the tracked files from .git/index instead of
+    // walking. Off by default: untracked files would be left out.
+    bool useGitIndex_;
+    
+    // Languages with a dedicated parser, for throughput reporting
+    enum class ParserLanguage {
+        Cpp,
+        Python,
+        JavaScript,
+        Count
+    };
+    
+    // Work done by one language parser during the current scan
+    struct ParserTiming {
+        std::atomic<uint64_t> files{0};
+        std::atomic<uint64_t> bytes{0};
+        std::atomic<uint64_t> nanoseconds{0};
+    };
+    
+    ParserTiming parserTimings_[static_cast<size_t>(ParserLanguage::Count)];
+    
+    // One pass per file that indexes its lines and runs the language-independent extractors
+    FileAnalyzer analyzer_;
+    
+    // Extra extractors from the configuration, as comma-separated kind:pattern entries
+    std::string symbolPatterns_;
+    ParserTiming analysisTiming_;
+    
+    void resetParserTimings();
+    void logParserTimings() const;
+    
+    // Files of each content class met during the current scan
+    struct ContentTally {
+        std::atomic<uint64_t> files{0};
+        std::atomic<uint64_t> bytes{0};
+    };
+    
+    ContentTally contentTallies_[static_cast<size_t>(ContentClass::Count)];
+    
+    void tallyContent(ContentClass contentClass, uint64_t bytes);
+    void resetContentTallies();
+    void logContentTallies() const;
+    
+    // Read, parse and add a single file to the given index, reusing the
+    // previous scan's results when the file has not changed, and a copy's
+    // when blobs has the same contents; reader holds the scan's read ahead
+    bool ingestFile(PendingFile& file, const IndexedCode* previous, IndexedCode& indexedCode, 
+                    BlobTable* blobs, FileReader* reader);
+    
+    // Add a file's parse results from the manifest to the given index
+    void addRecordedSymbols(const std::string& filePath, 
+                            const FileSymbols& symbols, 
+                            size_t generalBegin, 
+                            IndexedCode& indexedCode);
+    
+    // Order files for parsing: those with nothing to read first, as found,
+    // then the others in readOrder_
+    std::vector<size_t> orderForReading(const std::deque<PendingFile>& files) const;
+    
+    // Report the tracked files of a git index like a walk would, skipping
+    // excluded directories; filesSeen counts index entries for progress
+    void walkTrackedFiles(const GitIndex& gitIndex, 
+                          const std::string& rootPath, 
+                          const DirectoryWalker::DirectoryCallback& onDirectory, 
+                          const DirectoryWalker::FileCallback& onFile, 
+                          std::atomic<size_t>& filesSeen);
+    
+    // Check a path below the root against the ignore files of the root and
+    // of each directory above it; scopes caches them per relative directory
+    bool isIgnoredPath(const std::string& rootPath, 
+                       const std::string& path, 
+                       bool isDirectory, 
+                       std::unordered_map<std::string, std::shared_ptr<const IgnoreScope>>& scopes) const;
+    
+    // Map a symbol name to a file in IndexedCode::symbols; takes effect on build()
+    void indexSymbolName(std::string_view name, const std::string& filePath, IndexedCode& indexedCode);
+    
+    // Settings that change parse results; a manifest written with others is discarded
+    std::string getManifestFingerprint() const;
+    
+    // Where the manifest and the index file for a scanned directory are stored
+    std::string getManifestPath(const std::string& directoryPath) const;
+    std::string getIndexPath(const std::string& directoryPath) const;
+    
+    // Get the previous manifest for a directory, from memory or disk
+    std::unique_ptr<ScanManifest> takeManifest(const std::string& directoryPath);
+    
+    // Merge per-thread shards into the final index, in walk order
+    void mergeShards(std::deque<PendingFile>& files, 
+                     std::vector<IndexedCode>& shards, 
+                     IndexedCode& indexedCode);
+    
+    // Report scan progress, safe to call from worker threads
+    void reportProgress(const std::string& stage, float progress, const std::string& message);
+    
+    // Index a file's lines and, if asked, find its language-independent symbols, in one pass
+    void analyze(std::string_view content, bool findSymbols, FileAnalysis& analysis);
+    
+    // Methods for handling different file types; parseFile returns the index in
+    // symbolDetails of the first language-independent symbol it added
+    size_t parseFile(const std::string& filePath, 
+                     std::string_view content, 
+                     const LineIndex& lines, 
+                     const FileAnalysis& analysis, 
+                     IndexedCode& indexedCode);
     
     void parseCppFile(const std::string& filePath, 
-                     const std::string& content, 
+                     std::string_view content, 
+                     const LineIndex& lines, 
                      IndexedCode& indexedCode);
     
+    void parseCppFileRegex(const std::string& filePath, 
+                          std::string_view content, 
+                          const LineIndex& lines, 
+                          IndexedCode& indexedCode);
+    
     void parsePythonFile(const std::string& filePath, 
-                        const std::string& content, 
+                        std::string_view content, 
+                        const LineIndex& lines, 
                         IndexedCode& indexedCode);
     
+    void parsePythonFileRegex(const std::string& filePath, 
+                             std::string_view content, 
+                             const LineIndex& lines, 
+                             IndexedCode& indexedCode);
+    
     void parseJavaScriptFile(const std::string& filePath, 
-                           const std::string& content, 
+                           std::string_view content, 
+                           const LineIndex& lines, 
                            IndexedCode& indexedCode);
     
-    // Extract symbols from file content
-    std::vector<SymbolInfo> extractSymbols(const std::string& filePath, 
-                                         const std::string& content, 
-                                         const std::string& fileType);
+    void parseJavaScriptFileRegex(const std::string& filePath, 
+                                 std::string_view content, 
+                                 const LineIndex& lines, 
+                                 IndexedCode& indexedCode);
+    
+    // Add the language-independent symbols the analysis pass found
+    void extractSymbols(const std::string& filePath, 
+                        const FileAnalysis& analysis, 
+                        IndexedCode& indexedCode);
+};
+
+/**
+ * The link between one two-phase scan and the queries made while it runs.
+ * Create one per scan and pass it to Scanner::scanDirectory; until that
+ * scan starts parsing and after it finishes, requests through it do nothing,
+ * and they never reach any other scan of the same scanner.
+ */
+class ScanSession {
+public:
+    ScanSession();
+    
+    ScanSession(const ScanSession&) = delete;
+    ScanSession& operator=(const ScanSession&) = delete;
+    
+    /**
+     * Ask the scan to parse some files, or the files below some
+     * directories, before the rest. Safe to call from any thread.
+     * @param paths Files or directories, the most wanted first
+     */
+    void prioritize(const std::vector<std::string>& paths);
+    
+    /**
+     * Parse a file of the scan now, unless it already has been; waits for
+     * a worker that is parsing it. The file is still published with its
+     * batch. Safe to call from any thread.
+     * @param filePath Path of a file the scan listed
+     * @return The file's blob, or null if the file was rejected or the
+     *         scan is not parsing
+     */
+    std::shared_ptr<const FileBlob> parseNow(const std::string& filePath);
+    
+private:
+    friend class Scanner;
+    
+    // Files of the scan while it parses; the lock is held exclusively only
+    // to set or clear the pointer
+    Scanner::ParseQueue* queue_;
+    std::shared_mutex queueMutex_;
 };
 
 }} // namespace codelve::scanner
\ No newline at end of file
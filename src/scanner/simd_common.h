@@ -0,0 +1,48 @@
+// File: codelve/src/scanner/simd_common.h
+#pragma once
+#include <cstdint>
+
+// Vector instructions the byte-scanning loops may use, chosen at compile
+// time: CODELVE_SIMD_AVX2 steps 32 bytes at a time, CODELVE_SIMD_SSE2 16,
+// with CODELVE_SIMD_SSSE3 adding byte shuffles to it. With neither, the
+// loops fall back to scalar code.
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define CODELVE_SIMD_AVX2 1
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define CODELVE_SIMD_SSE2 1
+#if defined(__SSSE3__)
+#include <tmmintrin.h>
+#define CODELVE_SIMD_SSSE3 1
+#endif
+#endif
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
+
+namespace codelve {
+namespace scanner {
+
+// Position of the lowest set bit of a non-zero movemask result
+inline unsigned lowestBit(uint32_t mask) {
+#if defined(_MSC_VER) && !defined(__clang__)
+    unsigned long index;
+    _BitScanForward(&index, mask);
+    return static_cast<unsigned>(index);
+#else
+    return static_cast<unsigned>(__builtin_ctz(mask));
+#endif
+}
+
+// Number of bits set in a movemask result
+inline unsigned popCount(uint32_t mask) {
+#if defined(_MSC_VER) && !defined(__clang__)
+    return static_cast<unsigned>(__popcnt(mask));
+#else
+    return static_cast<unsigned>(__builtin_popcount(mask));
+#endif
+}
+
+}} // namespace codelve::scanner
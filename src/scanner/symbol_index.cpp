@@ -0,0 +1,248 @@
+// File: codelve/src/scanner/symbol_index.cpp
+#include "symbol_index.h"
+#include <algorithm>
+
+namespace codelve {
+namespace scanner {
+
+namespace {
+    size_t varintSize(uint32_t value) {
+        size_t size = 1;
+        while (value >= 0x80) {
+            value >>= 7;
+            size++;
+        }
+        return size;
+    }
+
+    void putVarint(std::vector<uint8_t>& data, uint32_t value) {
+        while (value >= 0x80) {
+            data.push_back(static_cast<uint8_t>(value | 0x80));
+            value >>= 7;
+        }
+        data.push_back(static_cast<uint8_t>(value));
+    }
+
+    uint32_t getVarint(const uint8_t*& data) {
+        uint32_t value = 0;
+        int shift = 0;
+        while (*data & 0x80) {
+            value |= static_cast<uint32_t>(*data++ & 0x7f) << shift;
+            shift += 7;
+        }
+        value |= static_cast<uint32_t>(*data++) << shift;
+        return value;
+    }
+
+    template <typename T>
+    size_t vectorBytes(const std::vector<T>& values) {
+        return values.capacity() * sizeof(T);
+    }
+}
+
+const uint32_t SymbolIndex::kNoList;
+
+SymbolIndex::SymbolIndex() {
+}
+
+void SymbolIndex::add(std::string_view name, std::string_view filePath) {
+    std::pair<uint32_t, uint32_t> pair(names_.intern(name), files_.intern(filePath));
+
+    // A file repeats the same name often (every TODO), so drop the easy duplicates now
+    if (pending_.empty() || pending_.back() != pair) {
+        pending_.push_back(pair);
+    }
+}
+
+uint32_t SymbolIndex::addFile(std::string_view filePath) {
+    return files_.intern(filePath);
+}
+
+void SymbolIndex::append(const SymbolIndex& other) {
+    // Take the other index's files in its id order first, so they keep it here
+    std::vector<uint32_t> fileIds(other.files_.size(), 0);
+    for (uint32_t i = 1; i < other.files_.size(); i++) {
+        fileIds[i] = files_.intern(other.files_.get(i));
+    }
+    std::vector<uint32_t> nameIds(other.names_.size(), 0);
+    for (uint32_t i = 1; i < other.names_.size(); i++) {
+        nameIds[i] = names_.intern(other.names_.get(i));
+    }
+
+    std::vector<uint32_t> files;
+    for (const auto& list : other.lists_) {
+        other.decode(list, files);
+        for (uint32_t file : files) {
+            pending_.emplace_back(nameIds[list.name], fileIds[file]);
+        }
+    }
+    for (const auto& pair : other.pending_) {
+        pending_.emplace_back(nameIds[pair.first], fileIds[pair.second]);
+    }
+}
+
+void SymbolIndex::removeFiles(const std::function<bool(std::string_view)>& matches) {
+    std::vector<char> dropped(files_.size(), 0);
+    for (uint32_t i = 1; i < files_.size(); i++) {
+        dropped[i] = matches(files_.get(i)) ? 1 : 0;
+    }
+
+    std::vector<std::pair<uint32_t, uint32_t>> pairs;
+    std::vector<uint32_t> files;
+    for (const auto& list : lists_) {
+        decode(list, files);
+        for (uint32_t file : files) {
+            if (!dropped[file]) {
+                pairs.emplace_back(list.name, file);
+            }
+        }
+    }
+    for (const auto& pair : pending_) {
+        if (!dropped[pair.second]) {
+            pairs.push_back(pair);
+        }
+    }
+    pending_.clear();
+    rebuild(pairs);
+}
+
+void SymbolIndex::build() {
+    if (pending_.empty()) {
+        return;
+    }
+
+    std::vector<std::pair<uint32_t, uint32_t>> pairs;
+    if (lists_.empty()) {
+        pairs.swap(pending_);
+    } else {
+        std::vector<uint32_t> files;
+        for (const auto& list : lists_) {
+            decode(list, files);
+            for (uint32_t file : files) {
+                pairs.emplace_back(list.name, file);
+            }
+        }
+        pairs.insert(pairs.end(), pending_.begin(), pending_.end());
+        pending_.clear();
+    }
+    pending_.shrink_to_fit();
+    rebuild(pairs);
+}
+
+void SymbolIndex::rebuild(std::vector<std::pair<uint32_t, uint32_t>>& pairs) {
+    std::sort(pairs.begin(), pairs.end());
+    pairs.erase(std::unique(pairs.begin(), pairs.end()), pairs.end());
+
+    lists_.clear();
+    data_.clear();
+    listOfName_.assign(names_.size(), kNoList);
+
+    std::vector<uint32_t> files;
+    for (size_t begin = 0; begin < pairs.size(); ) {
+        uint32_t name = pairs[begin].first;
+        files.clear();
+        size_t end = begin;
+        for (; end < pairs.size() && pairs[end].first == name; end++) {
+            files.push_back(pairs[end].second);
+        }
+        listOfName_[name] = static_cast<uint32_t>(lists_.size());
+        encode(name, files.data(), files.size());
+        begin = end;
+    }
+
+    lists_.shrink_to_fit();
+    data_.shrink_to_fit();
+}
+
+void SymbolIndex::encode(uint32_t name, const uint32_t* files, size_t count) {
+    PostingList list;
+    list.name = name;
+    list.first = files[0];
+    list.count = static_cast<uint32_t>(count);
+    list.offset = static_cast<uint32_t>(data_.size());
+
+    size_t deltaBytes = 0;
+    for (size_t i = 1; i < count; i++) {
+        deltaBytes += varintSize(files[i] - files[i - 1]);
+    }
+    size_t bitmapBytes = (files[count - 1] - files[0]) / 8 + 1;
+
+    if (count > 1 && bitmapBytes < deltaBytes) {
+        list.encoding = Encoding::Bitmap;
+        data_.resize(data_.size() + bitmapBytes, 0);
+        uint8_t* bits = data_.data() + list.offset;
+        for (size_t i = 0; i < count; i++) {
+            uint32_t bit = files[i] - files[0];
+            bits[bit / 8] |= static_cast<uint8_t>(1u << (bit % 8));
+        }
+    } else {
+        list.encoding = Encoding::Deltas;
+        for (size_t i = 1; i < count; i++) {
+            putVarint(data_, files[i] - files[i - 1]);
+        }
+    }
+    list.length = static_cast<uint32_t>(data_.size() - list.offset);
+    lists_.push_back(list);
+}
+
+void SymbolIndex::decode(const PostingList& list, std::vector<uint32_t>& files) const {
+    files.clear();
+    files.reserve(list.count);
+    files.push_back(list.first);
+
+    const uint8_t* data = data_.data() + list.offset;
+    if (list.encoding == Encoding::Bitmap) {
+        for (uint32_t i = 1; i < list.length * 8 && files.size() < list.count; i++) {
+            if (data[i / 8] & (1u << (i % 8))) {
+                files.push_back(list.first + i);
+            }
+        }
+        return;
+    }
+
+    uint32_t file = list.first;
+    for (uint32_t i = 1; i < list.count; i++) {
+        file += getVarint(data);
+        files.push_back(file);
+    }
+}
+
+size_t SymbolIndex::getNameCount() const {
+    return lists_.size();
+}
+
+std::string_view SymbolIndex::getName(uint32_t name) const {
+    return names_.get(lists_[name].name);
+}
+
+bool SymbolIndex::findName(std::string_view name, uint32_t& nameId) const {
+    uint32_t id = 0;
+    if (!names_.find(name, id) || id >= listOfName_.size() || listOfName_[id] == kNoList) {
+        return false;
+    }
+    nameId = listOfName_[id];
+    return true;
+}
+
+size_t SymbolIndex::getFileCount(uint32_t nameId) const {
+    return lists_[nameId].count;
+}
+
+uint32_t SymbolIndex::getFirstFile(uint32_t nameId) const {
+    return lists_[nameId].first;
+}
+
+void SymbolIndex::getFiles(uint32_t nameId, std::vector<uint32_t>& files) const {
+    decode(lists_[nameId], files);
+}
+
+std::string_view SymbolIndex::getFilePath(uint32_t file) const {
+    return files_.get(file);
+}
+
+size_t SymbolIndex::getByteSize() const {
+    return names_.getByteSize() + files_.getByteSize() +
+           vectorBytes(pending_) + vectorBytes(lists_) + vectorBytes(listOfName_) + vectorBytes(data_);
+}
+
+}} // namespace codelve::scanner
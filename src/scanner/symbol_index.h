@@ -0,0 +1,144 @@
+// File: codelve/src/scanner/symbol_index.h
+#pragma once
+#include "symbol_table.h"
+#include <string>
+#include <string_view>
+#include <vector>
+#include <utility>
+#include <functional>
+#include <cstddef>
+#include <cstdint>
+
+namespace codelve {
+namespace scanner {
+
+/**
+ * Maps symbol names to the files that contain them.
+ *
+ * Pairs are collected with add() and turned into posting lists in bulk by
+ * build(), with one sort instead of a search per pair. Each list holds
+ * file ids in ascending order; file ids follow the order files were first
+ * added, which for a scan is the walk order. A list is stored as varint
+ * deltas, or as a bitmap over its id range when that is smaller, as it is
+ * for names found in most files.
+ */
+class SymbolIndex {
+public:
+    SymbolIndex();
+
+    /**
+     * Record that a file contains a name. Not visible to lookups until build().
+     * @param name Symbol name
+     * @param filePath File containing it
+     */
+    void add(std::string_view name, std::string_view filePath);
+
+    /**
+     * Assign a file its id now, so files are ordered by when this was
+     * called rather than by when their first name was added.
+     * @param filePath Path of the file
+     * @return The file id
+     */
+    uint32_t addFile(std::string_view filePath);
+
+    /**
+     * Add every pair of another index, built or not. Files new to this
+     * index get ids in the other index's order.
+     * @param other The index to copy from
+     */
+    void append(const SymbolIndex& other);
+
+    /**
+     * Drop every file the predicate matches from all lists. Names left with
+     * no files disappear.
+     * @param matches Called once per file path
+     */
+    void removeFiles(const std::function<bool(std::string_view)>& matches);
+
+    /**
+     * Merge the pairs added since the last build into the posting lists.
+     */
+    void build();
+
+    /**
+     * Get the number of names with at least one file. Name ids run from 0
+     * in the order names were first added.
+     * @return Name count
+     */
+    size_t getNameCount() const;
+    std::string_view getName(uint32_t name) const;
+
+    /**
+     * Look up a symbol name.
+     * @param name The symbol name
+     * @param nameId Receives the name id
+     * @return true if found
+     */
+    bool findName(std::string_view name, uint32_t& nameId) const;
+
+    /**
+     * Get the number of files a name maps to.
+     * @param nameId The name id
+     * @return File count
+     */
+    size_t getFileCount(uint32_t nameId) const;
+
+    /**
+     * Get the lowest file id a name maps to, without decoding its list.
+     * @param nameId The name id
+     * @return File id
+     */
+    uint32_t getFirstFile(uint32_t nameId) const;
+
+    /**
+     * Decode a name's posting list.
+     * @param nameId The name id
+     * @param files Receives the file ids, ascending
+     */
+    void getFiles(uint32_t nameId, std::vector<uint32_t>& files) const;
+
+    std::string_view getFilePath(uint32_t file) const;
+
+    /**
+     * Get the memory held by the index.
+     * @return Bytes
+     */
+    size_t getByteSize() const;
+
+private:
+    enum class Encoding : uint8_t {
+        Deltas,     // LEB128 gaps between consecutive ids after the first
+        Bitmap      // One bit per id from the first to the last
+    };
+
+    struct PostingList {
+        uint32_t name;
+        uint32_t first;
+        uint32_t count;
+        uint32_t offset;
+        uint32_t length;
+        Encoding encoding;
+    };
+
+    // Marks names whose list was dropped
+    static const uint32_t kNoList = UINT32_MAX;
+
+    StringPool names_;
+    StringPool files_;
+
+    // Pairs of (name, file) pool ids waiting for build()
+    std::vector<std::pair<uint32_t, uint32_t>> pending_;
+
+    // Posting lists in name order, and the list of each name pool id
+    std::vector<PostingList> lists_;
+    std::vector<uint32_t> listOfName_;
+    std::vector<uint8_t> data_;
+
+    void decode(const PostingList& list, std::vector<uint32_t>& files) const;
+    void encode(uint32_t name, const uint32_t* files, size_t count);
+
+    // Re-encode all lists from sorted, unique pairs
+    void rebuild(std::vector<std::pair<uint32_t, uint32_t>>& pairs);
+};
+
+}} // namespace codelve::scanner
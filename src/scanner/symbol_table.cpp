@@ -0,0 +1,371 @@
+// File: codelve/src/scanner/symbol_table.cpp
+#include "symbol_table.h"
+#include <algorithm>
+#include <cstring>
+#include <iomanip>
+#include <sstream>
+
+namespace codelve {
+namespace scanner {
+
+namespace {
+    const char* const kKindNames[] = {
+        "include", "import", "namespace", "class", "struct", "interface", "enum", "type",
+        "function", "method", "export", "decorator", "comment", "constant", "other"
+    };
+
+    static_assert(sizeof(kKindNames) / sizeof(kKindNames[0]) == static_cast<size_t>(SymbolKind::Count),
+                  "every SymbolKind needs a name");
+
+    // What one symbol cost as the struct of five std::strings and an int
+    // this table replaced; strings past the small-string buffer add a heap block
+    struct LegacySymbol {
+        std::string name;
+        std::string type;
+        std::string filePath;
+        int lineNumber;
+        std::string signature;
+        std::string documentation;
+    };
+
+    size_t legacyStringBytes(size_t length) {
+        static const size_t inlineCapacity = std::string().capacity();
+        return length > inlineCapacity ? length + 1 : 0;
+    }
+
+    template <typename T>
+    size_t columnBytes(const std::vector<T>& column) {
+        return column.capacity() * sizeof(T);
+    }
+}
+
+SymbolKind symbolKindFromName(std::string_view name) {
+    for (size_t i = 0; i < static_cast<size_t>(SymbolKind::Other); i++) {
+        if (name == kKindNames[i]) {
+            return static_cast<SymbolKind>(i);
+        }
+    }
+    return SymbolKind::Other;
+}
+
+std::string_view symbolKindName(SymbolKind kind) {
+    size_t index = std::min(static_cast<size_t>(kind), static_cast<size_t>(SymbolKind::Other));
+    return kKindNames[index];
+}
+
+const size_t StringPool::kChunkSize;
+
+StringPool::StringPool() {
+    clear();
+}
+
+StringPool::StringPool(const StringPool& other) {
+    // Interning in the same order gives every string the same id
+    clear();
+    for (size_t i = 1; i < other.strings_.size(); i++) {
+        intern(other.strings_[i]);
+    }
+}
+
+StringPool& StringPool::operator=(const StringPool& other) {
+    if (this != &other) {
+        StringPool copy(other);
+        *this = std::move(copy);
+    }
+    return *this;
+}
+
+StringPool::StringPool(StringPool&& other)
+    : chunks_(std::move(other.chunks_)),
+      chunkUsed_(other.chunkUsed_),
+      chunkCapacity_(other.chunkCapacity_),
+      chunkBytes_(other.chunkBytes_),
+      strings_(std::move(other.strings_)),
+      ids_(std::move(other.ids_)) {
+    other.clear();
+}
+
+StringPool& StringPool::operator=(StringPool&& other) {
+    if (this != &other) {
+        // The chunks move with their strings, so views stay valid
+        chunks_ = std::move(other.chunks_);
+        chunkUsed_ = other.chunkUsed_;
+        chunkCapacity_ = other.chunkCapacity_;
+        chunkBytes_ = other.chunkBytes_;
+        strings_ = std::move(other.strings_);
+        ids_ = std::move(other.ids_);
+        other.clear();
+    }
+    return *this;
+}
+
+void StringPool::clear() {
+    chunks_.clear();
+    chunkUsed_ = 0;
+    chunkCapacity_ = 0;
+    chunkBytes_ = 0;
+    strings_.clear();
+    ids_.clear();
+    strings_.push_back(std::string_view());
+    ids_.emplace(std::string_view(), 0);
+}
+
+uint32_t StringPool::intern(std::string_view text) {
+    auto found = ids_.find(text);
+    if (found != ids_.end()) {
+        return found->second;
+    }
+
+    if (chunkUsed_ + text.size() > chunkCapacity_) {
+        size_t capacity = std::max(kChunkSize, text.size());
+        chunks_.push_back(std::unique_ptr<char[]>(new char[capacity]));
+        chunkUsed_ = 0;
+        chunkCapacity_ = capacity;
+        chunkBytes_ += capacity;
+    }
+
+    char* stored = chunks_.back().get() + chunkUsed_;
+    std::memcpy(stored, text.data(), text.size());
+    chunkUsed_ += text.size();
+
+    uint32_t id = static_cast<uint32_t>(strings_.size());
+    std::string_view view(stored, text.size());
+    strings_.push_back(view);
+    ids_.emplace(view, id);
+    return id;
+}
+
+bool StringPool::find(std::string_view text, uint32_t& id) const {
+    auto found = ids_.find(text);
+    if (found == ids_.end()) {
+        return false;
+    }
+    id = found->second;
+    return true;
+}
+
+std::string_view StringPool::get(uint32_t id) const {
+    return strings_[id];
+}
+
+size_t StringPool::size() const {
+    return strings_.size();
+}
+
+size_t StringPool::getByteSize() const {
+    // Each map node holds the entry and a next pointer, plus the cached hash
+    size_t nodeBytes = sizeof(std::pair<const std::string_view, uint32_t>) + 2 * sizeof(void*);
+    return chunkBytes_ +
+           chunks_.capacity() * sizeof(std::unique_ptr<char[]>) +
+           strings_.capacity() * sizeof(std::string_view) +
+           ids_.bucket_count() * sizeof(void*) + ids_.size() * nodeBytes;
+}
+
+std::string_view FileSymbols::getName(const Entry& entry) const {
+    return std::string_view(strings).substr(entry.nameOffset, entry.nameLength);
+}
+
+std::string_view FileSymbols::getDocumentation(const Entry& entry) const {
+    return std::string_view(strings).substr(entry.documentationOffset, entry.documentationLength);
+}
+
+std::string_view FileSymbols::getSignature(const Entry& entry) const {
+    return std::string_view(strings).substr(entry.signatureTextOffset, entry.signatureTextLength);
+}
+
+void FileSymbols::add(std::string_view name, SymbolKind kind, uint32_t lineNumber,
+                      uint32_t signatureOffset, uint32_t signatureLength, std::string_view signature,
+                      std::string_view documentation) {
+    Entry entry;
+    entry.nameOffset = static_cast<uint32_t>(strings.size());
+    entry.nameLength = static_cast<uint32_t>(name.size());
+    strings.append(name.data(), name.size());
+    entry.documentationOffset = static_cast<uint32_t>(strings.size());
+    entry.documentationLength = static_cast<uint32_t>(documentation.size());
+    strings.append(documentation.data(), documentation.size());
+    entry.signatureTextOffset = static_cast<uint32_t>(strings.size());
+    entry.signatureTextLength = static_cast<uint32_t>(signature.size());
+    strings.append(signature.data(), signature.size());
+    entry.signatureOffset = signatureOffset;
+    entry.signatureLength = signatureLength;
+    entry.lineNumber = lineNumber;
+    entry.kind = kind;
+    entries.push_back(entry);
+}
+
+SymbolTable::SymbolTable()
+    : lastFile_(0) {
+}
+
+void SymbolTable::push(uint32_t name, SymbolKind kind, uint32_t file, uint32_t lineNumber,
+                       uint32_t signatureOffset, uint32_t signatureLength, uint32_t documentation) {
+    names_.push_back(name);
+    kinds_.push_back(kind);
+    files_.push_back(file);
+    lineNumbers_.push_back(lineNumber);
+    signatureOffsets_.push_back(signatureOffset);
+    signatureLengths_.push_back(signatureLength);
+    documentation_.push_back(documentation);
+}
+
+void SymbolTable::add(std::string_view name, SymbolKind kind, std::string_view filePath, uint32_t lineNumber,
+                      size_t signatureOffset, size_t signatureLength, std::string_view documentation) {
+    if (strings_.get(lastFile_) != filePath) {
+        lastFile_ = strings_.intern(filePath);
+    }
+    push(strings_.intern(name), kind, lastFile_, lineNumber,
+         static_cast<uint32_t>(signatureOffset), static_cast<uint32_t>(signatureLength),
+         documentation.empty() ? 0 : strings_.intern(documentation));
+}
+
+void SymbolTable::append(const SymbolTable& other, size_t begin, size_t end) {
+    for (size_t i = begin; i < end; i++) {
+        if (strings_.get(lastFile_) != other.getFilePath(i)) {
+            lastFile_ = strings_.intern(other.getFilePath(i));
+        }
+        push(strings_.intern(other.getName(i)), other.kinds_[i], lastFile_, other.lineNumbers_[i],
+             other.signatureOffsets_[i], other.signatureLengths_[i],
+             other.documentation_[i] == 0 ? 0 : strings_.intern(other.getDocumentation(i)));
+    }
+}
+
+void SymbolTable::append(const FileSymbols& symbols, std::string_view filePath) {
+    if (symbols.entries.empty()) {
+        return;
+    }
+    if (strings_.get(lastFile_) != filePath) {
+        lastFile_ = strings_.intern(filePath);
+    }
+    for (const auto& entry : symbols.entries) {
+        push(strings_.intern(symbols.getName(entry)), entry.kind, lastFile_, entry.lineNumber,
+             entry.signatureOffset, entry.signatureLength,
+             entry.documentationLength == 0 ? 0 : strings_.intern(symbols.getDocumentation(entry)));
+    }
+}
+
+FileSymbols SymbolTable::extractFile(size_t begin, size_t end, std::string_view content) const {
+    FileSymbols symbols;
+    symbols.entries.reserve(end - begin);
+    for (size_t i = begin; i < end; i++) {
+        symbols.add(getName(i), kinds_[i], lineNumbers_[i],
+                    signatureOffsets_[i], signatureLengths_[i], getSignature(i, content), getDocumentation(i));
+    }
+    return symbols;
+}
+
+void SymbolTable::removeFiles(const std::function<bool(std::string_view)>& matches) {
+    uint32_t runFile = 0;
+    bool runMatches = false;
+    bool first = true;
+    size_t kept = 0;
+    for (size_t i = 0; i < size(); i++) {
+        if (first || files_[i] != runFile) {
+            runFile = files_[i];
+            runMatches = matches(strings_.get(runFile));
+            first = false;
+        }
+        if (runMatches) {
+            continue;
+        }
+        if (kept != i) {
+            names_[kept] = names_[i];
+            kinds_[kept] = kinds_[i];
+            files_[kept] = files_[i];
+            lineNumbers_[kept] = lineNumbers_[i];
+            signatureOffsets_[kept] = signatureOffsets_[i];
+            signatureLengths_[kept] = signatureLengths_[i];
+            documentation_[kept] = documentation_[i];
+        }
+        kept++;
+    }
+
+    // The pool keeps strings that no symbol uses any more; a full scan
+    // builds a fresh table
+    names_.resize(kept);
+    kinds_.resize(kept);
+    files_.resize(kept);
+    lineNumbers_.resize(kept);
+    signatureOffsets_.resize(kept);
+    signatureLengths_.resize(kept);
+    documentation_.resize(kept);
+}
+
+size_t SymbolTable::size() const {
+    return names_.size();
+}
+
+bool SymbolTable::empty() const {
+    return names_.empty();
+}
+
+void SymbolTable::reserve(size_t count) {
+    names_.reserve(count);
+    kinds_.reserve(count);
+    files_.reserve(count);
+    lineNumbers_.reserve(count);
+    signatureOffsets_.reserve(count);
+    signatureLengths_.reserve(count);
+    documentation_.reserve(count);
+}
+
+std::string_view SymbolTable::getName(size_t symbol) const {
+    return strings_.get(names_[symbol]);
+}
+
+SymbolKind SymbolTable::getKind(size_t symbol) const {
+    return kinds_[symbol];
+}
+
+std::string_view SymbolTable::getType(size_t symbol) const {
+    return symbolKindName(kinds_[symbol]);
+}
+
+std::string_view SymbolTable::getFilePath(size_t symbol) const {
+    return strings_.get(files_[symbol]);
+}
+
+uint32_t SymbolTable::getLineNumber(size_t symbol) const {
+    return lineNumbers_[symbol];
+}
+
+std::string_view SymbolTable::getDocumentation(size_t symbol) const {
+    return strings_.get(documentation_[symbol]);
+}
+
+std::string_view SymbolTable::getSignature(size_t symbol, std::string_view content) const {
+    size_t offset = std::min<size_t>(signatureOffsets_[symbol], content.size());
+    return content.substr(offset, signatureLengths_[symbol]);
+}
+
+uint32_t SymbolTable::getFileId(size_t symbol) const {
+    return files_[symbol];
+}
+
+size_t SymbolTable::getByteSize() const {
+    return strings_.getByteSize() +
+           columnBytes(names_) + columnBytes(kinds_) + columnBytes(files_) +
+           columnBytes(lineNumbers_) + columnBytes(signatureOffsets_) +
+           columnBytes(signatureLengths_) + columnBytes(documentation_);
+}
+
+std::string SymbolTable::getSizeReport() const {
+    size_t legacyBytes = size() * sizeof(LegacySymbol);
+    for (size_t i = 0; i < size(); i++) {
+        legacyBytes += legacyStringBytes(getName(i).size()) +
+                       legacyStringBytes(getType(i).size()) +
+                       legacyStringBytes(getFilePath(i).size()) +
+                       legacyStringBytes(signatureLengths_[i]) +
+                       legacyStringBytes(getDocumentation(i).size());
+    }
+
+    size_t bytes = getByteSize();
+    double count = static_cast<double>(std::max<size_t>(size(), 1));
+    std::stringstream ss;
+    ss << std::fixed << std::setprecision(1)
+       << size() << " symbols, " << strings_.size() << " distinct strings, "
+       << bytes << " bytes (" << (static_cast<double>(bytes) / count) << " per symbol); as SymbolInfo structs "
+       << legacyBytes << " bytes (" << (static_cast<double>(legacyBytes) / count) << " per symbol)";
+    return ss.str();
+}
+
+}} // namespace codelve::scanner
@@ -0,0 +1,259 @@
+// File: codelve/src/scanner/symbol_table.h
+#pragma once
+#include <string>
+#include <string_view>
+#include <vector>
+#include <memory>
+#include <functional>
+#include <unordered_map>
+#include <cstddef>
+#include <cstdint>
+
+namespace codelve {
+namespace scanner {
+
+/**
+ * What a symbol is. Parsers report these as the type names below, which
+ * is also how they are shown and saved.
+ */
+enum class SymbolKind : uint8_t {
+    Include,        // "include"
+    Import,         // "import"
+    Namespace,      // "namespace"
+    Class,          // "class"
+    Struct,         // "struct"
+    Interface,      // "interface"
+    Enum,           // "enum"
+    Type,           // "type"
+    Function,       // "function"
+    Method,         // "method"
+    Export,         // "export"
+    Decorator,      // "decorator"
+    Comment,        // "comment"
+    Constant,       // "constant"
+    Other,          // "other", for any type name not listed above
+    Count
+};
+
+/**
+ * Map a type name to its kind.
+ * @param name Type name, e.g. "function"
+ * @return The kind, or SymbolKind::Other if the name is not known
+ */
+SymbolKind symbolKindFromName(std::string_view name);
+
+/**
+ * Get the type name of a kind.
+ * @param kind The kind
+ * @return Type name, e.g. "function"
+ */
+std::string_view symbolKindName(SymbolKind kind);
+
+/**
+ * Append-only set of distinct strings with dense 32-bit ids.
+ *
+ * Strings are packed into large chunks that never move, so views returned
+ * by get() stay valid for the life of the pool. Id 0 is the empty string.
+ */
+class StringPool {
+public:
+    StringPool();
+    StringPool(const StringPool& other);
+    StringPool& operator=(const StringPool& other);
+    StringPool(StringPool&& other);
+    StringPool& operator=(StringPool&& other);
+
+    /**
+     * Get the id of a string, adding it if it is not in the pool yet.
+     * @param text The string
+     * @return Its id
+     */
+    uint32_t intern(std::string_view text);
+
+    /**
+     * Look up a string without adding it.
+     * @param text The string
+     * @param id Receives its id
+     * @return true if the string is in the pool
+     */
+    bool find(std::string_view text, uint32_t& id) const;
+
+    /**
+     * Get a string by id.
+     * @param id Id returned by intern()
+     * @return The string
+     */
+    std::string_view get(uint32_t id) const;
+
+    /**
+     * Get the number of distinct strings, including the empty string.
+     * @return String count
+     */
+    size_t size() const;
+
+    /**
+     * Get the memory held by the pool, including its lookup table.
+     * @return Bytes
+     */
+    size_t getByteSize() const;
+
+private:
+    // Strings longer than a chunk get a chunk of their own
+    static const size_t kChunkSize = 64 * 1024;
+
+    std::vector<std::unique_ptr<char[]>> chunks_;
+    size_t chunkUsed_;
+    size_t chunkCapacity_;
+    size_t chunkBytes_;
+    std::vector<std::string_view> strings_;
+    std::unordered_map<std::string_view, uint32_t> ids_;
+
+    void clear();
+};
+
+/**
+ * The symbols of one file, detached from any table. Kept with the file's
+ * manifest record so an unchanged file, or another file with the same
+ * contents, gets its symbols back without being parsed. Names,
+ * documentation and signature text are packed into one buffer; the
+ * signature's byte range of the file contents is kept too, for a
+ * SymbolTable. With the text at hand, saving an index reads no file.
+ */
+struct FileSymbols {
+    struct Entry {
+        uint32_t nameOffset;
+        uint32_t nameLength;
+        uint32_t documentationOffset;
+        uint32_t documentationLength;
+        uint32_t signatureTextOffset;
+        uint32_t signatureTextLength;
+        uint32_t signatureOffset;
+        uint32_t signatureLength;
+        uint32_t lineNumber;
+        SymbolKind kind;
+    };
+
+    std::string strings;
+    std::vector<Entry> entries;
+
+    std::string_view getName(const Entry& entry) const;
+    std::string_view getDocumentation(const Entry& entry) const;
+    std::string_view getSignature(const Entry& entry) const;
+
+    /**
+     * Append a symbol.
+     */
+    void add(std::string_view name, SymbolKind kind, uint32_t lineNumber,
+             uint32_t signatureOffset, uint32_t signatureLength, std::string_view signature,
+             std::string_view documentation);
+};
+
+/**
+ * Every symbol of an index, one column per field.
+ *
+ * Names, file paths and documentation are interned in a string pool and
+ * stored as 32-bit ids, the type is a one-byte SymbolKind, and the
+ * signature is an offset and length into the file's contents rather than
+ * a copy. Adding a symbol allocates nothing once the columns have grown,
+ * and a scan over one field touches only that field's column.
+ */
+class SymbolTable {
+public:
+    SymbolTable();
+
+    /**
+     * Append a symbol.
+     * @param name Symbol name
+     * @param kind Symbol kind
+     * @param filePath File the symbol is in
+     * @param lineNumber 1-based line of the symbol
+     * @param signatureOffset Byte offset of the signature in the file contents
+     * @param signatureLength Byte length of the signature
+     * @param documentation Documentation text, if any
+     */
+    void add(std::string_view name, SymbolKind kind, std::string_view filePath, uint32_t lineNumber,
+             size_t signatureOffset, size_t signatureLength, std::string_view documentation = std::string_view());
+
+    /**
+     * Append symbols [begin, end) of another table.
+     */
+    void append(const SymbolTable& other, size_t begin, size_t end);
+
+    /**
+     * Append a file's detached symbols under the given path.
+     */
+    void append(const FileSymbols& symbols, std::string_view filePath);
+
+    /**
+     * Copy symbols [begin, end), which must all be in one file, out of the table.
+     * @param content Contents of that file, for the signature text
+     * @return The symbols, without their file
+     */
+    FileSymbols extractFile(size_t begin, size_t end, std::string_view content) const;
+
+    /**
+     * Remove the symbols of every file the predicate matches. A file's
+     * symbols are contiguous, so it is called once per run of symbols.
+     * @param matches Called with a file path
+     */
+    void removeFiles(const std::function<bool(std::string_view)>& matches);
+
+    size_t size() const;
+    bool empty() const;
+    void reserve(size_t count);
+
+    std::string_view getName(size_t symbol) const;
+    SymbolKind getKind(size_t symbol) const;
+    std::string_view getType(size_t symbol) const;
+    std::string_view getFilePath(size_t symbol) const;
+    uint32_t getLineNumber(size_t symbol) const;
+    std::string_view getDocumentation(size_t symbol) const;
+
+    /**
+     * Get a symbol's signature.
+     * @param symbol Symbol index
+     * @param content Contents of the symbol's file
+     * @return View into the contents
+     */
+    std::string_view getSignature(size_t symbol, std::string_view content) const;
+
+    /**
+     * Get a symbol's file as an id, equal for all symbols of one file.
+     * @param symbol Symbol index
+     * @return File id
+     */
+    uint32_t getFileId(size_t symbol) const;
+
+    /**
+     * Get the memory held by the table.
+     * @return Bytes
+     */
+    size_t getByteSize() const;
+
+    /**
+     * Describe the table's memory use next to what the same symbols took as
+     * one struct of five std::strings each, the layout this table replaced.
+     * @return One line for the log
+     */
+    std::string getSizeReport() const;
+
+private:
+    StringPool strings_;
+
+    // One entry per symbol in each column
+    std::vector<uint32_t> names_;
+    std::vector<uint32_t> files_;
+    std::vector<uint32_t> lineNumbers_;
+    std::vector<uint32_t> signatureOffsets_;
+    std::vector<uint32_t> signatureLengths_;
+    std::vector<uint32_t> documentation_;
+    std::vector<SymbolKind> kinds_;
+
+    // Symbols arrive a file at a time; skip re-interning the same path
+    uint32_t lastFile_;
+
+    void push(uint32_t name, SymbolKind kind, uint32_t file, uint32_t lineNumber,
+              uint32_t signatureOffset, uint32_t signatureLength, uint32_t documentation);
+};
+
+}} // namespace codelve::scanner
@@ -0,0 +1,92 @@
+// File: codelve/src/utils/channel.h
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+
+namespace codelve {
+namespace utils {
+
+/**
+ * Unbounded first-in, first-out queue between producer and consumer threads.
+ * Any number of threads may push; once the channel is closed, consumers
+ * drain what is left and then see the end.
+ */
+template <typename T>
+class Channel {
+public:
+    Channel() : closed_(false) {
+    }
+
+    /**
+     * Queue an item. Items pushed after close() are dropped.
+     * @param item The item
+     * @return false if the channel is closed
+     */
+    bool push(T item) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (closed_) {
+                return false;
+            }
+            items_.push_back(std::move(item));
+        }
+        ready_.notify_one();
+        return true;
+    }
+
+    /**
+     * Take the oldest item, waiting for one if the channel is empty.
+     * @param item Receives the item
+     * @return false once the channel is closed and empty
+     */
+    bool pop(T& item) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        ready_.wait(lock, [this]() { return closed_ || !items_.empty(); });
+        if (items_.empty()) {
+            return false;
+        }
+        item = std::move(items_.front());
+        items_.pop_front();
+        return true;
+    }
+
+    /**
+     * Take the oldest item if there is one, without waiting.
+     * @param item Receives the item
+     * @return false if the channel is empty
+     */
+    bool tryPop(T& item) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (items_.empty()) {
+            return false;
+        }
+        item = std::move(items_.front());
+        items_.pop_front();
+        return true;
+    }
+
+    /**
+     * Refuse further items and wake every waiting consumer.
+     */
+    void close() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            closed_ = true;
+        }
+        ready_.notify_all();
+    }
+
+private:
+    // Prevent copying
+    Channel(const Channel&) = delete;
+    Channel& operator=(const Channel&) = delete;
+
+    std::deque<T> items_;
+    bool closed_;
+    std::mutex mutex_;
+    std::condition_variable ready_;
+};
+
+}} // namespace codelve::utils
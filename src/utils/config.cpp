@@ -4,6 +4,9 @@
 #include <fstream>
 #include <iostream>
 #include <stdexcept>
+#include <climits>
+#include <cstdlib>
+#include <cerrno>
 
 // For now, we'll use a simple implementation.
 // Later, we'll integrate a JSON library like nlohmann/json
@@ -11,6 +14,52 @@
 namespace codelve {
 namespace utils {
 
+namespace {
+    std::string trim(const std::string& text) {
+        size_t begin = text.find_first_not_of(" \t\r");
+        if (begin == std::string::npos) {
+            return "";
+        }
+        size_t end = text.find_last_not_of(" \t\r");
+        return text.substr(begin, end - begin + 1);
+    }
+    
+    // Values read from the file are kept as text and converted when asked for
+    bool parseInt(const std::string& text, int& value) {
+        char* end = nullptr;
+        errno = 0;
+        long parsed = std::strtol(text.c_str(), &end, 10);
+        if (text.empty() || *end != '\0' || errno == ERANGE || 
+            parsed < INT_MIN || parsed > INT_MAX) {
+            return false;
+        }
+        value = static_cast<int>(parsed);
+        return true;
+    }
+    
+    bool parseBool(const std::string& text, bool& value) {
+        if (text == "true" || text == "1" || text == "yes" || text == "on") {
+            value = true;
+            return true;
+        }
+        if (text == "false" || text == "0" || text == "no" || text == "off") {
+            value = false;
+            return true;
+        }
+        return false;
+    }
+    
+    bool parseDouble(const std::string& text, double& value) {
+        char* end = nullptr;
+        double parsed = std::strtod(text.c_str(), &end);
+        if (text.empty() || *end != '\0') {
+            return false;
+        }
+        value = parsed;
+        return true;
+    }
+}
+
 Config::Config(const std::string& configFile)
     : configFile_(configFile) {
     LOG_INFO("Config created for file: " + configFile);
@@ -24,8 +73,7 @@ bool Config::load() {
     LOG_INFO("Loading configuration from: " + configFile_);
     
     try {
-        // For now, we'll use default values since we don't have a JSON parser yet
-        // We'll update this implementation later
+        // Defaults, which the file overrides
         
         // Default application settings
         data_["app.name"] = std::string("CodeLve");
@@ -49,7 +97,43 @@ bool Config::load() {
         data_["scanner.ignore_dirs"] = std::vector<std::string>{".git", "node_modules", "build", "bin", "obj"};
         data_["scanner.supported_extensions"] = std::vector<std::string>{".c", ".cpp", ".h", ".hpp", ".cs", ".js", ".ts", ".py", ".java"};
         
-        LOG_INFO("Configuration loaded with default values");
+        std::ifstream file(configFile_);
+        if (!file) {
+            LOG_INFO("Configuration loaded with default values");
+            return true;
+        }
+        
+        // "key=value" lines under "[section]" headers set "section.key";
+        // "#" starts a comment at the start of a line or after a blank
+        std::string section;
+        std::string line;
+        int lineNumber = 0;
+        while (std::getline(file, line)) {
+            lineNumber++;
+            for (size_t hash = line.find('#'); hash != std::string::npos; hash = line.find('#', hash + 1)) {
+                if (hash == 0 || line[hash - 1] == ' ' || line[hash - 1] == '\t') {
+                    line.erase(hash);
+                    break;
+                }
+            }
+            line = trim(line);
+            if (line.empty()) {
+                continue;
+            }
+            if (line.front() == '[' && line.back() == ']') {
+                section = trim(line.substr(1, line.size() - 2));
+                continue;
+            }
+            size_t equals = line.find('=');
+            if (equals == std::string::npos) {
+                LOG_WARNING("Ignoring line " + std::to_string(lineNumber) + " of " + configFile_ + ": " + line);
+                continue;
+            }
+            std::string key = trim(line.substr(0, equals));
+            data_[section.empty() ? key : section + "." + key] = trim(line.substr(equals + 1));
+        }
+        
+        LOG_INFO("Configuration loaded from file");
         return true;
     }
     catch (const std::exception& e) {
@@ -88,6 +172,11 @@ std::string Config::getString(const std::string& key, const std::string& default
 
 int Config::getInt(const std::string& key, int defaultValue) const {
     if (hasKey(key)) {
+        const std::string* text = std::any_cast<std::string>(&data_.at(key));
+        int value;
+        if (text && parseInt(*text, value)) {
+            return value;
+        }
         try {
             return std::any_cast<int>(data_.at(key));
         }
@@ -100,6 +189,11 @@ int Config::getInt(const std::string& key, int defaultValue) const {
 
 bool Config::getBool(const std::string& key, bool defaultValue) const {
     if (hasKey(key)) {
+        const std::string* text = std::any_cast<std::string>(&data_.at(key));
+        bool value;
+        if (text && parseBool(*text, value)) {
+            return value;
+        }
         try {
             return std::any_cast<bool>(data_.at(key));
         }
@@ -112,6 +206,11 @@ bool Config::getBool(const std::string& key, bool defaultValue) const {
 
 double Config::getDouble(const std::string& key, double defaultValue) const {
     if (hasKey(key)) {
+        const std::string* text = std::any_cast<std::string>(&data_.at(key));
+        double value;
+        if (text && parseDouble(*text, value)) {
+            return value;
+        }
         try {
             return std::any_cast<double>(data_.at(key));
         }
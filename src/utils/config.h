@@ -12,7 +12,7 @@ namespace utils {
 
 /**
  * Configuration class for handling application settings.
- * Loads settings from JSON files and provides access to them.
+ * Loads settings from an INI-style file and provides access to them.
  */
 class Config {
 public:
@@ -28,7 +28,9 @@ public:
     ~Config();
     
     /**
-     * Load configuration from file.
+     * Load configuration from file: the defaults, then "key=value" lines
+     * under "[section]" headers, which set "section.key". A missing file
+     * leaves the defaults.
      * @return true if loading was successful, false otherwise
      */
     bool load();
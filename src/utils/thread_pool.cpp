@@ -0,0 +1,150 @@
+// File: codelve/src/utils/thread_pool.cpp
+#include "utils/thread_pool.h"
+#include "utils/logger.h"
+#include <exception>
+#include <string>
+
+namespace codelve {
+namespace utils {
+
+namespace {
+    // Identifies the pool and worker the current thread belongs to, so tasks
+    // submitted from inside a task land on the submitting worker's deque.
+    thread_local const WorkStealingPool* currentPool = nullptr;
+    thread_local size_t currentWorker = 0;
+}
+
+WorkStealingPool::WorkStealingPool(size_t threadCount)
+    : queued_(0),
+      pending_(0),
+      nextQueue_(0),
+      stopping_(false) {
+    if (threadCount == 0) {
+        threadCount = 1;
+    }
+
+    for (size_t i = 0; i < threadCount; i++) {
+        queues_.push_back(std::make_unique<WorkerQueue>());
+    }
+
+    for (size_t i = 0; i < threadCount; i++) {
+        workers_.emplace_back(&WorkStealingPool::workerLoop, this, i);
+    }
+}
+
+WorkStealingPool::~WorkStealingPool() {
+    wait();
+
+    {
+        std::lock_guard<std::mutex> lock(signalMutex_);
+        stopping_ = true;
+    }
+    workAvailable_.notify_all();
+
+    for (auto& worker : workers_) {
+        if (worker.joinable()) {
+            worker.join();
+        }
+    }
+}
+
+void WorkStealingPool::submit(Task task) {
+    size_t target;
+    if (currentPool == this) {
+        target = currentWorker;
+    } else {
+        target = nextQueue_.fetch_add(1, std::memory_order_relaxed) % queues_.size();
+    }
+
+    pending_.fetch_add(1);
+    {
+        // Count the task before it becomes visible so the counter never dips
+        // below zero, and do it under the signal lock so a worker about to
+        // sleep cannot miss the wakeup
+        std::lock_guard<std::mutex> lock(signalMutex_);
+        queued_.fetch_add(1);
+    }
+    {
+        std::lock_guard<std::mutex> lock(queues_[target]->mutex);
+        queues_[target]->tasks.push_back(std::move(task));
+    }
+    workAvailable_.notify_one();
+}
+
+void WorkStealingPool::wait() {
+    std::unique_lock<std::mutex> lock(signalMutex_);
+    allDone_.wait(lock, [this]() { return pending_.load() == 0; });
+}
+
+size_t WorkStealingPool::size() const {
+    return workers_.size();
+}
+
+size_t WorkStealingPool::resolveThreadCount(int configured) {
+    if (configured > 0) {
+        return static_cast<size_t>(configured);
+    }
+
+    unsigned int cores = std::thread::hardware_concurrency();
+    return cores > 0 ? cores : 1;
+}
+
+bool WorkStealingPool::takeTask(size_t index, Task& task) {
+    // Own deque first, newest task (its data is most likely still cached)
+    {
+        WorkerQueue& own = *queues_[index];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.tasks.empty()) {
+            task = std::move(own.tasks.back());
+            own.tasks.pop_back();
+            return true;
+        }
+    }
+
+    // Steal the oldest task from the other workers
+    for (size_t offset = 1; offset < queues_.size(); offset++) {
+        WorkerQueue& victim = *queues_[(index + offset) % queues_.size()];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.tasks.empty()) {
+            task = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void WorkStealingPool::workerLoop(size_t index) {
+    currentPool = this;
+    currentWorker = index;
+
+    while (true) {
+        Task task;
+        if (takeTask(index, task)) {
+            queued_.fetch_sub(1);
+
+            try {
+                task(index);
+            } catch (const std::exception& e) {
+                Logger::log(LogLevel::ERROR, "WorkStealingPool: Task failed: " + std::string(e.what()));
+            } catch (...) {
+                Logger::log(LogLevel::ERROR, "WorkStealingPool: Task failed with unknown exception");
+            }
+
+            if (pending_.fetch_sub(1) == 1) {
+                std::lock_guard<std::mutex> lock(signalMutex_);
+                allDone_.notify_all();
+            }
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(signalMutex_);
+        workAvailable_.wait(lock, [this]() { return stopping_ || queued_.load() > 0; });
+        if (stopping_ && queued_.load() == 0) {
+            return;
+        }
+    }
+}
+
+}} // namespace codelve::utils
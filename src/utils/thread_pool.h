@@ -0,0 +1,98 @@
+// File: codelve/src/utils/thread_pool.h
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace codelve {
+namespace utils {
+
+/**
+ * Fixed-size thread pool with one task deque per worker.
+ * Workers pop their own deque from the back and steal from the front of
+ * other workers' deques when they run dry, so uneven task costs (a few
+ * huge files among many small ones) still keep every core busy.
+ */
+class WorkStealingPool {
+public:
+    /**
+     * Task signature. The argument is the index of the worker running the
+     * task, in [0, size()), which callers can use to address per-worker state.
+     */
+    using Task = std::function<void(size_t workerIndex)>;
+
+    /**
+     * Constructor.
+     * @param threadCount Number of worker threads (at least one is created)
+     */
+    explicit WorkStealingPool(size_t threadCount);
+
+    /**
+     * Destructor. Waits for queued tasks to finish and joins the workers.
+     */
+    ~WorkStealingPool();
+
+    /**
+     * Queue a task. When called from one of this pool's workers the task is
+     * pushed onto that worker's own deque, otherwise deques are filled
+     * round-robin.
+     * @param task The task to run
+     */
+    void submit(Task task);
+
+    /**
+     * Block until every submitted task has completed.
+     */
+    void wait();
+
+    /**
+     * Get the number of worker threads.
+     * @return Worker count
+     */
+    size_t size() const;
+
+    /**
+     * Resolve a configured thread count, where 0 or less means "one per core".
+     * @param configured Value from configuration
+     * @return Thread count to use, at least 1
+     */
+    static size_t resolveThreadCount(int configured);
+
+private:
+    // Prevent copying
+    WorkStealingPool(const WorkStealingPool&) = delete;
+    WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+    struct WorkerQueue {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    std::vector<std::unique_ptr<WorkerQueue>> queues_;
+    std::vector<std::thread> workers_;
+
+    // Tasks sitting in a deque, used to put idle workers to sleep
+    std::atomic<size_t> queued_;
+
+    // Tasks submitted but not yet finished
+    std::atomic<size_t> pending_;
+
+    std::atomic<size_t> nextQueue_;
+    bool stopping_;
+
+    std::mutex signalMutex_;
+    std::condition_variable workAvailable_;
+    std::condition_variable allDone_;
+
+    void workerLoop(size_t index);
+    bool takeTask(size_t index, Task& task);
+};
+
+}} // namespace codelve::utils